@@ -4,7 +4,10 @@
  * The Accelerometer library contains an assortment of functions to communicate
  * and gain acceleration values from the LIS3DH accelerometer using a
  * PIC24FJ64GA002 accelerometer. The library uses the I2C1 module of the
- * microcontroller. Ensure that this module is not being used elsewhere.
+ * microcontroller through the interrupt-driven I2C library (or the SPI1 module
+ * through the AccelerometerSPI library when ACCEL_USE_SPI is 1), and the
+ * MotionDetector library to detect movement. Ensure that this module is not
+ * being used elsewhere.
  * To use this library, connect the SDA1/SCL1 pins of the microcontroller to the
  * SDA/SCL pins of the LIS3DH. Connect the SDO pin of the LIS3DH to ground, and
  * the CS pin of the LIS3DH to Vdd. Connect both pins to a 10k? pull up resistor.
@@ -17,6 +20,23 @@
 
 #include "xc.h"
 #include "stdint.h"
+#include "I2C.h"
+#include "MotionDetector.h"
+#include "Accelerometer.h"
+
+// Bus backend: both libraries take the same transaction descriptors
+#if ACCEL_USE_SPI
+#include "AccelerometerSPI.h"
+#define initBus() initAccelerometerSPI()
+#define submitTransaction(t) submitSPITransaction(t)
+#define runTransaction(t) runSPITransaction(t)
+#define isBusIdle() isSPIIdle()
+#else
+#define initBus() initI2C()
+#define submitTransaction(t) submitI2CTransaction(t)
+#define runTransaction(t) runI2CTransaction(t)
+#define isBusIdle() isI2CIdle()
+#endif
 
 #define STATUS_REG_AUX 0x07
 #define OUT_ADC1_L 0x08
@@ -44,50 +64,137 @@
 #define OUT_Z_H 0x2D
 #define FIFO_CTRL_REG 0x2E
 #define FIFO_SRC_REG 0x2F
+#define INT1_CFG 0x30
+#define INT1_SRC 0x31
 #define INT1_THS 0x32
-#define INT1_CFG 0x38
+#define INT1_DURATION 0x33
+#define CLICK_CFG 0x38
 #define DEVICE_ADDRESS 0x30
+#define AUTO_INCREMENT 0x80 // MSB of the sub-address enables auto-increment
+#define BOOT 0x80 // CTRL_REG5 bit rebooting the memory content
+#define SHADOW_SIZE 10 // number of configuration registers mirrored in RAM
+#define FIFO_EN 0x40 // CTRL_REG5 bit enabling the 32-level FIFO
+#define I1_WTM 0x04 // CTRL_REG3 bit routing the FIFO watermark to INT1
+#define I1_IA1 0x40 // CTRL_REG3 bit routing interrupt activity 1 to INT1
+#define LIR_INT1 0x08 // CTRL_REG5 bit latching INT1 until INT1_SRC is read
+#define FIFO_MODE_STREAM 0x80 // FIFO_CTRL_REG FM bits for stream mode
+#define FIFO_SIZE 32 // number of samples the FIFO holds
+#define FSS_MASK 0x1F // FIFO_SRC_REG bits holding the number of unread samples
+#define I1_ZYXDA 0x10 // CTRL_REG3 bit routing new data ready to INT1
+#define BDU 0x80 // CTRL_REG4 bit blocking output updates until both bytes are read
+#define HR 0x08 // CTRL_REG4 bit selecting the 12-bit high-resolution mode
+#define GOVERNOR_PRE_THRESHOLD 10000UL // (100 mg)^2, steps idle up to suspicious
+#define GOVERNOR_QUIET_SAMPLES 200 // samples below it before stepping back down
 
 // Function declarations
 void initAccelerometer();
-int accel_read(uint8_t address);
+uint8_t accel_read(uint8_t address);
 void accel_write(uint8_t address, uint8_t data);
+void accel_read_burst(uint8_t address, uint8_t *data, uint8_t length);
+void accel_set(uint8_t address, uint8_t data);
+uint8_t accel_get(uint8_t address);
+void accel_flush();
+int shadowIndex(uint8_t address);
+void resetShadow();
 int getXAcceleration();
 int getYAcceleration();
 int getZAcceleration();
+void getAcceleration3(int16_t *x, int16_t *y, int16_t *z);
 int movementDetected();
+void resetMovementDetection();
+void initAccelerometerStream(uint8_t watermark);
+void stopAccelerometerStream();
+void initAccelerometerWake();
+void stopAccelerometerWake();
+void initAccelerometerGovernor();
+void stopAccelerometerGovernor();
+void setAccelerometerTier(int tier);
+int getAccelerometerTier();
+void mapInterruptPin();
+int sampleMovement(const uint8_t *raw);
+void fifoSourceComplete(I2CTransaction *transaction);
+void fifoDataComplete(I2CTransaction *transaction);
+void governorSampleComplete(I2CTransaction *transaction);
+void __attribute__((__interrupt__, __auto_psv__)) _INT1Interrupt();
 void delay_ms_accel(unsigned int ms);
 
+// Configuration registers mirrored in RAM, in address order, with their
+// power-on values. accel_flush() writes each run of consecutive addresses
+// (CTRL_REG1-CTRL_REG6, FIFO_CTRL_REG, INT1_CFG, INT1_THS-INT1_DURATION) that
+// holds a changed register with one auto-increment write
+const uint8_t shadowRegisters[SHADOW_SIZE] = {CTRL_REG1, CTRL_REG2, CTRL_REG3,
+    CTRL_REG4, CTRL_REG5, CTRL_REG6, FIFO_CTRL_REG, INT1_CFG, INT1_THS,
+    INT1_DURATION};
+const uint8_t shadowDefaults[SHADOW_SIZE] = {0x07, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00};
+uint8_t shadow[SHADOW_SIZE];
+uint16_t shadowDirty = 0; // bit i is set when shadow[i] is not on the sensor yet
+
+// Burst read of the six axis output registers that movementDetected() keeps
+// running in the background
+uint8_t sampleData[6];
+I2CTransaction sampleTransaction = {DEVICE_ADDRESS, OUT_X_L | AUTO_INCREMENT, 1, 6,
+    sampleData, I2C_STATUS_IDLE, 0};
+
+// Stream mode: on a watermark interrupt FIFO_SRC_REG is read to learn how many
+// samples are waiting, then all of them are drained with one burst read
+volatile int streamMode = 0;
+volatile int streamMovement = 0; // set when a drained block contained movement
+uint8_t fifoSource;
+uint8_t fifoData[FIFO_SIZE * 6];
+I2CTransaction fifoSourceTransaction = {DEVICE_ADDRESS, FIFO_SRC_REG, 1, 1,
+    &fifoSource, I2C_STATUS_IDLE, fifoSourceComplete};
+I2CTransaction fifoDataTransaction = {DEVICE_ADDRESS, OUT_X_L | AUTO_INCREMENT, 1, 0,
+    fifoData, I2C_STATUS_IDLE, fifoDataComplete};
+
+// Wake mode: the LIS3DH raises INT1 on motion (interrupt activity 1) and the
+// latched event is released by reading INT1_SRC
+volatile int wakeMode = 0;
+volatile int motionWake = 0; // set by the INT1 interrupt in wake mode
+uint8_t int1Source;
+I2CTransaction int1SourceTransaction = {DEVICE_ADDRESS, INT1_SRC, 1, 1,
+    &int1Source, I2C_STATUS_IDLE, 0};
+
+// Governor: the LIS3DH raises INT1 on every new sample (data ready) and the
+// output data rate follows the threat level. In the idle tier the sensor runs
+// in 8-bit low-power mode and only OUT_X_H to OUT_Z_H are read (5 bytes, the
+// L bytes in between are skipped); the other tiers read all six bytes
+const uint8_t tierRate[3] = {0x2F, 0x57, 0x77}; // CTRL_REG1: 10 Hz LP, 100, 400 Hz
+const uint8_t tierResolution[3] = {0x00, BDU, BDU | HR}; // CTRL_REG4 BDU and HR
+volatile int governorMode = 0;
+volatile int governorMovement = 0; // set when a sample contained movement
+volatile int governorTier = ACCEL_TIER_ALARM; // tier the LIS3DH is running at
+volatile int requestedTier = ACCEL_TIER_ALARM; // tier asked for by the governor
+volatile unsigned int quietSamples = 0;
+uint8_t governorData[6];
+I2CTransaction governorTransaction = {DEVICE_ADDRESS, OUT_X_L | AUTO_INCREMENT, 1, 6,
+    governorData, I2C_STATUS_IDLE, governorSampleComplete};
+
 /**
- * Initializes the accelerometer by initializing the I2C1 module of the
- * microcontroller, and sending commands to initialize the LIS3DH.
+ * Initializes the accelerometer by initializing the I2C library (or the
+ * AccelerometerSPI library when ACCEL_USE_SPI is 1), and sending commands to
+ * initialize the LIS3DH.
  */
 void initAccelerometer() {
-    CLKDIVbits.RCDIV = 0; // 16MHz instruction clock
-    // Note: SDA1/SCL1 are not analog pins; don't need to set to digital mode
-    TRISBbits.TRISB8 = 0;
-    TRISBbits.TRISB9 = 0;
-    /**Initialize I2C*/
-    
-    // Initially turn off I2C when setting baud rate generator
-    I2C1CONbits.I2CEN = 0;
-    IFS1bits.MI2C1IF = 0; // Turn off interrupt
-    
-    I2C1BRG = 157; // Fscl = 100KHz
-    I2C1CONbits.I2CEN = 1; // Turn on I2C
+    initBus();
+    initMotionDetector();
     
     // Send commands to initialize the LIS3DH. Refer to P.13 of manual
     delay_ms_accel(100);
-    accel_write(CTRL_REG5, 0b10000000); // reboot memory content
+    accel_write(CTRL_REG5, BOOT); // reboot memory content
     delay_ms_accel(100);
     accel_write(CTRL_REG5, 0x00);
     delay_ms_accel(100);
-    accel_write(CTRL_REG1, 0x77);
-    accel_write(CTRL_REG2, 0x01);
-    accel_write(CTRL_REG3, 0x40);
-    accel_write(CTRL_REG4, 0x84);
-    accel_write(INT1_THS, 0x20);
-    accel_write(INT1_CFG, 0x2A);
+    resetShadow(); // the reboot restored the power-on values
+    
+    accel_set(CTRL_REG1, 0x77);
+    accel_set(CTRL_REG2, 0x01);
+    accel_set(CTRL_REG3, I1_IA1);
+    accel_set(CTRL_REG4, 0x84);
+    accel_set(INT1_THS, 0x20);
+    accel_set(INT1_CFG, 0x2A);
+    accel_flush(); // three writes: CTRL_REG1-CTRL_REG4 in one burst, then INT1_CFG
+                   // and INT1_THS on their own (INT1_SRC sits between them)
 }
 
 /**
@@ -95,36 +202,17 @@ void initAccelerometer() {
  * Register Mapping (p. 31) of the LIS3DH datasheet manual for specific register
  * addresses.
  * @return 8-bit value corresponding to the value read from the input address
- * register of the LIS3DH
- */
-int accel_read(uint8_t address) {
-    I2C1CONbits.SEN = 1; // initialize start condition
-    while(I2C1CONbits.SEN == 1); // wait for start bit to be sent
-    IFS1bits.MI2C1IF = 0; // Clear interrupt flag
-    I2C1TRN = DEVICE_ADDRESS; // 8 bits. consists of slave address (0b00110001) and
-    // the last bit for writing (0)
-    while(IFS1bits.MI2C1IF == 0); // wait for interrupt flag
-    IFS1bits.MI2C1IF = 0;
-    I2C1TRN = address; // data register byte
-    while(IFS1bits.MI2C1IF == 0); // wait for interrupt flag
-    IFS1bits.MI2C1IF = 0;
-    I2C1TRN = DEVICE_ADDRESS | 0x01; // 8 bits. consists of slave address (0b00110001) and
-    // the last bit for reading (1)
-    while(IFS1bits.MI2C1IF == 0); // wait for interrupt flag
-    I2C1CONbits.SEN = 1; // initialize start condition
-    while(I2C1CONbits.SEN == 1); // wait for start bit to be sent
-    IFS1bits.MI2C1IF = 0; // Clear interrupt flag
-    I2C1TRN = DEVICE_ADDRESS | 0x01; // 8 bits. consists of slave address (0b00110001) and
-    // the last bit for reading (1)
-    while(IFS1bits.MI2C1IF == 0); // wait for interrupt flag
-    I2C1CONbits.RCEN = 1; // Enable receive mode
-    while(I2C1STATbits.RBF == 0); // wait for interrupt flag
-    IFS1bits.MI2C1IF = 0;
-    I2C1CONbits.ACKDT = 0; // Send ACK
-    int retVal = I2C1RCV;
-    I2C1CONbits.PEN = 1; // stop bit
-    while(I2C1CONbits.PEN == 1); // wait for stop bit to be sent
-    return retVal;
+ * register of the LIS3DH. Configuration registers mirrored by accel_set() are
+ * returned from RAM without a bus transaction
+ */
+uint8_t accel_read(uint8_t address) {
+    int index = shadowIndex(address);
+    if(index >= 0) { // configuration register: served from the shadow
+        return shadow[index];
+    }
+    uint8_t data = 0;
+    accel_read_burst(address, &data, 1);
+    return data;
 }
 
 /**
@@ -134,21 +222,115 @@ int accel_read(uint8_t address) {
  * @param data 8-bit value to write in the specified register address
  */
 void accel_write(uint8_t address, uint8_t data) {
-    I2C1CONbits.SEN = 1; // initialize start condition
-    while(I2C1CONbits.SEN == 1); // wait for start bit to be sent
-    IFS1bits.MI2C1IF = 0; // Clear interrupt flag
-    I2C1TRN = DEVICE_ADDRESS; // 8 bits. consists of slave address (0b00110001) and
-    // the last bit for write (0)
-    while(IFS1bits.MI2C1IF == 0); // wait for interrupt flag
-    IFS1bits.MI2C1IF = 0;
-    I2C1TRN = address; // data register byte
-    while(IFS1bits.MI2C1IF == 0); // wait for interrupt flag
-    IFS1bits.MI2C1IF = 0;
-    I2C1TRN = data; // data to be sent
-    while(IFS1bits.MI2C1IF == 0); // wait for interrupt flag
-    IFS1bits.MI2C1IF = 0;
-    I2C1CONbits.PEN = 1; // stop bit
-    while(I2C1CONbits.PEN == 1); // wait for stop bit to be sent
+    int index = shadowIndex(address);
+    if(index >= 0) {
+        shadow[index] = data;
+        shadowDirty &= ~(1 << index);
+    }
+    I2CTransaction t = {DEVICE_ADDRESS, address, 0, 1, &data, I2C_STATUS_IDLE, 0};
+    runTransaction(&t);
+}
+
+/**
+ * Reads length consecutive registers of the LIS3DH in a single I2C transaction.
+ * The auto-increment bit is set on the register address, so the LIS3DH
+ * advances to the next register after each byte. Every byte but the last one
+ * is acknowledged (ACK); the last byte is answered with a NACK before the stop
+ * bit so the LIS3DH releases the bus.
+ * @param address the first register in the LIS3DH to read
+ * @param data buffer that receives length bytes, in register order
+ * @param length number of registers to read (at least 1)
+ */
+void accel_read_burst(uint8_t address, uint8_t *data, uint8_t length) {
+    I2CTransaction t = {DEVICE_ADDRESS, address | AUTO_INCREMENT, 1, length,
+        data, I2C_STATUS_IDLE, 0};
+    runTransaction(&t);
+}
+
+/**
+ * Changes a configuration register in the RAM shadow of the LIS3DH without
+ * touching the bus. Call accel_flush() to send every change at once. Only
+ * CTRL_REG1-CTRL_REG6, FIFO_CTRL_REG, INT1_CFG, INT1_THS and INT1_DURATION are
+ * mirrored; other registers are written right away.
+ * @param address the configuration register to change
+ * @param data 8-bit value for the register
+ */
+void accel_set(uint8_t address, uint8_t data) {
+    int index = shadowIndex(address);
+    if(index < 0) {
+        accel_write(address, data);
+    }
+    else if(shadow[index] != data) {
+        shadow[index] = data;
+        shadowDirty |= 1 << index;
+    }
+}
+
+/**
+ * @param address the configuration register to read
+ * @return the value of the register as last set, read from the RAM shadow
+ * when the register is mirrored
+ */
+uint8_t accel_get(uint8_t address) {
+    return accel_read(address);
+}
+
+/**
+ * Writes every configuration register changed by accel_set() to the LIS3DH.
+ * Each group of consecutive registers is sent as one auto-increment write
+ * covering the first to the last changed register of the group.
+ */
+void accel_flush() {
+    int start = 0;
+    while(start < SHADOW_SIZE) {
+        int end = start; // last register of the group of consecutive addresses
+        while(end + 1 < SHADOW_SIZE &&
+                shadowRegisters[end + 1] == shadowRegisters[end] + 1) {
+            end++;
+        }
+        int first = -1;
+        int last = -1;
+        for(int i = start; i <= end; i++) {
+            if(shadowDirty & (1 << i)) {
+                if(first < 0) {
+                    first = i;
+                }
+                last = i;
+            }
+        }
+        if(first >= 0) {
+            I2CTransaction t = {DEVICE_ADDRESS, shadowRegisters[first] | AUTO_INCREMENT,
+                0, last - first + 1, &shadow[first], I2C_STATUS_IDLE, 0};
+            runTransaction(&t);
+        }
+        start = end + 1;
+    }
+    shadowDirty = 0;
+}
+
+/**
+ * Helper function that finds a register in the RAM shadow.
+ * @param address register of the LIS3DH
+ * @return index of the register in the shadow, or -1 if it is not mirrored
+ */
+int shadowIndex(uint8_t address) {
+    for(int i = 0; i < SHADOW_SIZE; i++) {
+        if(shadowRegisters[i] == address) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Helper function that sets the RAM shadow to the power-on values of the
+ * LIS3DH, which is what the sensor holds after a reboot.
+ */
+void resetShadow() {
+    for(int i = 0; i < SHADOW_SIZE; i++) {
+        shadow[i] = shadowDefaults[i];
+    }
+    shadowDirty = 0;
 }
 
 /**
@@ -179,21 +361,383 @@ int getZAcceleration() {
 }
 
 /**
- * The function will detect movement by seeing if the x, y, or z-accelerations 
- * goes above a certain threshold.
+ * Reads the x, y and z-axis accelerations in one burst transaction. All six
+ * output registers (OUT_X_L to OUT_Z_H) are read back to back, so the high and
+ * low bytes of each axis always come from the same output sample.
+ * @param x x-axis acceleration measured by the sensor
+ * @param y y-axis acceleration measured by the sensor
+ * @param z z-axis acceleration measured by the sensor
+ */
+void getAcceleration3(int16_t *x, int16_t *y, int16_t *z) {
+    uint8_t raw[6];
+    accel_read_burst(OUT_X_L, raw, 6);
+    *x = (int16_t) ((raw[1] << 8) | raw[0]);
+    *y = (int16_t) ((raw[3] << 8) | raw[2]);
+    *z = (int16_t) ((raw[5] << 8) | raw[4]);
+}
+
+/**
+ * Helper function that passes one sample to the motion detector.
+ * @param raw the six output register bytes of a sample (OUT_X_L to OUT_Z_H)
+ * @return 1 if the motion detector reports movement, otherwise return 0
+ */
+int sampleMovement(const uint8_t *raw) {
+    int16_t x = (int16_t) ((raw[1] << 8) | raw[0]);
+    int16_t y = (int16_t) ((raw[3] << 8) | raw[2]);
+    int16_t z = (int16_t) ((raw[5] << 8) | raw[4]);
+    return updateMotionDetector(x, y, z);
+}
+
+/**
+ * The function will detect movement by passing samples to the MotionDetector
+ * library, which compares the acceleration with gravity removed against a
+ * threshold on all three axes. The function does not wait on the bus:
+ * it starts a background burst read of the three axes and evaluates it on a
+ * later call once the read has completed, so it should be called repeatedly.
+ * In stream mode, the function reports whether any sample drained from the
+ * FIFO since the last call contained movement. In wake mode, the function
+ * reports whether the LIS3DH raised a motion interrupt since the last call.
+ * In governor mode, the function reports whether any sample since the last
+ * call contained movement, and applies a tier change asked for by the governor.
  * @return 1 if the accelerometer detected movement, otherwise return 0
  */
 int movementDetected() {
-    if(getZAcceleration() > 15000) {
-        return 1;
+    if(governorMode) {
+        if(requestedTier != governorTier) {
+            setAccelerometerTier(requestedTier);
+        }
+        if(governorMovement) {
+            governorMovement = 0;
+            return 1;
+        }
+        return 0;
+    }
+    if(wakeMode) {
+        if(motionWake) {
+            motionWake = 0;
+            return 1;
+        }
+        return 0;
+    }
+    if(streamMode) {
+        if(streamMovement) {
+            streamMovement = 0;
+            return 1;
+        }
+        return 0;
+    }
+    if(sampleTransaction.status == I2C_STATUS_QUEUED) {
+        return 0; // sample still being read
+    }
+    if(sampleTransaction.status == I2C_STATUS_IDLE ||
+            sampleTransaction.status == I2C_STATUS_ERROR) {
+        submitTransaction(&sampleTransaction); // start the next sample
+        return 0;
+    }
+    
+    sampleTransaction.status = I2C_STATUS_IDLE; // sample consumed
+    return sampleMovement(sampleData);
+}
+
+/**
+ * Discards any sample started by movementDetected() that has not been
+ * evaluated yet, so the next detection only uses data read after this call.
+ * Call this when the security mechanism is turned on.
+ */
+void resetMovementDetection() {
+    while(sampleTransaction.status == I2C_STATUS_QUEUED); // let it finish
+    sampleTransaction.status = I2C_STATUS_IDLE;
+    streamMovement = 0;
+    motionWake = 0;
+    governorMovement = 0;
+    initMotionDetector();
+}
+
+/**
+ * Switches the LIS3DH to FIFO stream mode. The sensor buffers up to 32 samples
+ * and raises its INT1 pin once watermark samples are waiting; the INT1
+ * interrupt then drains the whole FIFO in one burst read and passes the block
+ * to the movement detector, so no sample is missed at 400 Hz. Connect the INT1
+ * pin of the LIS3DH to pin RP10 of the microcontroller. The library uses the
+ * INT1 external interrupt of the microcontroller.
+ * @param watermark number of samples (1-31) that triggers a FIFO drain
+ */
+void initAccelerometerStream(uint8_t watermark) {
+    if(wakeMode) {
+        stopAccelerometerWake();
+    }
+    if(governorMode) {
+        stopAccelerometerGovernor();
+    }
+    mapInterruptPin();
+    
+    accel_write(FIFO_CTRL_REG, 0x00); // bypass mode empties the FIFO
+    accel_set(CTRL_REG3, I1_WTM); // watermark on INT1 instead of IA1
+    accel_set(CTRL_REG5, FIFO_EN);
+    accel_set(FIFO_CTRL_REG, FIFO_MODE_STREAM | (watermark & FSS_MASK));
+    accel_flush();
+    
+    streamMovement = 0;
+    streamMode = 1;
+    IFS1bits.INT1IF = 0;
+    IEC1bits.INT1IE = 1; // Enable external interrupt 1
+    if(PORTBbits.RB10) { // watermark already reached, drain now
+        IFS1bits.INT1IF = 1;
+    }
+}
+
+/**
+ * Returns the LIS3DH to bypass mode, where movementDetected() reads one
+ * sample at a time.
+ */
+void stopAccelerometerStream() {
+    IEC1bits.INT1IE = 0;
+    while(fifoSourceTransaction.status == I2C_STATUS_QUEUED ||
+            fifoDataTransaction.status == I2C_STATUS_QUEUED);
+    streamMode = 0;
+    accel_set(CTRL_REG3, I1_IA1);
+    accel_set(CTRL_REG5, 0x00);
+    accel_set(FIFO_CTRL_REG, 0x00);
+    accel_flush();
+}
+
+/**
+ * Puts the LIS3DH in wake mode: the sensor keeps sampling on its own and only
+ * raises its INT1 pin when the high-pass filtered acceleration on any axis
+ * goes above INT1_THS, so the microcontroller can stay in Idle or Sleep until
+ * the backpack moves. Connect the INT1 pin of the LIS3DH to pin RP10 of the
+ * microcontroller. The library uses the INT1 external interrupt of the
+ * microcontroller.
+ */
+void initAccelerometerWake() {
+    if(streamMode) {
+        stopAccelerometerStream();
+    }
+    if(governorMode) {
+        stopAccelerometerGovernor();
+    }
+    mapInterruptPin();
+    
+    accel_set(CTRL_REG3, I1_IA1); // interrupt activity 1 on INT1
+    accel_set(CTRL_REG5, LIR_INT1); // latch the event until INT1_SRC is read
+    accel_flush();
+    accel_read(INT1_SRC); // release any event latched before now
+    
+    motionWake = 0;
+    wakeMode = 1;
+    IFS1bits.INT1IF = 0;
+    IEC1bits.INT1IE = 1; // Enable external interrupt 1
+}
+
+/**
+ * Leaves wake mode. movementDetected() reads one sample at a time again.
+ */
+void stopAccelerometerWake() {
+    IEC1bits.INT1IE = 0;
+    while(int1SourceTransaction.status == I2C_STATUS_QUEUED);
+    wakeMode = 0;
+    accel_set(CTRL_REG5, 0x00);
+    accel_flush();
+}
+
+/**
+ * Puts the LIS3DH under the control of the governor, starting in the idle
+ * tier: 10 Hz in 8-bit low-power mode. The sensor raises its INT1 pin on every
+ * new sample and the INT1 interrupt reads it in the background. When the
+ * residual motion of a sample goes above a pre-threshold, lower than the one
+ * that reports movement, the governor steps up to the suspicious tier (100 Hz);
+ * after 2 seconds of quiet samples it steps back down to idle. The
+ * alarm tier (400 Hz, high resolution) is only entered and left with
+ * setAccelerometerTier(). Call movementDetected() repeatedly. Connect the INT1
+ * pin of the LIS3DH to pin RP10 of the microcontroller. The library uses the
+ * INT1 external interrupt of the microcontroller.
+ */
+void initAccelerometerGovernor() {
+    if(streamMode) {
+        stopAccelerometerStream();
+    }
+    if(wakeMode) {
+        stopAccelerometerWake();
+    }
+    mapInterruptPin();
+    
+    accel_set(CTRL_REG3, I1_ZYXDA); // data ready on INT1 instead of IA1
+    accel_flush();
+    governorMovement = 0;
+    governorMode = 1;
+    setAccelerometerTier(ACCEL_TIER_IDLE); // enables the INT1 interrupt
+}
+
+/**
+ * Leaves governor mode and returns the LIS3DH to 400 Hz high resolution.
+ * movementDetected() reads one sample at a time again.
+ */
+void stopAccelerometerGovernor() {
+    IEC1bits.INT1IE = 0;
+    while(governorTransaction.status == I2C_STATUS_QUEUED);
+    governorMode = 0;
+    setAccelerometerTier(ACCEL_TIER_ALARM);
+    accel_set(CTRL_REG3, I1_IA1);
+    accel_flush();
+}
+
+/**
+ * Changes the output data rate and resolution of the LIS3DH.
+ * ACCEL_TIER_IDLE: 10 Hz, 8-bit low-power mode
+ * ACCEL_TIER_SUSPICIOUS: 100 Hz, 10-bit normal mode
+ * ACCEL_TIER_ALARM: 400 Hz, 12-bit high-resolution mode
+ * Must not be called from an interrupt, as it waits on the bus.
+ * @param tier one of ACCEL_TIER_IDLE, ACCEL_TIER_SUSPICIOUS or ACCEL_TIER_ALARM
+ */
+void setAccelerometerTier(int tier) {
+    int interruptEnabled = IEC1bits.INT1IE;
+    IEC1bits.INT1IE = 0;
+    while(governorTransaction.status == I2C_STATUS_QUEUED); // let it finish
+    
+    accel_set(CTRL_REG1, tierRate[tier]);
+    // Low-power samples only use the H bytes, so BDU is cleared in the idle
+    // tier, otherwise the unread L bytes would hold the outputs
+    accel_set(CTRL_REG4, (accel_get(CTRL_REG4) & ~(BDU | HR)) | tierResolution[tier]);
+    accel_flush();
+    
+    if(tier == ACCEL_TIER_IDLE) {
+        governorTransaction.reg = OUT_X_H | AUTO_INCREMENT;
+        governorTransaction.length = 5;
+    }
+    else {
+        governorTransaction.reg = OUT_X_L | AUTO_INCREMENT;
+        governorTransaction.length = 6;
+    }
+    governorTier = tier;
+    requestedTier = tier;
+    quietSamples = 0;
+    
+    if(governorMode) {
+        IFS1bits.INT1IF = 0;
+        IEC1bits.INT1IE = 1; // Enable external interrupt 1
+        if(PORTBbits.RB10) { // sample already waiting, read it now
+            IFS1bits.INT1IF = 1;
+        }
+    }
+    else {
+        IEC1bits.INT1IE = interruptEnabled;
+    }
+}
+
+/**
+ * @return the tier the LIS3DH is running at (ACCEL_TIER_IDLE,
+ * ACCEL_TIER_SUSPICIOUS or ACCEL_TIER_ALARM)
+ */
+int getAccelerometerTier() {
+    return governorTier;
+}
+
+/**
+ * Helper function that maps the INT1 pin of the LIS3DH (wired to RP10) to the
+ * INT1 external interrupt of the microcontroller. The interrupt is left
+ * disabled.
+ */
+void mapInterruptPin() {
+    TRISBbits.TRISB10 = 1; // Set pin RP10 as input
+    __builtin_write_OSCCONL(OSCCON & 0xBF); // unlock PPS
+    RPINR0bits.INT1R = 10; // RP10 mapped to external interrupt 1
+    __builtin_write_OSCCONL(OSCCON | 0x40); // lock PPS
+    INTCON2bits.INT1EP = 0; // interrupt on rising edge
+    IEC1bits.INT1IE = 0;
+}
+
+/**
+ * I2C callback for the FIFO_SRC_REG read: starts the burst read of every
+ * sample currently in the FIFO.
+ */
+void fifoSourceComplete(I2CTransaction *transaction) {
+    uint8_t samples = fifoSource & FSS_MASK;
+    if(transaction->status != I2C_STATUS_DONE || samples == 0) {
+        return;
+    }
+    // With the FIFO enabled, the auto-incremented address wraps from OUT_Z_H
+    // back to OUT_X_L, so one read returns the samples back to back
+    fifoDataTransaction.length = samples * 6;
+    submitTransaction(&fifoDataTransaction);
+}
+
+/**
+ * I2C callback for the FIFO burst read: passes the block of samples to the
+ * movement detector.
+ */
+void fifoDataComplete(I2CTransaction *transaction) {
+    if(transaction->status == I2C_STATUS_DONE) {
+        for(uint8_t i = 0; i < transaction->length; i += 6) {
+            if(sampleMovement(&fifoData[i])) { // every sample updates the filter
+                streamMovement = 1;
+            }
+        }
+    }
+    if(PORTBbits.RB10) { // FIFO refilled past the watermark during the read
+        submitTransaction(&fifoSourceTransaction);
+    }
+}
+
+/**
+ * I2C callback for the governor sample read: passes the sample to the movement
+ * detector and decides whether the output data rate should change. The change
+ * itself is made by movementDetected(), outside of the interrupt.
+ */
+void governorSampleComplete(I2CTransaction *transaction) {
+    if(transaction->status == I2C_STATUS_DONE) {
+        int16_t x, y, z;
+        if(transaction->length == 5) { // OUT_X_H, OUT_Y_L, OUT_Y_H, OUT_Z_L, OUT_Z_H
+            x = (int16_t) (governorData[0] << 8);
+            y = (int16_t) (governorData[2] << 8);
+            z = (int16_t) (governorData[4] << 8);
+        }
+        else {
+            x = (int16_t) ((governorData[1] << 8) | governorData[0]);
+            y = (int16_t) ((governorData[3] << 8) | governorData[2]);
+            z = (int16_t) ((governorData[5] << 8) | governorData[4]);
+        }
+        if(updateMotionDetector(x, y, z)) {
+            governorMovement = 1;
+        }
+        
+        if(governorTier != ACCEL_TIER_ALARM) {
+            if(getMotionResidual() > GOVERNOR_PRE_THRESHOLD) {
+                quietSamples = 0;
+                requestedTier = ACCEL_TIER_SUSPICIOUS;
+            }
+            else if(governorTier == ACCEL_TIER_SUSPICIOUS &&
+                    ++quietSamples >= GOVERNOR_QUIET_SAMPLES) {
+                requestedTier = ACCEL_TIER_IDLE;
+            }
+        }
+    }
+    if(PORTBbits.RB10) { // a new sample arrived during the read
+        submitTransaction(&governorTransaction);
+    }
+}
+
+/**
+ * Interrupts when the LIS3DH raises its INT1 pin. In wake mode, the motion
+ * event is flagged and released; in stream mode, the FIFO reached its
+ * watermark and is drained; in governor mode, a new sample is read.
+ */
+void __attribute__((__interrupt__, __auto_psv__)) _INT1Interrupt() {
+    IFS1bits.INT1IF = 0;
+    if(governorMode) {
+        if(governorTransaction.status != I2C_STATUS_QUEUED) {
+            submitTransaction(&governorTransaction);
+        }
     }
-    else if(getYAcceleration() > 15000) {
-        return 1;
+    else if(wakeMode) {
+        motionWake = 1;
+        if(int1SourceTransaction.status != I2C_STATUS_QUEUED) {
+            submitTransaction(&int1SourceTransaction); // release INT1
+        }
     }
-    else if(getZAcceleration() > 15000) {
-        return 1;
+    else if(fifoSourceTransaction.status != I2C_STATUS_QUEUED &&
+            fifoDataTransaction.status != I2C_STATUS_QUEUED) {
+        submitTransaction(&fifoSourceTransaction);
     }
-    return 0;
 }
 
 /**
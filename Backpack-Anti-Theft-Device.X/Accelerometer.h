@@ -4,7 +4,10 @@
  * The Accelerometer library contains an assortment of functions to communicate
  * and gain acceleration values from the LIS3DH accelerometer using a
  * PIC24FJ64GA002 accelerometer. The library uses the I2C1 module of the
- * microcontroller. Ensure that this module is not being used elsewhere.
+ * microcontroller through the interrupt-driven I2C library (or the SPI1 module
+ * through the AccelerometerSPI library when ACCEL_USE_SPI is 1), and the
+ * MotionDetector library to detect movement. Ensure that this module is not
+ * being used elsewhere.
  * To use this library, connect the SDA1/SCL1 pins of the microcontroller to the
  * SDA/SCL pins of the LIS3DH. Connect the SDO pin of the LIS3DH to ground, and
  * the CS pin of the LIS3DH to Vdd. Connect both pins to a 10kΩ pull up resistor.
@@ -21,11 +24,21 @@
 extern "C" {
 #endif
 
+// Set to 1 to talk to the LIS3DH over SPI1 (AccelerometerSPI library)
+// instead of I2C1 (I2C library)
+#define ACCEL_USE_SPI 0
+
+// Tiers of the output data rate governor (see initAccelerometerGovernor())
+#define ACCEL_TIER_IDLE 0 // 10 Hz, 8-bit low-power mode
+#define ACCEL_TIER_SUSPICIOUS 1 // 100 Hz, 10-bit normal mode
+#define ACCEL_TIER_ALARM 2 // 400 Hz, 12-bit high-resolution mode
+
 // Function declarations
     
 /**
- * Initializes the accelerometer by initializing the I2C1 module of the
- * microcontroller, and sending commands to initialize the LIS3DH.
+ * Initializes the accelerometer by initializing the I2C library (or the
+ * AccelerometerSPI library when ACCEL_USE_SPI is 1), and sending commands to
+ * initialize the LIS3DH.
  */
 void initAccelerometer();
 
@@ -34,7 +47,8 @@ void initAccelerometer();
  * Register Mapping (p. 31) of the LIS3DH datasheet manual for specific register
  * addresses.
  * @return 8-bit value corresponding to the value read from the input address
- * register of the LIS3DH
+ * register of the LIS3DH. Configuration registers mirrored by accel_set() are
+ * returned from RAM without a bus transaction
  */
 uint8_t accel_read(uint8_t address);
 
@@ -46,6 +60,42 @@ uint8_t accel_read(uint8_t address);
  */
 void accel_write(uint8_t address, uint8_t data);
 
+/**
+ * Reads length consecutive registers of the LIS3DH in a single I2C transaction.
+ * The auto-increment bit is set on the register address, so the LIS3DH
+ * advances to the next register after each byte. Every byte but the last one
+ * is acknowledged (ACK); the last byte is answered with a NACK before the stop
+ * bit so the LIS3DH releases the bus.
+ * @param address the first register in the LIS3DH to read
+ * @param data buffer that receives length bytes, in register order
+ * @param length number of registers to read (at least 1)
+ */
+void accel_read_burst(uint8_t address, uint8_t *data, uint8_t length);
+
+/**
+ * Changes a configuration register in the RAM shadow of the LIS3DH without
+ * touching the bus. Call accel_flush() to send every change at once. Only
+ * CTRL_REG1-CTRL_REG6, FIFO_CTRL_REG, INT1_CFG, INT1_THS and INT1_DURATION are
+ * mirrored; other registers are written right away.
+ * @param address the configuration register to change
+ * @param data 8-bit value for the register
+ */
+void accel_set(uint8_t address, uint8_t data);
+
+/**
+ * @param address the configuration register to read
+ * @return the value of the register as last set, read from the RAM shadow
+ * when the register is mirrored
+ */
+uint8_t accel_get(uint8_t address);
+
+/**
+ * Writes every configuration register changed by accel_set() to the LIS3DH.
+ * Each group of consecutive registers is sent as one auto-increment write
+ * covering the first to the last changed register of the group.
+ */
+void accel_flush();
+
 /**
  * @return x-axis acceleration measured by the sensor
  */
@@ -62,12 +112,105 @@ int getYAcceleration();
 int getZAcceleration();
 
 /**
- * The function will detect movement by seeing if the x, y, or z-accelerations 
- * goes above a certain threshold.
+ * Reads the x, y and z-axis accelerations in one burst transaction. All six
+ * output registers (OUT_X_L to OUT_Z_H) are read back to back, so the high and
+ * low bytes of each axis always come from the same output sample.
+ * @param x x-axis acceleration measured by the sensor
+ * @param y y-axis acceleration measured by the sensor
+ * @param z z-axis acceleration measured by the sensor
+ */
+void getAcceleration3(int16_t *x, int16_t *y, int16_t *z);
+
+/**
+ * The function will detect movement by passing samples to the MotionDetector
+ * library, which compares the acceleration with gravity removed against a
+ * threshold on all three axes. The function does not wait on the bus:
+ * it starts a background burst read of the three axes and evaluates it on a
+ * later call once the read has completed, so it should be called repeatedly.
+ * In stream mode, the function reports whether any sample drained from the
+ * FIFO since the last call contained movement. In wake mode, the function
+ * reports whether the LIS3DH raised a motion interrupt since the last call.
+ * In governor mode, the function reports whether any sample since the last
+ * call contained movement, and applies a tier change asked for by the governor.
  * @return 1 if the accelerometer detected movement, otherwise return 0
  */
 int movementDetected();
 
+/**
+ * Discards any sample started by movementDetected() that has not been
+ * evaluated yet, so the next detection only uses data read after this call.
+ * Call this when the security mechanism is turned on.
+ */
+void resetMovementDetection();
+
+/**
+ * Switches the LIS3DH to FIFO stream mode. The sensor buffers up to 32 samples
+ * and raises its INT1 pin once watermark samples are waiting; the INT1
+ * interrupt then drains the whole FIFO in one burst read and passes the block
+ * to the movement detector, so no sample is missed at 400 Hz. Connect the INT1
+ * pin of the LIS3DH to pin RP10 of the microcontroller. The library uses the
+ * INT1 external interrupt of the microcontroller.
+ * @param watermark number of samples (1-31) that triggers a FIFO drain
+ */
+void initAccelerometerStream(uint8_t watermark);
+
+/**
+ * Returns the LIS3DH to bypass mode, where movementDetected() reads one
+ * sample at a time.
+ */
+void stopAccelerometerStream();
+
+/**
+ * Puts the LIS3DH in wake mode: the sensor keeps sampling on its own and only
+ * raises its INT1 pin when the high-pass filtered acceleration on any axis
+ * goes above INT1_THS, so the microcontroller can stay in Idle or Sleep until
+ * the backpack moves. Connect the INT1 pin of the LIS3DH to pin RP10 of the
+ * microcontroller. The library uses the INT1 external interrupt of the
+ * microcontroller.
+ */
+void initAccelerometerWake();
+
+/**
+ * Leaves wake mode. movementDetected() reads one sample at a time again.
+ */
+void stopAccelerometerWake();
+
+/**
+ * Puts the LIS3DH under the control of the governor, starting in the idle
+ * tier: 10 Hz in 8-bit low-power mode. The sensor raises its INT1 pin on every
+ * new sample and the INT1 interrupt reads it in the background. When the
+ * residual motion of a sample goes above a pre-threshold, lower than the one
+ * that reports movement, the governor steps up to the suspicious tier (100 Hz);
+ * after 2 seconds of quiet samples it steps back down to idle. The
+ * alarm tier (400 Hz, high resolution) is only entered and left with
+ * setAccelerometerTier(). Call movementDetected() repeatedly. Connect the INT1
+ * pin of the LIS3DH to pin RP10 of the microcontroller. The library uses the
+ * INT1 external interrupt of the microcontroller.
+ */
+void initAccelerometerGovernor();
+
+/**
+ * Leaves governor mode and returns the LIS3DH to 400 Hz high resolution.
+ * movementDetected() reads one sample at a time again.
+ */
+void stopAccelerometerGovernor();
+
+/**
+ * Changes the output data rate and resolution of the LIS3DH.
+ * ACCEL_TIER_IDLE: 10 Hz, 8-bit low-power mode
+ * ACCEL_TIER_SUSPICIOUS: 100 Hz, 10-bit normal mode
+ * ACCEL_TIER_ALARM: 400 Hz, 12-bit high-resolution mode
+ * Must not be called from an interrupt, as it waits on the bus.
+ * @param tier one of ACCEL_TIER_IDLE, ACCEL_TIER_SUSPICIOUS or ACCEL_TIER_ALARM
+ */
+void setAccelerometerTier(int tier);
+
+/**
+ * @return the tier the LIS3DH is running at (ACCEL_TIER_IDLE,
+ * ACCEL_TIER_SUSPICIOUS or ACCEL_TIER_ALARM)
+ */
+int getAccelerometerTier();
+
 #ifdef	__cplusplus
 }
 #endif
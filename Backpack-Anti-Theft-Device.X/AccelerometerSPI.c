@@ -0,0 +1,151 @@
+/*
+ * File:   AccelerometerSPI.c
+ * Author: Sharmarke Ahmed
+ * The AccelerometerSPI library is the SPI backend of the Accelerometer
+ * library. It runs the same I2CTransaction descriptors as the I2C library
+ * over the SPI1 module of the PIC24FJ64GA002 at 8 MHz, so the Accelerometer
+ * library can use either bus without changes. Every transaction is clocked
+ * through the 8-deep enhanced buffer as a single burst while CS is held low.
+ * To use this backend, set ACCEL_USE_SPI to 1 in Accelerometer.h and connect
+ * the LIS3DH as follows: SCL/SPC to RP4, SDA/SDI to RP5, CS to RP6 and SDO
+ * to RP7. The library uses the SPI1 module of the microcontroller. Ensure
+ * that this module is not being used elsewhere.
+ *
+ * Created on December 11, 2023, 4:05 PM
+ */
+
+
+#include "xc.h"
+#include "stdint.h"
+#include "AccelerometerSPI.h"
+
+#define SPI_READ 0x80 // RW bit of the LIS3DH SPI address byte
+#define SPI_MULTIPLE 0x40 // MS bit: auto-increment the register address
+#define BUFFER_DEPTH 8 // depth of the SPI1 enhanced buffer
+#define SPI_IPL 4 // priority of the interrupts that may submit transactions
+
+// Function declarations
+void initAccelerometerSPI();
+int submitSPITransaction(I2CTransaction *transaction);
+int runSPITransaction(I2CTransaction *transaction);
+int isSPIIdle();
+
+/**
+ * Maps the SPI1 pins through PPS and initializes the SPI1 module as an 8 MHz
+ * master in SPI mode 3 with the enhanced buffer turned on.
+ */
+void initAccelerometerSPI() {
+    CLKDIVbits.RCDIV = 0; // 16MHz instruction clock
+    // Note: pins RP7, RP6, RP5, and RP4 are not analog pins on PIC24
+    
+    TRISBbits.TRISB7 = 1; // Set RP7 (SDO) as input
+    TRISBbits.TRISB6 = 0; // Set RP6 (CS) as output
+    TRISBbits.TRISB4 = 0; // Set RP4 (SCL) as output
+    TRISBbits.TRISB5 = 0; // Set RP5 (SDA) as output
+    LATBbits.LATB6 = 1; // CS is driven by software, start deselected
+    
+    // Configure pins RP7, RP4, and RP5 for SPI1 via PPS
+    __builtin_write_OSCCONL(OSCCON & 0xBF); // unlock PPS
+    RPOR2bits.RP4R = 8; // RP4 mapped to SPI1 clock output
+    RPOR2bits.RP5R = 7; // RP5 mapped to SPI1 data output
+    RPINR20bits.SDI1R = 7; // RP7 mapped to SPI1 data input
+    __builtin_write_OSCCONL(OSCCON | 0x40); // lock PPS
+    
+    /** Configure SPI1CON1 register */
+    SPI1STATbits.SPIEN = 0;
+    SPI1CON1 = 0;
+    SPI1CON2 = 0;
+    SPI1STAT = 0;
+    
+    SPI1CON1bits.MSTEN = 1; // master mode
+    SPI1CON1bits.SSEN = 0; // CS is a regular output held low for a whole burst
+    SPI1CON1bits.CKP = 1; // SPI mode 3: clock idles high,
+    SPI1CON1bits.CKE = 0; // data changes on the falling (idle to active) edge
+    SPI1CON1bits.SMP = 1; // sample input data at the end of the output time
+    
+    // Configure SPI1 for a clock frequency of 8 MHz (note: max clock frequency
+    // allowed to be used with LIS3DH is 10MHz)
+    SPI1CON1bits.PPRE = 0b11; // Primary prescale 1:1
+    SPI1CON1bits.SPRE = 0b110; // Secondary prescale 2:1
+    SPI1CON2bits.SPIBEN = 1; // Turn on enhanced buffer mode
+    IEC0bits.SPI1IE = 0; // transfers are polled; a burst takes a few us
+    IFS0bits.SPI1IF = 0;
+    SPI1STATbits.SPIEN = 1; // Enable SPI 1 module
+}
+
+/**
+ * Runs a transaction right away and then calls its callback. The
+ * deviceAddress field is ignored; the auto-increment bit (0x80) of the reg
+ * field is translated to the MS bit of the SPI address byte. Can be called
+ * from a transaction callback.
+ * @param transaction the transaction to run
+ * @return 1, since the transaction never has to wait for room in a queue
+ */
+int submitSPITransaction(I2CTransaction *transaction) {
+    uint8_t address = transaction->reg & 0x3F;
+    if(transaction->reg & 0x80) {
+        address |= SPI_MULTIPLE;
+    }
+    if(transaction->read) {
+        address |= SPI_READ;
+    }
+    uint16_t total = transaction->length + 1; // address byte + data bytes
+    uint16_t sent = 0;
+    uint16_t received = 0;
+    int oldIpl;
+    
+    // Keep the INT1 and I2C-level interrupts from starting another transfer
+    // while CS is low
+    SET_AND_SAVE_CPU_IPL(oldIpl, SPI_IPL);
+    transaction->status = I2C_STATUS_QUEUED;
+    LATBbits.LATB6 = 0; // select the LIS3DH
+    while(received < total) {
+        // Keep up to BUFFER_DEPTH bytes in flight so the receive buffer can
+        // never overflow
+        while(sent < total && sent - received < BUFFER_DEPTH &&
+                !SPI1STATbits.SPITBF) {
+            if(sent == 0) {
+                SPI1BUF = address;
+            }
+            else if(transaction->read) {
+                SPI1BUF = 0x00; // dummy byte clocks the next register out
+            }
+            else {
+                SPI1BUF = transaction->data[sent - 1];
+            }
+            sent++;
+        }
+        while(!SPI1STATbits.SRXMPT) { // drain what has been received so far
+            uint8_t byte = SPI1BUF;
+            if(received > 0 && transaction->read) {
+                transaction->data[received - 1] = byte;
+            }
+            received++;
+        }
+    }
+    LATBbits.LATB6 = 1; // deselect
+    transaction->status = I2C_STATUS_DONE;
+    RESTORE_CPU_IPL(oldIpl);
+    
+    if(transaction->callback) {
+        transaction->callback(transaction);
+    }
+    return 1;
+}
+
+/**
+ * Runs a transaction right away.
+ * @param transaction the transaction to run
+ * @return 1 since the LIS3DH does not acknowledge SPI transfers
+ */
+int runSPITransaction(I2CTransaction *transaction) {
+    return submitSPITransaction(transaction);
+}
+
+/**
+ * @return 1, since transactions complete before submitSPITransaction()
+ * returns
+ */
+int isSPIIdle() {
+    return 1;
+}
@@ -0,0 +1,60 @@
+/*
+ * File:   AccelerometerSPI.h
+ * Author: Sharmarke Ahmed
+ * The AccelerometerSPI library is the SPI backend of the Accelerometer
+ * library. It runs the same I2CTransaction descriptors as the I2C library
+ * over the SPI1 module of the PIC24FJ64GA002 at 8 MHz, so the Accelerometer
+ * library can use either bus without changes. Every transaction is clocked
+ * through the 8-deep enhanced buffer as a single burst while CS is held low.
+ * To use this backend, set ACCEL_USE_SPI to 1 in Accelerometer.h and connect
+ * the LIS3DH as follows: SCL/SPC to RP4, SDA/SDI to RP5, CS to RP6 and SDO
+ * to RP7. The library uses the SPI1 module of the microcontroller. Ensure
+ * that this module is not being used elsewhere.
+ *
+ * Created on December 11, 2023, 4:05 PM
+ */
+
+#ifndef ACCELEROMETERSPI_H
+#define	ACCELEROMETERSPI_H
+
+#include "I2C.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/**
+ * Maps the SPI1 pins through PPS and initializes the SPI1 module as an 8 MHz
+ * master in SPI mode 3 with the enhanced buffer turned on.
+ */
+void initAccelerometerSPI();
+
+/**
+ * Runs a transaction right away and then calls its callback. The
+ * deviceAddress field is ignored; the auto-increment bit (0x80) of the reg
+ * field is translated to the MS bit of the SPI address byte. Can be called
+ * from a transaction callback.
+ * @param transaction the transaction to run
+ * @return 1, since the transaction never has to wait for room in a queue
+ */
+int submitSPITransaction(I2CTransaction *transaction);
+
+/**
+ * Runs a transaction right away.
+ * @param transaction the transaction to run
+ * @return 1 since the LIS3DH does not acknowledge SPI transfers
+ */
+int runSPITransaction(I2CTransaction *transaction);
+
+/**
+ * @return 1, since transactions complete before submitSPITransaction()
+ * returns
+ */
+int isSPIIdle();
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ACCELEROMETERSPI_H */
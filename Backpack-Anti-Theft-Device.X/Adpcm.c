@@ -0,0 +1,92 @@
+/*
+ * File:   Adpcm.c
+ * Author: Sharmarke Ahmed
+ * The Adpcm library decodes 4-bit IMA-ADPCM audio, as made by the encoder in
+ * other_files/adpcm, back into 16-bit samples. Each 4-bit code moves a
+ * predicted sample up or down by an adaptive step, so one byte holds two
+ * samples and a second of 8 kHz audio takes 4 kB of flash. Decoding a sample
+ * takes a table read, shifts and adds only. The library uses no hardware, so
+ * it is built on a PC by the encoder's test, and by AdpcmHostTest, which
+ * checks it bit for bit against samples from an independent decoder.
+ *
+ * Created on December 12, 2023, 2:05 PM
+ */
+
+
+#include "stdint.h"
+#include "Adpcm.h"
+
+#define MAX_INDEX 88 // last entry of the step table
+
+// Function declarations
+void resetAdpcm(AdpcmState *state, const AdpcmSound *sound);
+int16_t decodeAdpcm(AdpcmState *state, uint8_t code);
+
+// Step sizes of the IMA-ADPCM standard, growing by about 10% per entry
+const int16_t stepTable[MAX_INDEX + 1] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+    45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209,
+    230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876,
+    963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493,
+    10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623,
+    27086, 29794, 32767};
+
+// Change of step table position for each code magnitude (sign bit removed):
+// small codes shrink the step, large codes grow it
+const int8_t indexTable[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+/**
+ * Sets the decoder state to the start of a sound.
+ * @param state decoder state to set
+ * @param sound sound about to be decoded
+ */
+void resetAdpcm(AdpcmState *state, const AdpcmSound *sound) {
+    state->predictor = sound->predictor;
+    state->index = sound->index;
+}
+
+/**
+ * Decodes one 4-bit code into a 16-bit sample and moves the state forward.
+ * @param state decoder state
+ * @param code 4-bit IMA-ADPCM code, in the low 4 bits
+ * @return decoded 16-bit sample
+ */
+int16_t decodeAdpcm(AdpcmState *state, uint8_t code) {
+    int16_t step = stepTable[state->index];
+    int32_t difference = step >> 3; // step * (code magnitude + 0.5) / 4
+    if(code & 4) {
+        difference += step;
+    }
+    if(code & 2) {
+        difference += step >> 1;
+    }
+    if(code & 1) {
+        difference += step >> 2;
+    }
+    
+    int32_t predictor = state->predictor;
+    if(code & 8) {
+        predictor -= difference;
+        if(predictor < -32768) {
+            predictor = -32768;
+        }
+    }
+    else {
+        predictor += difference;
+        if(predictor > 32767) {
+            predictor = 32767;
+        }
+    }
+    state->predictor = predictor;
+    
+    int index = state->index + indexTable[code & 7];
+    if(index < 0) {
+        index = 0;
+    }
+    else if(index > MAX_INDEX) {
+        index = MAX_INDEX;
+    }
+    state->index = index;
+    return state->predictor;
+}
@@ -0,0 +1,57 @@
+/*
+ * File:   Adpcm.h
+ * Author: Sharmarke Ahmed
+ * The Adpcm library decodes 4-bit IMA-ADPCM audio, as made by the encoder in
+ * other_files/adpcm, back into 16-bit samples. Each 4-bit code moves a
+ * predicted sample up or down by an adaptive step, so one byte holds two
+ * samples and a second of 8 kHz audio takes 4 kB of flash. Decoding a sample
+ * takes a table read, shifts and adds only. The library uses no hardware, so
+ * the encoder's test builds it on a PC to check the decoder bit for bit.
+ *
+ * Created on December 12, 2023, 2:05 PM
+ */
+
+#ifndef ADPCM_H
+#define	ADPCM_H
+
+#include "stdint.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// State of the decoder, carried from one sample to the next
+typedef struct {
+    int16_t predictor; // last decoded sample
+    uint8_t index; // position in the step table, 0 to 88
+} AdpcmState;
+
+// An encoded sound stored in program memory. Samples are packed two per byte,
+// the first one in the low nibble
+typedef struct {
+    const uint8_t *data;
+    uint16_t samples; // number of samples (4-bit codes)
+    int16_t predictor; // decoder state before the first sample
+    uint8_t index;
+} AdpcmSound;
+
+/**
+ * Sets the decoder state to the start of a sound.
+ * @param state decoder state to set
+ * @param sound sound about to be decoded
+ */
+void resetAdpcm(AdpcmState *state, const AdpcmSound *sound);
+
+/**
+ * Decodes one 4-bit code into a 16-bit sample and moves the state forward.
+ * @param state decoder state
+ * @param code 4-bit IMA-ADPCM code, in the low 4 bits
+ * @return decoded 16-bit sample
+ */
+int16_t decodeAdpcm(AdpcmState *state, uint8_t code);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ADPCM_H */
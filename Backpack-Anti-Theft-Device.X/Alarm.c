@@ -6,45 +6,150 @@
  * The library uses Timer2 and the output compare 1 register on the 
  * microcontroller. Ensure these modules are not being used elsewhere. When the
  * alarm is turned on, the library will send pulses to the buzzer with an
- * input frequency greater than 0.477 Hz.
+ * input frequency between 1 Hz and 65535 Hz. The Timer2 configuration is
+ * computed with integer arithmetic only: at compile time by initAlarm() when
+ * the frequency is a constant, and by setAlarmFrequency() at run time.
+ * turnOnSiren() plays a siren instead of a fixed tone: the Timer2 interrupt
+ * steps the tone through a table of periods computed at compile time.
+ * Output compare 1 runs in PWM mode, and the duty cycle sets the volume.
+ * startAlarmSchedule() and updateAlarm() lower the volume and pulse the alarm
+ * as it keeps sounding, and sooner when the batteries run low, so the alarm
+ * lasts for hours. The schedule uses the PowerManager library.
+ * playAlarmSound() plays a recorded sound (see AlarmSounds.h) instead: Timer2
+ * runs a 32 kHz PWM carrier, and every fourth period the Timer2 interrupt
+ * decodes the next ADPCM sample into the duty cycle, so the buzzer plays
+ * 8 kHz audio.
  *
  * Created on November 23, 2023, 4:11 PM
  */
 
 
 #include "xc.h"
-#include "math.h"
+#include "stdint.h"
+#include "Alarm.h"
+#include "PowerManager.h"
+#include "Adpcm.h"
+
+#define SIREN_OFF 0 // fixed tone, or silent
+#define SIREN_STEPS 32 // frequencies in the sweep table
+#define SIREN_LOW_HZ 700 // bottom of the sweep
+#define SIREN_HIGH_HZ 1600 // top of the sweep
+#define SIREN_TICKS_PER_MS (FCY / 1000) // Timer2 counts in 1 ms at 1:1
+#define FULL_VOLUME_DUTY 32768 // 50% duty cycle in 1/65536 of the period
+#define TICKS_PER_SECOND 62500 // PowerManager ticks (16 us) in a second
+#define BATTERY_CHECK_SECONDS 60 // time between two battery measurements
+#define CARRIER_PERIOD 499 // Timer2 period of the 32 kHz sound carrier
+// (1/32000 seconds) * (16 * 10 ^6) cycles/sec -1 = 499
+#define CARRIERS_PER_SAMPLE 4 // 32 kHz / 8 kHz
+
+// Timer2 period (1:1 prescale) of step i of the sweep. The frequencies are
+// evenly spaced from SIREN_LOW_HZ to SIREN_HIGH_HZ
+#define SIREN_FREQ(i) (SIREN_LOW_HZ + ((SIREN_HIGH_HZ - SIREN_LOW_HZ) * (i)) / (SIREN_STEPS - 1))
+#define SIREN_PERIOD(i) ((uint16_t) ((FCY + SIREN_FREQ(i) / 2) / SIREN_FREQ(i) - 1))
+#define SIREN_PERIOD_4(i) SIREN_PERIOD(i), SIREN_PERIOD((i) + 1), SIREN_PERIOD((i) + 2), \
+    SIREN_PERIOD((i) + 3)
 
 
 // Function declarations
-void initAlarm(double freq);
+void initAlarmTimer(unsigned int prescale, unsigned int period);
+void setAlarmFrequency(unsigned int freq);
 void turnOnAlarm();
+void turnOnSiren(int pattern, unsigned int sweepMs);
+unsigned int getAlarmLoad();
+void setAlarmVolume(unsigned int volume);
+void startAlarmSchedule();
+void updateAlarm();
+void gateAlarm(int on);
+void playAlarmSound(const AdpcmSound *sound, unsigned int repeats);
+int isAlarmSoundPlaying();
 void turnOffAlarm();
+void __attribute__((__interrupt__, __auto_psv__)) _T2Interrupt();
+
+// Timer2 settings of the fixed tone, written by the Timer2 interrupt when they
+// change while the tone is playing, see setAlarmFrequency()
+volatile unsigned int tonePrescale = 0;
+volatile unsigned int tonePeriod = 0;
+
+// Timer2 periods of the siren sweep, lowest frequency first
+const uint16_t sirenPeriods[SIREN_STEPS] = {
+    SIREN_PERIOD_4(0), SIREN_PERIOD_4(4), SIREN_PERIOD_4(8), SIREN_PERIOD_4(12),
+    SIREN_PERIOD_4(16), SIREN_PERIOD_4(20), SIREN_PERIOD_4(24), SIREN_PERIOD_4(28)};
+
+// Siren state, advanced by _T2Interrupt()
+volatile int sirenPattern = SIREN_OFF;
+volatile int sirenIndex = 0; // step of the sweep playing
+volatile int sirenDirection = 1; // 1 going up the sweep, -1 going down
+volatile int32_t stepCyclesLeft = 0; // cycles until the next step
+int32_t stepCycles = 0; // cycles per step, from the sweep rate
+
+// Fraction of the period the pin is high, in 1/65536 of the period: the
+// volume, from 0 (silent) to FULL_VOLUME_DUTY (50%, loudest)
+volatile uint16_t dutyFraction = FULL_VOLUME_DUTY;
+
+// One stage of the escalation schedule: from startSeconds after
+// startAlarmSchedule(), the alarm plays at the given volume for onSeconds,
+// then stays silent for offSeconds (0 to sound continuously)
+typedef struct {
+    uint16_t startSeconds;
+    uint8_t volume;
+    uint8_t onSeconds;
+    uint8_t offSeconds;
+} AlarmStage;
+
+// Current drawn by the buzzer goes down with the volume and the time spent
+// silent: in the last stage the pin is high 6% as long as in the first one
+#define ALARM_STAGES 3
+const AlarmStage alarmStages[ALARM_STAGES] = {
+    {0, 100, 1, 0}, // first 2 minutes: full volume, continuous
+    {120, 60, 2, 2}, // until 10 minutes: 60% volume, half the time
+    {600, 30, 1, 4} // afterwards: 30% volume, one second in five
+};
+
+// Escalation schedule state, advanced by updateAlarm()
+int scheduleOn = 0;
+int scheduleStage = 0;
+int batteryStage = 0; // first stage allowed by the battery voltage
+uint32_t lastSecond = 0; // PowerManager tick of the last second counted
+uint16_t scheduleSeconds = 0; // seconds since startAlarmSchedule()
+uint8_t pulseSeconds = 0; // seconds into the on/off pulse of the stage
+
+// Sound playback state, advanced by _T2Interrupt()
+const AdpcmSound * volatile playingSound = 0; // 0 when no sound is playing
+AdpcmState soundState;
+volatile uint16_t soundPosition = 0; // next sample
+volatile unsigned int soundRepeats = 0; // times left to play the sound
+volatile uint8_t carrierCount = 0; // carrier periods left in the sample
+volatile uint16_t soundAmplitude = 0; // duty cycle of silence, half the
+// swing of the loudest sample
+
+// Load of the Timer2 interrupt, see getAlarmLoad()
+volatile uint32_t sirenBusyCycles = 0; // cycles spent in the interrupt
+volatile uint32_t sirenCycles = 0; // cycles played by the siren
 
 /**
  * Initializes pin RP14 as output for the piezoelectric buzzer, as well as 
  * the output compare register and Timer2 used to send pulses to the buzzer.
+ * Called by initAlarm(), which works out the Timer2 settings for a frequency.
  * 
- * @param freq the minimum frequency allowed is 0.4768444343 Hz, anything lower
- * than this will overflow the period. The frequency at which that alarm beeps 
- * can be altered by the user
+ * @param prescale Timer2 prescaler (TCKPS), as given by ALARM_PRESCALE()
+ * @param period Timer2 period (PR2), as given by ALARM_PERIOD()
  */
-void initAlarm(double freq) {
+void initAlarmTimer(unsigned int prescale, unsigned int period) {
     CLKDIVbits.RCDIV = 0; // 16 MHz clock
     AD1PCFGbits.PCFG10 = 1; // Configure pin RP14 (AN10) as digital
     TRISBbits.TRISB14 = 0; // Configure pin RP14 as output
     LATBbits.LATB14 = 0; // Initially have pin RP14 LOW
     
-    /** Set up TMR3 to have maximum period **/
+    /** Set up TMR2 for a whole period of the tone (OC1 runs in PWM mode) **/
     T2CON = 0; // ensure TMR2 is reset
     TMR2 = 0; // ensure TMR2 starts at zero
-    T2CONbits.TCKPS = 0b11; // 1:256 prescale
-    double periodSeconds = 1/( freq * 2); //period in seconds
-    long int periodCycles = (periodSeconds/( (double) 62.5E-9 * 256.0)) - 1;//period in cycles
-    if(periodCycles > 65535){
-        periodCycles = 65535;
-    }
-    PR2 = periodCycles; // period
+    T2CONbits.TCKPS = prescale;
+    PR2 = period;
+    tonePrescale = prescale;
+    tonePeriod = period;
+    IEC0bits.T2IE = 0; // only used by the siren, or while a new frequency
+    // is pending
+    IFS0bits.T2IF = 0;
     
     /** Map output compare 1 register to pin RP14 via PPS */
     
@@ -54,26 +159,360 @@ void initAlarm(double freq) {
 
 }
 
+/**
+ * Changes the frequency of the alarm. While the siren is playing, the new
+ * frequency is used by the next turnOnAlarm(). While the fixed tone is
+ * playing, the duty cycle of the new frequency is written to OC1RS right away,
+ * so it is loaded at the next period match and never exceeds the new period,
+ * and the new Timer2 settings are written by the Timer2 interrupt just after
+ * that match. If higher priority interrupts hold the Timer2 interrupt off
+ * until TMR2 has passed a shorter PR2, the interrupt restarts TMR2: that one
+ * period is stretched by the delay instead of running through 65536 counts.
+ * Uses integer divisions only; for a constant frequency, initAlarm() costs
+ * nothing at run time.
+ * @param freq frequency of the tone in Hz, from 1 to 65535
+ */
+void setAlarmFrequency(unsigned int freq) {
+    if(freq == 0) {
+        return;
+    }
+    unsigned int prescale = 0;
+    // smallest prescaler that fits, for the finest frequency steps
+    while(prescale < 3 && ALARM_TICKS(freq, ALARM_DIVIDER(prescale)) > 65536UL) {
+        prescale++;
+    }
+    unsigned long ticks = ALARM_TICKS(freq, ALARM_DIVIDER(prescale));
+    unsigned int period = ticks > 65536UL ? 65535 : ticks - 1;
+    
+    IEC0bits.T2IE = 0;
+    tonePrescale = prescale;
+    tonePeriod = period;
+    if(sirenPattern != SIREN_OFF || playingSound) { // kept for the next turnOnAlarm()
+        IEC0bits.T2IE = 1;
+        return;
+    }
+    if(!T2CONbits.TON) { // not playing, write the settings directly
+        T2CONbits.TCKPS = prescale;
+        PR2 = period;
+        return;
+    }
+    OC1RS = ((uint32_t) (period + 1) * dutyFraction) >> 16; // loaded at the match
+    IFS0bits.T2IF = 0; // wait for the next period match
+    IEC0bits.T2IE = 1;
+}
+
 /**
  * Turns on the alarm
  */
 void turnOnAlarm() {
+    turnOffAlarm(); // stops the siren, and writes the fixed tone to Timer2
     
     /** Configure Output Compare 1 register*/
     
     OC1CON = 0; // Reset OC1 register initially
-    OC1R = 0;
-    OC1CONbits.OCM = 0b011; // Toggle mode
+    OC1R = ((uint32_t) (tonePeriod + 1) * dutyFraction) >> 16;
+    OC1RS = OC1R; // high time, sets the volume
     OC1CONbits.OCTSEL = 0; // TMR2 clock source for output compare 
+    OC1CONbits.OCM = 0b110; // PWM mode
+    TMR2 = 0;
+    T2CONbits.TON = 1;
+}
+
+/**
+ * Turns on the alarm as a siren sweeping between 700 Hz and 1600 Hz, harder
+ * to tune out than a fixed tone. Timer2 interrupts once per period of the
+ * tone (1600 times per second at most); the interrupt only reads the next
+ * period from a table when a step is due.
+ * @param pattern SIREN_WAIL or SIREN_YELP to sweep up and down, SIREN_HILO to
+ * alternate between the lowest and the highest frequency
+ * @param sweepMs length of one cycle of the pattern in milliseconds, e.g.
+ * SIREN_WAIL_MS, SIREN_YELP_MS or SIREN_HILO_MS
+ */
+void turnOnSiren(int pattern, unsigned int sweepMs) {
+    turnOffAlarm();
+    int stepsPerCycle = 2 * (SIREN_STEPS - 1); // up then down
+    if(pattern == SIREN_HILO) {
+        stepsPerCycle = 2; // low then high
+    }
+    stepCycles = ((uint32_t) sweepMs * SIREN_TICKS_PER_MS) / stepsPerCycle;
+    if(stepCycles < 1) {
+        stepCycles = 1;
+    }
+    stepCyclesLeft = stepCycles;
+    sirenIndex = 0;
+    sirenDirection = 1;
+    sirenBusyCycles = 0;
+    sirenCycles = 0;
+    sirenPattern = pattern;
+    
+    T2CONbits.TCKPS = 0b00; // 1:1 prescale, the table is in instruction cycles
+    PR2 = sirenPeriods[0];
+    OC1CON = 0;
+    OC1R = ((uint32_t) sirenPeriods[0] * dutyFraction) >> 16;
+    OC1RS = OC1R; // high time, sets the volume
+    OC1CONbits.OCTSEL = 0; // TMR2 clock source for output compare
+    OC1CONbits.OCM = 0b110; // PWM mode, OC1RS is loaded at each period
+    TMR2 = 0;
+    IFS0bits.T2IF = 0;
+    IEC0bits.T2IE = 1;
+    T2CONbits.TON = 1;
+}
+
+/**
+ * Measures the load of the siren or the sound on the CPU since the last
+ * call, or since turnOnSiren() or playAlarmSound(): cycles spent in the
+ * Timer2 interrupt (from the period match, interrupt latency included, up to
+ * the end of the interrupt body) over the cycles elapsed. Detection keeps
+ * running as long as it stays low: the target is below 1% (100) for the
+ * siren, and about 8% (800) for a sound, whose samples are decoded in the
+ * interrupt. Call it at least every 4 minutes: the cycle counters wrap after
+ * 2^32 cycles (268 s).
+ * @return load of the Timer2 interrupt in hundredths of a percent, or 0 when
+ * neither the siren nor a sound is playing
+ */
+unsigned int getAlarmLoad() {
+    IEC0bits.T2IE = 0;
+    uint32_t busy = sirenBusyCycles;
+    uint32_t elapsed = sirenCycles;
+    sirenBusyCycles = 0;
+    sirenCycles = 0;
+    if(sirenPattern != SIREN_OFF || playingSound) {
+        IEC0bits.T2IE = 1;
+    }
+    if(elapsed == 0) {
+        return 0;
+    }
+    // busy * 10000 overflows 32 bits past 430 k busy cycles (0.3 s of sound)
+    return (uint32_t) (((uint64_t) busy * 10000) / elapsed);
+}
+
+/**
+ * Sets the volume of the alarm by changing the duty cycle of the buzzer
+ * signal: the buzzer is loudest, and draws the most current, at a 50% duty
+ * cycle. Takes effect at the next period of the tone.
+ * @param volume from 0 (silent) to 100 (50% duty cycle)
+ */
+void setAlarmVolume(unsigned int volume) {
+    if(volume > 100) {
+        volume = 100;
+    }
+    int interruptOn = IEC0bits.T2IE; // siren, or new frequency pending
+    IEC0bits.T2IE = 0;
+    dutyFraction = ((uint32_t) volume * FULL_VOLUME_DUTY) / 100;
+    OC1RS = ((uint32_t) (PR2 + 1) * dutyFraction) >> 16;
+    soundAmplitude = OC1RS; // PR2 is the carrier while a sound plays
+    IEC0bits.T2IE = interruptOn;
+}
+
+/**
+ * Starts the escalation schedule of the alarm playing: full volume for 2
+ * minutes, then 60% volume half of the time until 10 minutes, then 30% volume
+ * one second in five. The battery voltage is measured every minute; below
+ * ALARM_LOW_BATTERY_MV the schedule moves on to the second stage, below
+ * ALARM_CRITICAL_BATTERY_MV to the last one. Call updateAlarm() in the loop
+ * that waits while the alarm sounds. Stopped by turnOffAlarm().
+ */
+void startAlarmSchedule() {
+    scheduleOn = 1;
+    scheduleStage = 0;
+    batteryStage = 0;
+    scheduleSeconds = 0;
+    pulseSeconds = 0;
+    lastSecond = getTicks();
+    setAlarmVolume(alarmStages[0].volume);
+    gateAlarm(1);
+}
+
+/**
+ * Moves the escalation schedule forward. Does nothing until a second has
+ * passed since the last update, so it can be called every time the CPU wakes
+ * up (at least once a second, from the PowerManager timebase).
+ */
+void updateAlarm() {
+    if(!scheduleOn) {
+        return;
+    }
+    uint32_t now = getTicks();
+    while(now - lastSecond >= TICKS_PER_SECOND) {
+        lastSecond += TICKS_PER_SECOND;
+        scheduleSeconds++;
+        pulseSeconds++;
+        
+        if(scheduleSeconds % BATTERY_CHECK_SECONDS == 0) {
+            unsigned int millivolts = getSupplyMillivolts();
+            if(millivolts < ALARM_CRITICAL_BATTERY_MV) {
+                batteryStage = ALARM_STAGES - 1;
+            }
+            else if(millivolts < ALARM_LOW_BATTERY_MV && batteryStage < 1) {
+                batteryStage = 1;
+            }
+        }
+        int next = scheduleStage;
+        while(next < ALARM_STAGES - 1 && (next < batteryStage
+                || scheduleSeconds >= alarmStages[next + 1].startSeconds)) {
+            next++;
+        }
+        if(next != scheduleStage) { // next stage, starting with the alarm on
+            scheduleStage = next;
+            pulseSeconds = 0;
+            setAlarmVolume(alarmStages[scheduleStage].volume);
+            gateAlarm(1);
+        }
+        const AlarmStage *s = &alarmStages[scheduleStage];
+        if(s->offSeconds) {
+            if(pulseSeconds == s->onSeconds) {
+                gateAlarm(0);
+            }
+            else if(pulseSeconds >= s->onSeconds + s->offSeconds) {
+                pulseSeconds = 0;
+                gateAlarm(1);
+            }
+        }
+    }
+}
+
+/**
+ * Helper function that connects the buzzer to the tone (on = 1) or holds it
+ * low (on = 0). Timer2 and the siren keep running while the buzzer is off.
+ */
+void gateAlarm(int on) {
+    if(on) {
+        OC1CONbits.OCM = 0b110; // PWM mode
+    }
+    else {
+        OC1CONbits.OCM = 0b000; // output compare off, pin low
+    }
+}
+
+/**
+ * Plays a sound recorded in program memory, e.g. chirpSound from
+ * AlarmSounds.h. Timer2 runs a 32 kHz PWM carrier, above hearing, and the
+ * duty cycle follows the decoded 8 kHz samples, so output compare 1 works as
+ * a DAC. The volume sets the swing of the duty cycle. Cycle budget of the
+ * Timer2 interrupt: about 20 cycles for 3 carrier periods out of 4, and about
+ * 100 for the fourth one that decodes a sample, i.e. 1.3 MIPS or 8% of the
+ * CPU while the sound plays. Measure it with getAlarmLoad().
+ * @param sound sound to play
+ * @param repeats times to play the sound before the alarm turns off
+ */
+void playAlarmSound(const AdpcmSound *sound, unsigned int repeats) {
+    turnOffAlarm();
+    if(repeats == 0) {
+        return;
+    }
+    resetAdpcm(&soundState, sound);
+    soundPosition = 0;
+    soundRepeats = repeats;
+    carrierCount = CARRIERS_PER_SAMPLE;
+    sirenBusyCycles = 0;
+    sirenCycles = 0;
+    playingSound = sound;
+    
+    T2CONbits.TCKPS = 0b00; // 1:1 prescale
+    PR2 = CARRIER_PERIOD;
+    soundAmplitude = ((uint32_t) (CARRIER_PERIOD + 1) * dutyFraction) >> 16;
+    OC1CON = 0;
+    OC1R = soundAmplitude; // silence until the first sample
+    OC1RS = soundAmplitude;
+    OC1CONbits.OCTSEL = 0; // TMR2 clock source for output compare
+    OC1CONbits.OCM = 0b110; // PWM mode, OC1RS is loaded at each period
     TMR2 = 0;
+    IFS0bits.T2IF = 0;
+    IEC0bits.T2IE = 1;
     T2CONbits.TON = 1;
 }
 
+/**
+ * @return 1 while a sound started by playAlarmSound() is playing, otherwise
+ * return 0
+ */
+int isAlarmSoundPlaying() {
+    return playingSound != 0;
+}
+
 /**
  * Turns off the alarm
  */
 void turnOffAlarm() {
     OC1CON = 0; // Reset OC1 register
     T2CONbits.TON = 0;
+    IEC0bits.T2IE = 0;
+    scheduleOn = 0;
+    playingSound = 0;
+    sirenPattern = SIREN_OFF;
+    T2CONbits.TCKPS = tonePrescale; // back to the fixed tone, including a
+    PR2 = tonePeriod; // frequency that was still pending
     LATBbits.LATB14 = 0;
 }
+
+/**
+ * While a sound is playing, interrupts at every carrier period and decodes
+ * the next sample every fourth period.
+ * While the siren is playing, interrupts at every Timer2 period and moves the
+ * sweep forward once a step worth of cycles has been played. Otherwise
+ * interrupts once, at the first Timer2 period match after setAlarmFrequency()
+ * was called while the alarm was playing, and writes the new settings.
+ * Writing T2CON clears the prescaler counter, which is fine this close to the
+ * start of the period.
+ */
+void __attribute__((__interrupt__, __auto_psv__)) _T2Interrupt() {
+    IFS0bits.T2IF = 0;
+    const AdpcmSound *playing = playingSound;
+    if(playing) { // runs 32000 times per second, keep it short
+        sirenCycles += CARRIER_PERIOD + 1;
+        if(--carrierCount == 0) { // next sample
+            carrierCount = CARRIERS_PER_SAMPLE;
+            uint16_t position = soundPosition;
+            uint8_t code = playing->data[position >> 1];
+            if(position & 1) {
+                code >>= 4;
+            }
+            int16_t sample = decodeAdpcm(&soundState, code & 0x0F);
+            // duty cycle between 0 and twice soundAmplitude, at most PR2
+            OC1RS = soundAmplitude + (((int32_t) sample * soundAmplitude) >> 15);
+            if(++position >= playing->samples) { // end of the sound
+                position = 0;
+                resetAdpcm(&soundState, playing);
+                if(--soundRepeats == 0) {
+                    playingSound = 0;
+                    OC1CONbits.OCM = 0b000; // output compare off, pin low
+                    T2CONbits.TON = 0;
+                    IEC0bits.T2IE = 0;
+                }
+            }
+            soundPosition = position;
+        }
+        sirenBusyCycles += TMR2; // TMR2 counts cycles since the period match
+        return;
+    }
+    if(sirenPattern == SIREN_OFF) {
+        IEC0bits.T2IE = 0;
+        T2CONbits.TCKPS = tonePrescale;
+        PR2 = tonePeriod;
+        if(TMR2 > tonePeriod) { // held off past the new period match
+            TMR2 = 0;
+        }
+        return;
+    }
+    unsigned int period = PR2 + 1;
+    sirenCycles += period;
+    stepCyclesLeft -= period;
+    if(stepCyclesLeft <= 0) { // next step
+        stepCyclesLeft += stepCycles;
+        if(sirenPattern == SIREN_HILO) {
+            sirenIndex = (SIREN_STEPS - 1) - sirenIndex;
+        }
+        else {
+            sirenIndex += sirenDirection;
+            if(sirenIndex == 0 || sirenIndex == SIREN_STEPS - 1) {
+                sirenDirection = -sirenDirection;
+            }
+        }
+        PR2 = sirenPeriods[sirenIndex];
+        // The duty cycle follows from the next period: when the period
+        // shrinks below the old duty cycle (SIREN_HILO), the output stays high
+        // for one period, a single missing edge
+        OC1RS = ((uint32_t) sirenPeriods[sirenIndex] * dutyFraction) >> 16;
+    }
+    sirenBusyCycles += TMR2; // TMR2 counts cycles since the period match
+}
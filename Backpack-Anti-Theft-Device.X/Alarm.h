@@ -6,7 +6,19 @@
  * The library uses Timer2 and the output compare 1 register on the 
  * microcontroller. Ensure these modules are not being used elsewhere. When the
  * alarm is turned on, the library will send pulses to the buzzer with an
- * input frequency greater than 0.477 Hz.
+ * input frequency between 1 Hz and 65535 Hz. The Timer2 configuration is
+ * computed with integer arithmetic only: at compile time by initAlarm() when
+ * the frequency is a constant, and by setAlarmFrequency() at run time.
+ * turnOnSiren() plays a siren instead of a fixed tone: the Timer2 interrupt
+ * steps the tone through a table of periods computed at compile time.
+ * Output compare 1 runs in PWM mode, and the duty cycle sets the volume.
+ * startAlarmSchedule() and updateAlarm() lower the volume and pulse the alarm
+ * as it keeps sounding, and sooner when the batteries run low, so the alarm
+ * lasts for hours. The schedule uses the PowerManager library.
+ * playAlarmSound() plays a recorded sound (see AlarmSounds.h) instead: Timer2
+ * runs a 32 kHz PWM carrier, and every fourth period the Timer2 interrupt
+ * decodes the next ADPCM sample into the duty cycle, so the buzzer plays
+ * 8 kHz audio.
  *
  * Created on November 23, 2023, 4:11 PM
  */
@@ -14,27 +26,153 @@
 #ifndef ALARM_H
 #define	ALARM_H
 
+#include "Clock.h"
+#include "Adpcm.h"
+
 #ifdef	__cplusplus
 extern "C" {
 #endif
 
+// Timer2 settings for a tone of f Hz. Output compare 1 runs in PWM mode, so
+// Timer2 counts a whole period of the tone. With a constant f, the compiler
+// evaluates these to constants
+#define ALARM_DIVIDER(prescale) ((prescale) == 0 ? 1UL : (prescale) == 1 ? 8UL : \
+    (prescale) == 2 ? 64UL : 256UL) // TCKPS value to prescaler ratio
+// Timer2 counts in a period, rounded to the nearest count
+#define ALARM_TICKS(f, divider) ((FCY / (divider) + (f) / 2) / (f))
+// Smallest prescaler that fits a period in 65536 counts, for the finest
+// frequency steps
+#define ALARM_PRESCALE(f) (ALARM_TICKS(f, 1UL) <= 65536UL ? 0 : \
+    ALARM_TICKS(f, 8UL) <= 65536UL ? 1 : ALARM_TICKS(f, 64UL) <= 65536UL ? 2 : 3)
+#define ALARM_PERIOD(f) (ALARM_TICKS(f, ALARM_DIVIDER(ALARM_PRESCALE(f))) > 65536UL ? \
+    65535U : (unsigned int) (ALARM_TICKS(f, ALARM_DIVIDER(ALARM_PRESCALE(f))) - 1))
+
+// Siren patterns for turnOnSiren(), and the length of one of their cycles
+#define SIREN_WAIL 1 // slow sweep up and down
+#define SIREN_WAIL_MS 4000
+#define SIREN_YELP 2 // fast sweep up and down
+#define SIREN_YELP_MS 300
+#define SIREN_HILO 3 // two alternating tones
+#define SIREN_HILO_MS 1000
+
+// Supply voltages (2 AA cells) from which the escalation schedule saves the
+// batteries by moving on to a quieter stage
+#define ALARM_LOW_BATTERY_MV 2500 // second stage
+#define ALARM_CRITICAL_BATTERY_MV 2300 // last stage
+
 // Function declarations
-    
+
+/**
+ * Initializes pin RP14 as output for the piezoelectric buzzer, as well as 
+ * the output compare register and Timer2 used to send pulses to the buzzer.
+ * 
+ * @param freq frequency at which the alarm beeps, in Hz (1 to 65535). Use a
+ * constant so the Timer2 settings are computed at compile time; the frequency
+ * can be changed later with setAlarmFrequency()
+ */
+#define initAlarm(freq) initAlarmTimer(ALARM_PRESCALE(freq), ALARM_PERIOD(freq))
+
 /**
  * Initializes pin RP14 as output for the piezoelectric buzzer, as well as 
  * the output compare register and Timer2 used to send pulses to the buzzer.
+ * Called by initAlarm(), which works out the Timer2 settings for a frequency.
  * 
- * @param freq the minimum frequency allowed is 0.4768444343 Hz, anything lower
- * than this will overflow the period. The frequency at which that alarm beeps 
- * can be altered by the user
+ * @param prescale Timer2 prescaler (TCKPS), as given by ALARM_PRESCALE()
+ * @param period Timer2 period (PR2), as given by ALARM_PERIOD()
+ */
+void initAlarmTimer(unsigned int prescale, unsigned int period);
+
+/**
+ * Changes the frequency of the alarm. While the siren is playing, the new
+ * frequency is used by the next turnOnAlarm(). While the fixed tone is
+ * playing, the duty cycle of the new frequency is written to OC1RS right away,
+ * so it is loaded at the next period match and never exceeds the new period,
+ * and the new Timer2 settings are written by the Timer2 interrupt just after
+ * that match. If higher priority interrupts hold the Timer2 interrupt off
+ * until TMR2 has passed a shorter PR2, the interrupt restarts TMR2: that one
+ * period is stretched by the delay instead of running through 65536 counts.
+ * Uses integer divisions only; for a constant frequency, initAlarm() costs
+ * nothing at run time.
+ * @param freq frequency of the tone in Hz, from 1 to 65535
  */
-void initAlarm(double freq);
+void setAlarmFrequency(unsigned int freq);
 
 /**
  * Turns on the alarm
  */
 void turnOnAlarm();
 
+/**
+ * Turns on the alarm as a siren sweeping between 700 Hz and 1600 Hz, harder
+ * to tune out than a fixed tone. Output compare 1 runs in PWM mode, so Timer2
+ * counts a whole period of the tone and interrupts once per period (1600
+ * times per second at most); the interrupt only reads the next period from a
+ * table when a step is due.
+ * @param pattern SIREN_WAIL or SIREN_YELP to sweep up and down, SIREN_HILO to
+ * alternate between the lowest and the highest frequency
+ * @param sweepMs length of one cycle of the pattern in milliseconds, e.g.
+ * SIREN_WAIL_MS, SIREN_YELP_MS or SIREN_HILO_MS
+ */
+void turnOnSiren(int pattern, unsigned int sweepMs);
+
+/**
+ * Measures the load of the siren or the sound on the CPU since the last
+ * call, or since turnOnSiren() or playAlarmSound(): cycles spent in the
+ * Timer2 interrupt (from the period match, interrupt latency included, up to
+ * the end of the interrupt body) over the cycles elapsed. Detection keeps
+ * running as long as it stays low: the target is below 1% (100) for the
+ * siren, and about 8% (800) for a sound, whose samples are decoded in the
+ * interrupt. Call it at least every 4 minutes: the cycle counters wrap after
+ * 2^32 cycles (268 s).
+ * @return load of the Timer2 interrupt in hundredths of a percent, or 0 when
+ * neither the siren nor a sound is playing
+ */
+unsigned int getAlarmLoad();
+
+/**
+ * Sets the volume of the alarm by changing the duty cycle of the buzzer
+ * signal: the buzzer is loudest, and draws the most current, at a 50% duty
+ * cycle. Takes effect at the next period of the tone.
+ * @param volume from 0 (silent) to 100 (50% duty cycle)
+ */
+void setAlarmVolume(unsigned int volume);
+
+/**
+ * Starts the escalation schedule of the alarm playing: full volume for 2
+ * minutes, then 60% volume half of the time until 10 minutes, then 30% volume
+ * one second in five. The battery voltage is measured every minute; below
+ * ALARM_LOW_BATTERY_MV the schedule moves on to the second stage, below
+ * ALARM_CRITICAL_BATTERY_MV to the last one. Call updateAlarm() in the loop
+ * that waits while the alarm sounds. Stopped by turnOffAlarm().
+ */
+void startAlarmSchedule();
+
+/**
+ * Moves the escalation schedule forward. Does nothing until a second has
+ * passed since the last update, so it can be called every time the CPU wakes
+ * up (at least once a second, from the PowerManager timebase).
+ */
+void updateAlarm();
+
+/**
+ * Plays a sound recorded in program memory, e.g. chirpSound from
+ * AlarmSounds.h. Timer2 runs a 32 kHz PWM carrier, above hearing, and the
+ * duty cycle follows the decoded 8 kHz samples, so output compare 1 works as
+ * a DAC. The volume sets the swing of the duty cycle. Cycle budget of the
+ * Timer2 interrupt: about 20 cycles for 3 carrier periods out of 4, and about
+ * 100 for the fourth one that decodes a sample, i.e. 1.3 MIPS or 8% of the
+ * CPU while the sound plays. Measure it with getAlarmLoad().
+ * @param sound sound to play
+ * @param repeats times to play the sound before the alarm turns off
+ */
+void playAlarmSound(const AdpcmSound *sound, unsigned int repeats);
+
+/**
+ * @return 1 while a sound started by playAlarmSound() is playing, otherwise
+ * return 0
+ */
+int isAlarmSoundPlaying();
+
 /**
  * Turns off the alarm
  */
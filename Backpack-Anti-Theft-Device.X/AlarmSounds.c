@@ -0,0 +1,180 @@
+/*
+ * File:   AlarmSounds.c
+ * Sounds played by playAlarmSound(), generated by other_files/adpcm/adpcm_encode.
+ * 4-bit IMA-ADPCM at 8 kHz, two samples per byte.
+ */
+
+#include "stdint.h"
+#include "Adpcm.h"
+#include "AlarmSounds.h"
+
+const uint8_t __attribute__((space(auto_psv))) chirpData[2000] = {
+    0x70, 0xD7, 0xFF, 0x6F, 0x37, 0xF9, 0xAB, 0x52, 0x14, 0xD9, 0x9B, 0x61,
+    0x13, 0xDA, 0x9B, 0x62, 0x02, 0xD9, 0x8A, 0x42, 0x03, 0xEB, 0x0A, 0x52,
+    0x82, 0xCB, 0x0A, 0x63, 0x81, 0xCB, 0x1A, 0x44, 0xA1, 0xCB, 0x29, 0x25,
+    0xB1, 0xBC, 0x38, 0x26, 0xB8, 0x9C, 0x30, 0x15, 0xB9, 0x9C, 0x42, 0x12,
+    0xCB, 0x0B, 0x53, 0x82, 0xBC, 0x09, 0x44, 0xA1, 0xCB, 0x28, 0x24, 0xB0,
+    0xAC, 0x40, 0x23, 0xD9, 0x9B, 0x52, 0x02, 0xCB, 0x1A, 0x43, 0xA2, 0xBC,
+    0x39, 0x25, 0xB0, 0x9D, 0x30, 0x14, 0xC9, 0x8B, 0x52, 0x82, 0xCB, 0x19,
+    0x53, 0xA0, 0xAC, 0x30, 0x14, 0xC8, 0x9B, 0x52, 0x02, 0xDB, 0x19, 0x33,
+    0xB1, 0xAD, 0x30, 0x15, 0xC9, 0x9A, 0x43, 0x82, 0xBC, 0x29, 0x34, 0xC0,
+    0xBB, 0x51, 0x13, 0xCB, 0x0B, 0x44, 0x91, 0xBC, 0x30, 0x14, 0xB9, 0x8D,
+    0x42, 0x82, 0xBC, 0x28, 0x24, 0xB8, 0x9D, 0x32, 0x84, 0xCB, 0x19, 0x34,
+    0xB0, 0xAD, 0x41, 0x03, 0xCB, 0x1A, 0x34, 0xB0, 0x9D, 0x40, 0x03, 0xCB,
+    0x1A, 0x34, 0xB0, 0x9D, 0x40, 0x03, 0xCB, 0x1A, 0x34, 0xB0, 0x9D, 0x41,
+    0x02, 0xDB, 0x29, 0x33, 0xC8, 0x9C, 0x42, 0x82, 0xCB, 0x39, 0x24, 0xC9,
+    0x8B, 0x53, 0x91, 0xAC, 0x30, 0x14, 0xDA, 0x1A, 0x43, 0xB0, 0x9C, 0x41,
+    0x02, 0xBC, 0x39, 0x24, 0xD8, 0x8A, 0x43, 0xA1, 0xAC, 0x40, 0x03, 0xCB,
+    0x2A, 0x34, 0xC8, 0x8C, 0x42, 0x91, 0xCB, 0x30, 0x14, 0xCB, 0x19, 0x24,
+    0xB8, 0x9C, 0x53, 0x91, 0xAC, 0x30, 0x04, 0xDA, 0x29, 0x23, 0xD8, 0x8A,
+    0x43, 0xA1, 0x9D, 0x31, 0x83, 0xCC, 0x38, 0x23, 0xEA, 0x09, 0x33, 0xC0,
+    0x8C, 0x42, 0x91, 0xAC, 0x31, 0x84, 0xCB, 0x28, 0x24, 0xDA, 0x09, 0x24,
+    0xB8, 0x9B, 0x44, 0x90, 0xAC, 0x41, 0x82, 0xAC, 0x48, 0x12, 0xCB, 0x29,
+    0x24, 0xD9, 0x1A, 0x33, 0xC8, 0x8B, 0x53, 0xA1, 0x9D, 0x41, 0x92, 0xAC,
+    0x40, 0x02, 0xCB, 0x28, 0x14, 0xCA, 0x19, 0x24, 0xC9, 0x0A, 0x24, 0xC0,
+    0x0B, 0x43, 0xB0, 0x9C, 0x43, 0xA1, 0xAC, 0x42, 0x92, 0xAC, 0x40, 0x83,
+    0xBC, 0x48, 0x03, 0xDB, 0x38, 0x13, 0xDB, 0x29, 0x15, 0xBA, 0x1A, 0x25,
+    0xC9, 0x1A, 0x24, 0xB9, 0x0C, 0x34, 0xC8, 0x0B, 0x24, 0xB0, 0x8C, 0x43,
+    0xB0, 0x8C, 0x43, 0xA0, 0x8D, 0x32, 0xB1, 0x8D, 0x42, 0xA1, 0x9D, 0x42,
+    0xA1, 0x9C, 0x42, 0xA1, 0xAB, 0x62, 0xA1, 0x9C, 0x42, 0xA1, 0x9C, 0x42,
+    0xA1, 0x9C, 0x42, 0xA1, 0x9C, 0x42, 0xA1, 0x9C, 0x42, 0xA1, 0x9C, 0x42,
+    0xA1, 0x9C, 0x33, 0xB1, 0x9D, 0x43, 0xB0, 0x9B, 0x35, 0xC0, 0x0B, 0x43,
+    0xB8, 0x0C, 0x24, 0xC8, 0x0A, 0x25, 0xC9, 0x1A, 0x24, 0xCA, 0x29, 0x14,
+    0xBB, 0x39, 0x05, 0xBB, 0x59, 0x83, 0xCB, 0x40, 0x82, 0xAC, 0x50, 0xA2,
+    0x9C, 0x42, 0xB1, 0x9B, 0x53, 0xB0, 0x0C, 0x43, 0xC8, 0x0A, 0x24, 0xC9,
+    0x19, 0x14, 0xCA, 0x28, 0x04, 0xCB, 0x30, 0x83, 0xAD, 0x41, 0x91, 0x9C,
+    0x42, 0xB0, 0x0B, 0x34, 0xD8, 0x1A, 0x14, 0xC9, 0x29, 0x04, 0xBB, 0x40,
+    0x93, 0xAD, 0x42, 0xA1, 0x8C, 0x42, 0xB8, 0x1B, 0x25, 0xCA, 0x29, 0x14,
+    0xCB, 0x30, 0x93, 0xAD, 0x42, 0xA1, 0x8C, 0x42, 0xB8, 0x1B, 0x25, 0xCA,
+    0x39, 0x84, 0xBB, 0x41, 0xA3, 0x9E, 0x43, 0xC0, 0x0A, 0x24, 0xD9, 0x39,
+    0x04, 0xAC, 0x40, 0xA2, 0x9C, 0x43, 0xC0, 0x0A, 0x24, 0xCA, 0x28, 0x84,
+    0xBB, 0x61, 0xA1, 0x8C, 0x33, 0xD8, 0x2A, 0x04, 0xCA, 0x30, 0xA3, 0x9D,
+    0x42, 0xB0, 0x0B, 0x16, 0xCA, 0x38, 0x83, 0xAD, 0x42, 0xB1, 0x0C, 0x24,
+    0xCA, 0x39, 0x84, 0xBB, 0x61, 0xB1, 0x0C, 0x33, 0xE9, 0x39, 0x84, 0xBB,
+    0x61, 0xB1, 0x0C, 0x33, 0xDA, 0x39, 0x84, 0xAC, 0x42, 0xB1, 0x0C, 0x24,
+    0xCA, 0x49, 0x82, 0xAC, 0x43, 0xB8, 0x2B, 0x15, 0xCB, 0x40, 0xA2, 0x9C,
+    0x24, 0xD8, 0x29, 0x85, 0xBB, 0x52, 0xC1, 0x1B, 0x24, 0xCB, 0x30, 0xA3,
+    0x9D, 0x43, 0xC8, 0x3A, 0x84, 0xBB, 0x52, 0xC1, 0x0A, 0x15, 0xCB, 0x40,
+    0xA2, 0x8C, 0x33, 0xE9, 0x49, 0x82, 0xAC, 0x43, 0xC8, 0x3A, 0x04, 0xAC,
+    0x51, 0xB0, 0x1C, 0x14, 0xCB, 0x31, 0xB2, 0x0D, 0x24, 0xCB, 0x30, 0xA3,
+    0x8E, 0x24, 0xD9, 0x38, 0x93, 0x8E, 0x33, 0xD9, 0x39, 0x94, 0x9C, 0x43,
+    0xD8, 0x39, 0x84, 0xAC, 0x43, 0xC8, 0x3A, 0x84, 0x9C, 0x42, 0xC8, 0x29,
+    0x84, 0xBB, 0x34, 0xC8, 0x3A, 0x84, 0xAC, 0x43, 0xC8, 0x3A, 0x84, 0x9C,
+    0x42, 0xC8, 0x39, 0x94, 0x9C, 0x43, 0xC9, 0x49, 0x92, 0x9C, 0x34, 0xDA,
+    0x48, 0xA2, 0x8C, 0x24, 0xDA, 0x40, 0xB2, 0x0C, 0x15, 0xBC, 0x42, 0xC1,
+    0x2B, 0x05, 0xAC, 0x42, 0xC8, 0x39, 0x94, 0x9C, 0x24, 0xD9, 0x48, 0xA2,
+    0x8C, 0x15, 0xCB, 0x41, 0xC1, 0x1A, 0x05, 0xAC, 0x42, 0xC8, 0x39, 0x94,
+    0x9C, 0x34, 0xCB, 0x40, 0xB1, 0x1C, 0x14, 0xAC, 0x42, 0xC8, 0x39, 0x94,
+    0x9C, 0x24, 0xCA, 0x40, 0xB1, 0x1C, 0x05, 0xAC, 0x52, 0xC9, 0x49, 0xA3,
+    0x0D, 0x14, 0xCB, 0x51, 0xC0, 0x2A, 0x95, 0x9C, 0x24, 0xCA, 0x40, 0xB1,
+    0x2C, 0x84, 0x9C, 0x43, 0xD9, 0x48, 0xB2, 0x1C, 0x05, 0xAC, 0x52, 0xC9,
+    0x49, 0xA2, 0x0C, 0x05, 0xAC, 0x52, 0xC9, 0x38, 0xB3, 0x0D, 0x05, 0xAC,
+    0x43, 0xC9, 0x48, 0xB2, 0x1C, 0x04, 0xAC, 0x43, 0xC9, 0x48, 0xC2, 0x2B,
+    0x85, 0x9C, 0x43, 0xCA, 0x40, 0xC1, 0x2A, 0x95, 0x8C, 0x14, 0xBB, 0x61,
+    0xD0, 0x49, 0xA2, 0x0C, 0x05, 0xAC, 0x43, 0xD9, 0x40, 0xB1, 0x2C, 0x84,
+    0x9C, 0x15, 0xCB, 0x42, 0xC8, 0x49, 0xA2, 0x1D, 0x85, 0x9C, 0x43, 0xCA,
+    0x50, 0xD0, 0x39, 0xA4, 0x0C, 0x05, 0xAC, 0x43, 0xCA, 0x41, 0xC0, 0x4A,
+    0xA3, 0x0D, 0x05, 0xAC, 0x34, 0xCB, 0x50, 0xD0, 0x49, 0xA2, 0x1D, 0x85,
+    0x9C, 0x24, 0xCB, 0x51, 0xD8, 0x48, 0xB2, 0x2C, 0x94, 0x8C, 0x24, 0xBC,
+    0x43, 0xC9, 0x40, 0xD1, 0x4A, 0xB3, 0x1C, 0x04, 0x9D, 0x25, 0xBC, 0x43,
+    0xC9, 0x58, 0xC1, 0x3A, 0xA4, 0x1D, 0x85, 0x9C, 0x24, 0xCB, 0x42, 0xC9,
+    0x40, 0xD1, 0x39, 0xB3, 0x1D, 0x95, 0x8C, 0x15, 0xBC, 0x34, 0xCB, 0x51,
+    0xD8, 0x48, 0xC2, 0x3B, 0xA4, 0x1C, 0x85, 0x8D, 0x24, 0xBC, 0x34, 0xDA,
+    0x41, 0xD0, 0x48, 0xC1, 0x3A, 0xA4, 0x1C, 0x95, 0x8C, 0x05, 0x9C, 0x33,
+    0xDB, 0x42, 0xD9, 0x50, 0xD0, 0x48, 0xB1, 0x3B, 0xA5, 0x1C, 0x95, 0x8C,
+    0x05, 0x9C, 0x24, 0xBC, 0x53, 0xCA, 0x41, 0xD8, 0x40, 0xD1, 0x49, 0xC2,
+    0x3A, 0xA4, 0x1C, 0x84, 0x0D, 0x05, 0x9D, 0x15, 0xAC, 0x43, 0xBB, 0x52,
+    0xD9, 0x51, 0xD8, 0x58, 0xD1, 0x49, 0xC2, 0x4B, 0xB3, 0x2C, 0x94, 0x1D,
+    0x84, 0x8C, 0x05, 0x8D, 0x14, 0xAC, 0x34, 0xBC, 0x43, 0xCA, 0x42, 0xD9,
+    0x51, 0xD8, 0x58, 0xD0, 0x48, 0xC1, 0x5A, 0xC2, 0x4B, 0xB3, 0x2C, 0xA4,
+    0x1C, 0x95, 0x1D, 0x84, 0x0D, 0x05, 0x8D, 0x14, 0x9D, 0x15, 0xAC, 0x24,
+    0xCB, 0x24, 0xCB, 0x43, 0xCB, 0x52, 0xCA, 0x51, 0xCA, 0x41, 0xD8, 0x50,
+    0xD8, 0x50, 0xD0, 0x48, 0xD1, 0x59, 0xD1, 0x59, 0xC1, 0x4A, 0xC2, 0x4A,
+    0xC2, 0x4A, 0xB2, 0x3C, 0xC4, 0x3A, 0xB4, 0x3C, 0xB4, 0x3C, 0xB4, 0x3C,
+    0xB4, 0x2C, 0xA5, 0x2D, 0xA5, 0x2D, 0xA5, 0x2D, 0xA5, 0x1C, 0xA5, 0x1C,
+    0xA5, 0x1C, 0xA5, 0x1C, 0x95, 0x1D, 0xA5, 0x1C, 0x95, 0x1D, 0xA5, 0x2C,
+    0xA4, 0x2C, 0xA4, 0x2C, 0xA4, 0x2C, 0xA4, 0x2C, 0xA4, 0x2C, 0xA4, 0x3C,
+    0xB3, 0x3D, 0xB4, 0x3C, 0xC4, 0x3A, 0xC4, 0x4A, 0xC2, 0x4A, 0xD2, 0x49,
+    0xD2, 0x59, 0xD1, 0x59, 0xD0, 0x58, 0xD0, 0x50, 0xD8, 0x50, 0xD9, 0x51,
+    0xD9, 0x42, 0xCA, 0x42, 0xCA, 0x33, 0xDB, 0x24, 0xAC, 0x24, 0xAC, 0x15,
+    0x9D, 0x06, 0x8D, 0x85, 0x0D, 0x96, 0x1D, 0xA5, 0x2C, 0xA4, 0x3C, 0xC3,
+    0x4B, 0xD3, 0x5A, 0xD1, 0x58, 0xD0, 0x58, 0xD8, 0x51, 0xD9, 0x42, 0xCA,
+    0x42, 0xBB, 0x24, 0xAC, 0x15, 0x8D, 0x05, 0x0E, 0x96, 0x1D, 0xA5, 0x2C,
+    0xB4, 0x4B, 0xC2, 0x5A, 0xD1, 0x58, 0xD8, 0x51, 0xCA, 0x42, 0xBB, 0x34,
+    0xAD, 0x15, 0x8D, 0x85, 0x1D, 0xA5, 0x2C, 0xB4, 0x4B, 0xD3, 0x5A, 0xD1,
+    0x58, 0xD8, 0x51, 0xCA, 0x33, 0xBC, 0x15, 0x8D, 0x05, 0x1E, 0xA5, 0x2C,
+    0xB4, 0x5B, 0xD2, 0x59, 0xE0, 0x51, 0xCA, 0x42, 0xBB, 0x25, 0x9D, 0x05,
+    0x1E, 0xA5, 0x2C, 0xB4, 0x5B, 0xE2, 0x58, 0xD8, 0x51, 0xCA, 0x33, 0xAD,
+    0x06, 0x0D, 0x95, 0x2D, 0xB4, 0x5B, 0xE2, 0x58, 0xD8, 0x51, 0xCA, 0x33,
+    0x9D, 0x05, 0x1E, 0xA5, 0x3C, 0xD3, 0x5A, 0xD1, 0x68, 0xCA, 0x42, 0xBB,
+    0x15, 0x0D, 0x95, 0x2D, 0xB4, 0x5B, 0xD1, 0x50, 0xD9, 0x42, 0xBB, 0x16,
+    0x0E, 0x95, 0x3D, 0xC3, 0x5A, 0xD0, 0x50, 0xD9, 0x33, 0x9D, 0x05, 0x1E,
+    0xA5, 0x3C, 0xD3, 0x59, 0xD8, 0x42, 0xBB, 0x15, 0x8D, 0x96, 0x3D, 0xD3,
+    0x59, 0xE0, 0x51, 0xCA, 0x33, 0x8E, 0x85, 0x2D, 0xC4, 0x5A, 0xE1, 0x51,
+    0xCB, 0x24, 0x8D, 0x85, 0x3E, 0xC4, 0x5A, 0xD0, 0x51, 0xCB, 0x24, 0x8D,
+    0x95, 0x3D, 0xD4, 0x69, 0xE8, 0x52, 0xAC, 0x05, 0x1D, 0xB5, 0x4C, 0xE2,
+    0x50, 0xD9, 0x24, 0x9D, 0x96, 0x3D, 0xC4, 0x6A, 0xD8, 0x51, 0xAC, 0x05,
+    0x1D, 0xB5, 0x5C, 0xE1, 0x60, 0xCB, 0x15, 0x8D, 0xA6, 0x3C, 0xE3, 0x58,
+    0xD9, 0x24, 0x8D, 0x95, 0x4D, 0xD2, 0x58, 0xD9, 0x43, 0x8D, 0x95, 0x3D,
+    0xD4, 0x69, 0xD9, 0x43, 0x9D, 0x96, 0x3D, 0xD4, 0x69, 0xD9, 0x33, 0x8D,
+    0x95, 0x4D, 0xD2, 0x58, 0xD9, 0x24, 0x0E, 0xA5, 0x4C, 0xE2, 0x50, 0xCA,
+    0x14, 0x1D, 0xC5, 0x5A, 0xD0, 0x51, 0xAC, 0x05, 0x3E, 0xD3, 0x69, 0xD9,
+    0x33, 0x8E, 0xA6, 0x4C, 0xD1, 0x50, 0xCA, 0x05, 0x2E, 0xB4, 0x6B, 0xE0,
+    0x33, 0x9D, 0x96, 0x4D, 0xE2, 0x50, 0xCA, 0x05, 0x2E, 0xC4, 0x59, 0xD8,
+    0x33, 0x8E, 0xA6, 0x4C, 0xE1, 0x51, 0xBB, 0x86, 0x3D, 0xE3, 0x68, 0xCA,
+    0x14, 0x1E, 0xB5, 0x6B, 0xD8, 0x33, 0x8E, 0xA6, 0x4C, 0xE1, 0x42, 0x9C,
+    0x85, 0x3D, 0xF3, 0x60, 0xBB, 0x86, 0x2D, 0xD4, 0x68, 0xCA, 0x14, 0x2E,
+    0xC4, 0x59, 0xD9, 0x24, 0x1E, 0xC5, 0x6A, 0xD9, 0x24, 0x1E, 0xC5, 0x6A,
+    0xE8, 0x24, 0x0E, 0xB6, 0x6B, 0xD8, 0x33, 0x0F, 0xC6, 0x6A, 0xE8, 0x24,
+    0x0E, 0xC6, 0x6A, 0xE8, 0x24, 0x1E, 0xC5, 0x6A, 0xD9, 0x24, 0x1E, 0xC5,
+    0x6A, 0xD9, 0x24, 0x1E, 0xD5, 0x58, 0xCA, 0x05, 0x3E, 0xE3, 0x50, 0xBB,
+    0x87, 0x4E, 0xE2, 0x51, 0xAC, 0x96, 0x5D, 0xD0, 0x42, 0x8D, 0xB6, 0x6B,
+    0xD8, 0x23, 0x1E, 0xC5, 0x6A, 0xCA, 0x05, 0x3E, 0xE3, 0x50, 0xAB, 0x96,
+    0x5D, 0xD0, 0x42, 0x8D, 0xB6, 0x6B, 0xD8, 0x14, 0x2E, 0xD4, 0x68, 0xBB,
+    0x97, 0x4D, 0xE1, 0x42, 0x0D, 0xB5, 0x7B, 0xD9, 0x05, 0x2D, 0xE4, 0x51,
+    0xAC, 0x96, 0x5D, 0xE0, 0x24, 0x1E, 0xD5, 0x58, 0xBA, 0x96, 0x5D, 0xE1,
+    0x42, 0x0D, 0xC5, 0x6A, 0xBA, 0x86, 0x3D, 0xE2, 0x42, 0x8D, 0xC6, 0x6A,
+    0xD9, 0x05, 0x4E, 0xE2, 0x42, 0x8D, 0xC6, 0x6A, 0xBA, 0x86, 0x4D, 0xE1,
+    0x42, 0x0D, 0xC5, 0x69, 0xBB, 0x86, 0x4D, 0xE1, 0x33, 0x1F, 0xD5, 0x68,
+    0x9C, 0xB6, 0x6B, 0xD8, 0x14, 0x3E, 0xE2, 0x51, 0x8D, 0xC6, 0x69, 0xBB,
+    0x96, 0x5C, 0xD8, 0x14, 0x2E, 0xD4, 0x50, 0x8D, 0xB6, 0x6A, 0xCA, 0x96,
+    0x5D, 0xE0, 0x14, 0x3E, 0xE3, 0x41, 0x0D, 0xC5, 0x69, 0xBB, 0x97, 0x5D,
+    0xD8, 0x05, 0x4E, 0xF2, 0x33, 0x0E, 0xD5, 0x50, 0x9C, 0xB6, 0x7B, 0xCA,
+    0x96, 0x5D, 0xE0, 0x14, 0x4E, 0xF2, 0x33, 0x1F, 0xD5, 0x50, 0x9C, 0xC6,
+    0x69, 0xBB, 0xA7, 0x6C, 0xD9, 0x05, 0x4E, 0xE1, 0x14, 0x3E, 0xF3, 0x42,
+    0x1E, 0xD5, 0x50, 0x8D, 0xC6, 0x69, 0x9C, 0xB6, 0x7B, 0xCA, 0x96, 0x5D,
+    0xD8, 0x05, 0x5E, 0xE0, 0x14, 0x3E, 0xF3, 0x23, 0x2E, 0xF3, 0x42, 0x0D,
+    0xD5, 0x50, 0x0D, 0xD5, 0x68, 0x9C, 0xC6, 0x69, 0xAB, 0xB6, 0x7A, 0xBB,
+    0xA7, 0x6B, 0xC9, 0x95, 0x5C, 0xC9, 0x85, 0x5D, 0xD8, 0x85, 0x4D, 0xD0,
+    0x04, 0x4D, 0xE1, 0x14, 0x4E, 0xE1, 0x23, 0x4F, 0xE1, 0x14, 0x3E, 0xE2,
+    0x23, 0x3F, 0xE2, 0x23, 0x3F, 0xF3, 0x23, 0x3F, 0xF3, 0x32, 0x3F, 0xF3,
+    0x32, 0x3F, 0xF3, 0x23, 0x3F, 0xE2, 0x23, 0x3F, 0xE2, 0x23, 0x3F, 0xE2,
+    0x23, 0x4F, 0xE1, 0x14, 0x4E, 0xE1, 0x04, 0x4D, 0xD0, 0x04, 0x4D, 0xD0,
+    0x04, 0x5D, 0xD8, 0x95, 0x5C, 0xC9, 0x95, 0x6C, 0xCA, 0xA6, 0x6B, 0xBA,
+    0xB7, 0x7A, 0x9C, 0xC6, 0x69, 0x8C, 0xD5, 0x50, 0x0D, 0xD5, 0x41, 0x2E,
+    0xE4, 0x32, 0x3F, 0xE2, 0x23, 0x4F, 0xE1, 0x04, 0x5D, 0xD8, 0x95, 0x6C,
+    0xCA, 0xB6, 0x7A, 0x9C, 0xC6, 0x69, 0x8C, 0xD5, 0x41, 0x1D, 0xE4, 0x23,
+    0x4F, 0xE1, 0x14, 0x5E, 0xD8, 0x95, 0x6C, 0xCA, 0xB6, 0x7A, 0x9C, 0xD6,
+    0x50, 0x1D, 0xE4, 0x32, 0x4F, 0xE1, 0x14, 0x5E, 0xD8, 0x95, 0x6C, 0xAB,
+    0xC7, 0x69, 0x0D, 0xD5, 0x41, 0x3E, 0xF2, 0x14, 0x5E, 0xD8, 0x95, 0x6C,
+    0xAB, 0xC7, 0x69, 0x0D, 0xE5, 0x42, 0x3E, 0xF2, 0x04, 0x5D, 0xC9, 0xB6,
+    0x7A, 0x8C, 0xD5, 0x50, 0x3E, 0xF2, 0x14, 0x5E, 0xD8, 0xA6, 0x7B, 0x9C,
+    0xD6, 0x50, 0x2E, 0xF3, 0x14, 0x5E, 0xD8, 0xA6, 0x7B, 0x9C, 0xD6, 0x41,
+    0x3E, 0xF2, 0x04, 0x5D, 0xC9, 0xB6, 0x7A, 0x0D, 0xE5, 0x32, 0x4F, 0xE1,
+    0x95, 0x6C, 0xAB, 0xD7, 0x50, 0x3E, 0xF2, 0x04, 0x6D, 0xBA, 0xC7, 0x69,
+    0x1D, 0xE4, 0x23, 0x5F, 0xD8, 0xB6, 0x7A, 0x8C, 0xE5, 0x32, 0x4F, 0xD0,
+    0xA6, 0x7B, 0x8C, 0xD5, 0x31, 0x4F, 0xE1, 0x95, 0x7B, 0x9C, 0xD6, 0x31,
+    0x4F, 0xE1, 0x95, 0x7B, 0x8C, 0xE5, 0x32, 0x4F, 0xD0, 0xA6, 0x7B, 0x0D,
+    0xE5, 0x23, 0x5F, 0xD8, 0xB6, 0x7A, 0x1D, 0xF3, 0x14, 0x5E, 0xB9, 0xD7,
+    0x50, 0x3E, 0xF2, 0x95, 0x6C, 0x9B, 0xE6, 0x32, 0x4F, 0xD0, 0xB6, 0x7A,
+    0x1D, 0xE4, 0x13, 0x5E, 0xB9, 0xD7, 0x50, 0x3E, 0xE1, 0x95, 0x7B, 0x0D,
+    0xE5, 0x13, 0x5E, 0xB9, 0xD7, 0x50, 0x3E, 0xE1, 0x95, 0x7B, 0x0D, 0xE5,
+    0x13, 0x6E, 0xAB, 0xD7, 0x31, 0x4F, 0xD0, 0xB6, 0x69, 0x2E, 0xF3, 0x95,
+    0x6C, 0x8C, 0xE6, 0x13, 0x5E, 0xAA, 0xD7, 0x40, 0x5E, 0xD8, 0xB6, 0x69,
+    0x3E, 0xF2, 0x95, 0x7B, 0x0D, 0xE5, 0x04, 0x6D, 0x8C, 0xE5, 0x23, 0x5F,
+    0xB9, 0xD7, 0x31, 0x5F, 0xD8, 0xC6, 0x58, 0x3D, 0xD0, 0xA5, 0x6A, 0x2D,
+    0xE2, 0x94, 0x5A, 0x0B, 0xD3, 0x83, 0x5B, 0x0B, 0xD3, 0x02, 0x4B, 0x0A,
+    0xC2, 0x02, 0x4B, 0x8A, 0xC3, 0x02, 0x4B, 0x99, 0xB3, 0x11, 0x3C, 0x99,
+    0xB4, 0x11, 0x3B, 0x99, 0xB3, 0x11, 0x1A, 0x88};
+
+const AdpcmSound chirpSound = {chirpData, 4000, 0, 0};
@@ -0,0 +1,27 @@
+/*
+ * File:   AlarmSounds.h
+ * Author: Sharmarke Ahmed
+ * Sounds for playAlarmSound(), stored in program memory as 4-bit IMA-ADPCM
+ * at 8 kHz. AlarmSounds.c is generated by the encoder in other_files/adpcm:
+ * run it again to replace the chirp with a recorded voice.
+ *
+ * Created on December 12, 2023, 3:30 PM
+ */
+
+#ifndef ALARMSOUNDS_H
+#define	ALARMSOUNDS_H
+
+#include "Adpcm.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// 0.5 s chirp sweeping up from 1 kHz to 3 kHz
+extern const AdpcmSound chirpSound;
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ALARMSOUNDS_H */
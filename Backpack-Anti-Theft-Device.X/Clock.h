@@ -0,0 +1,20 @@
+/*
+ * File:   Clock.h
+ * Author: Sharmarke Ahmed
+ * Instruction clock of the PIC24FJ64GA002, shared by the libraries that derive
+ * baud rates and timer periods from it at compile time. Every library runs the
+ * oscillator with CLKDIVbits.RCDIV = 0 (8 MHz FRC with the 4x PLL), which
+ * gives a 16 MHz instruction clock. Define FCY before including this header
+ * (or on the compiler command line) to build for another clock.
+ *
+ * Created on December 13, 2023, 10:20 AM
+ */
+
+#ifndef CLOCK_H
+#define	CLOCK_H
+
+#ifndef FCY
+#define FCY 16000000UL // instruction clock (RCDIV = 0)
+#endif
+
+#endif	/* CLOCK_H */
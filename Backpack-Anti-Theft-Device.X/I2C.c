@@ -0,0 +1,411 @@
+/*
+ * File:   I2C.c
+ * Author: Sharmarke Ahmed
+ * The I2C library is an interrupt-driven master driver for the I2C1 module of
+ * the PIC24FJ64GA002. Transactions are described by an I2CTransaction and
+ * queued with submitI2CTransaction(); the _MI2C1Interrupt state machine then
+ * clocks the whole transaction out without the CPU waiting on the bus. The
+ * status field of the transaction (and its optional callback) reports when it
+ * has finished. Every bus phase (start, byte, acknowledge, stop) must complete
+ * within I2C_PHASE_TIMEOUT: a phase that takes longer is treated as a stuck
+ * bus, which is recovered by clocking SCL nine times and sending a stop
+ * condition. A failed transaction (timeout or missing acknowledge) is retried
+ * up to I2C_MAX_RETRIES times, so every transaction finishes in a bounded
+ * time. The library uses the I2C1 module and Timer5 on the microcontroller.
+ * Ensure that these modules are not being used elsewhere.
+ * Initialize the driver with the initI2C() function before submitting
+ * transactions.
+ *
+ * Created on December 4, 2023, 1:15 PM
+ */
+
+
+#include "xc.h"
+#include "stdint.h"
+#include "I2C.h"
+
+// States of the transaction state machine. Each state names the bus event the
+// driver is waiting on; the master I2C1 interrupt fires when it completes.
+#define STATE_IDLE 0
+#define STATE_START 1 // start condition
+#define STATE_ADDRESS_WRITE 2 // slave address with write bit
+#define STATE_REGISTER 3 // register sub-address
+#define STATE_WRITE_DATA 4 // data byte sent
+#define STATE_RESTART 5 // repeated start condition
+#define STATE_ADDRESS_READ 6 // slave address with read bit
+#define STATE_READ_DATA 7 // data byte received
+#define STATE_ACK 8 // ACK/NACK sent
+#define STATE_STOP 9 // stop condition
+
+// Function declarations
+void initI2C();
+int submitI2CTransaction(I2CTransaction *transaction);
+int runI2CTransaction(I2CTransaction *transaction);
+int isI2CIdle();
+uint16_t getI2CLastTime();
+uint16_t getI2CMaxTime();
+uint16_t getI2CErrorCount();
+uint16_t getI2CTimeoutCount();
+uint16_t getI2CRetryCount();
+void resetI2CCounters();
+void startNextTransaction();
+void finishTransaction();
+void recoverBus();
+void busDelay();
+void __attribute__((__interrupt__, __auto_psv__)) _MI2C1Interrupt();
+void __attribute__((__interrupt__, __auto_psv__)) _T5Interrupt();
+
+// Circular queue of transactions. The head is the transaction on the bus
+volatile I2CTransaction *queue[I2C_QUEUE_SIZE];
+volatile uint8_t queueHead = 0;
+volatile uint8_t queueCount = 0;
+
+volatile uint8_t state = STATE_IDLE;
+volatile uint8_t byteIndex = 0; // next data byte of the current transaction
+volatile uint8_t transactionFailed = 0; // current attempt NACKed or timed out
+volatile uint8_t retries = 0; // attempts of the current transaction that failed
+
+// Transaction timing, in Timer5 ticks, and error counters
+volatile uint16_t transactionTime = 0; // bus time of the current transaction
+volatile uint16_t lastTime = 0;
+volatile uint16_t maxTime = 0;
+volatile uint16_t errorCount = 0;
+volatile uint16_t timeoutCount = 0;
+volatile uint16_t retryCount = 0;
+
+/**
+ * Initializes the I2C1 module of the microcontroller for an I2C_FSCL bus and
+ * enables the master I2C1 interrupt used by the transaction state machine.
+ */
+void initI2C() {
+    CLKDIVbits.RCDIV = 0; // 16MHz instruction clock
+    // Note: SDA1/SCL1 are not analog pins; don't need to set to digital mode
+    TRISBbits.TRISB8 = 0;
+    TRISBbits.TRISB9 = 0;
+    
+    // Initially turn off I2C when setting baud rate generator
+    I2C1CONbits.I2CEN = 0;
+    IEC1bits.MI2C1IE = 0;
+    IFS1bits.MI2C1IF = 0;
+    
+    queueHead = 0;
+    queueCount = 0;
+    state = STATE_IDLE;
+    
+    lastTime = 0;
+    resetI2CCounters();
+    // Timer5 is the phase watchdog: it is cleared at the start of every phase
+    // and interrupts if it reaches I2C_PHASE_TIMEOUT first
+    T5CON = 0;
+    TMR5 = 0;
+    PR5 = I2C_PHASE_TIMEOUT;
+    T5CONbits.TCKPS = 0b01; // 1:8 prescale
+    IFS1bits.T5IF = 0;
+    IEC1bits.T5IE = 1; // same priority as the I2C1 interrupt, so they never nest
+    
+    I2C1BRG = I2C_BRG(I2C_FSCL); // computed at compile time from FCY
+    I2C1CONbits.DISSLW = I2C_DISSLW;
+    I2C1CONbits.I2CEN = 1; // Turn on I2C
+    IEC1bits.MI2C1IE = 1; // Enable master I2C1 interrupts
+}
+
+/**
+ * Adds a transaction to the queue. If the bus is idle, the transaction is
+ * started immediately. Can be called from a transaction callback.
+ * @param transaction the transaction to queue
+ * @return 1 if the transaction was queued, 0 if the queue is full
+ */
+int submitI2CTransaction(I2CTransaction *transaction) {
+    int queued = 0;
+    // Keep the state machine and the watchdog out while the queue changes:
+    // both retire transactions
+    int enabled = IEC1bits.MI2C1IE;
+    int watchdogEnabled = IEC1bits.T5IE;
+    IEC1bits.MI2C1IE = 0;
+    IEC1bits.T5IE = 0;
+    if(queueCount < I2C_QUEUE_SIZE) {
+        transaction->status = I2C_STATUS_QUEUED;
+        queue[(queueHead + queueCount) % I2C_QUEUE_SIZE] = transaction;
+        queueCount++;
+        if(state == STATE_IDLE) {
+            startNextTransaction();
+        }
+        queued = 1;
+    }
+    IEC1bits.T5IE = watchdogEnabled;
+    IEC1bits.MI2C1IE = enabled;
+    return queued;
+}
+
+/**
+ * Queues a transaction and waits until it completes. Must not be called from
+ * an interrupt at or above the priority of the I2C1 interrupt. The waits are
+ * bounded: every queued transaction finishes within
+ * (I2C_MAX_RETRIES + 1) attempts of at most I2C_PHASE_TIMEOUT per phase.
+ * @param transaction the transaction to run
+ * @return 1 if the transaction succeeded, otherwise return 0
+ */
+int runI2CTransaction(I2CTransaction *transaction) {
+    while(!submitI2CTransaction(transaction)); // wait for room in the queue
+    while(transaction->status == I2C_STATUS_QUEUED); // wait for completion
+    return transaction->status == I2C_STATUS_DONE;
+}
+
+/**
+ * @return 1 if no transaction is queued or running, otherwise return 0
+ */
+int isI2CIdle() {
+    return queueCount == 0;
+}
+
+/**
+ * @return time the last completed transaction spent on the bus, from the
+ * start condition to the end of the stop condition and including retries, in
+ * Timer5 ticks. Bus recovery is not included
+ */
+uint16_t getI2CLastTime() {
+    return lastTime;
+}
+
+/**
+ * @return longest transaction time since the counters were reset, in Timer5
+ * ticks
+ */
+uint16_t getI2CMaxTime() {
+    return maxTime;
+}
+
+/**
+ * @return number of failed attempts (missing acknowledge or timeout) since the
+ * counters were reset
+ */
+uint16_t getI2CErrorCount() {
+    return errorCount;
+}
+
+/**
+ * @return number of phases that went over I2C_PHASE_TIMEOUT since the
+ * counters were reset. Each one caused a bus recovery
+ */
+uint16_t getI2CTimeoutCount() {
+    return timeoutCount;
+}
+
+/**
+ * @return number of attempts started again after a failure since the
+ * counters were reset
+ */
+uint16_t getI2CRetryCount() {
+    return retryCount;
+}
+
+/**
+ * Clears the error, timeout and retry counters and the maximum transaction
+ * time.
+ */
+void resetI2CCounters() {
+    maxTime = 0;
+    errorCount = 0;
+    timeoutCount = 0;
+    retryCount = 0;
+}
+
+/**
+ * Helper function that begins (or retries) the transaction at the head of the
+ * queue by sending a start condition and arming the phase watchdog. The state
+ * machine must be idle.
+ */
+void startNextTransaction() {
+    byteIndex = 0;
+    transactionFailed = 0;
+    state = STATE_START;
+    TMR5 = 0;
+    IFS1bits.T5IF = 0;
+    T5CONbits.TON = 1;
+    I2C1CONbits.SEN = 1; // initialize start condition
+}
+
+/**
+ * Helper function that ends the current attempt once the stop condition is on
+ * the bus (or the bus was recovered). A failed attempt is started again while
+ * retries remain; otherwise the transaction is retired and its callback run.
+ */
+void finishTransaction() {
+    I2CTransaction *t = (I2CTransaction *) queue[queueHead];
+    T5CONbits.TON = 0;
+    state = STATE_IDLE;
+    if(transactionFailed) {
+        errorCount++;
+        if(retries < I2C_MAX_RETRIES) {
+            retries++;
+            retryCount++;
+            startNextTransaction();
+            return;
+        }
+    }
+    
+    // Transaction finished: retire it before running its callback so the
+    // callback can queue a follow-up transaction
+    queueHead = (queueHead + 1) % I2C_QUEUE_SIZE;
+    queueCount--;
+    retries = 0;
+    lastTime = transactionTime;
+    transactionTime = 0;
+    if(lastTime > maxTime) {
+        maxTime = lastTime;
+    }
+    t->status = transactionFailed ? I2C_STATUS_ERROR : I2C_STATUS_DONE;
+    if(t->callback) {
+        t->callback(t);
+    }
+    if(state == STATE_IDLE && queueCount > 0) {
+        startNextTransaction();
+    }
+}
+
+/**
+ * Helper function that frees a stuck bus. A slave holding SDA low in the
+ * middle of a byte (for example after the microcontroller reset or the sensor
+ * browned out) is clocked through the rest of it with nine SCL pulses, then a
+ * stop condition is sent by hand. The I2C1 module is disabled while SCL1
+ * (RB8) and SDA1 (RB9) are driven as open-drain port pins: the LAT bits are
+ * left at 0 and the TRIS bits release each line to its pull up resistor.
+ */
+void recoverBus() {
+    I2C1CONbits.I2CEN = 0; // give the pins back to the port
+    LATBbits.LATB8 = 0;
+    LATBbits.LATB9 = 0;
+    TRISBbits.TRISB9 = 1; // release SDA
+    for(int i = 0; i < 9; i++) {
+        TRISBbits.TRISB8 = 0; // SCL low
+        busDelay();
+        TRISBbits.TRISB8 = 1; // SCL high
+        busDelay();
+    }
+    TRISBbits.TRISB8 = 0; // SCL low
+    busDelay();
+    TRISBbits.TRISB9 = 0; // SDA low
+    busDelay();
+    TRISBbits.TRISB8 = 1; // SCL high
+    busDelay();
+    TRISBbits.TRISB9 = 1; // SDA rises while SCL is high: stop condition
+    busDelay();
+    
+    TRISBbits.TRISB8 = 0;
+    TRISBbits.TRISB9 = 0;
+    I2C1CONbits.I2CEN = 1;
+    IFS1bits.MI2C1IF = 0;
+}
+
+/**
+ * Helper function that waits half an SCL period of the recovery clock
+ * (5 microseconds, 100 kHz).
+ */
+void busDelay() {
+    asm("repeat #78");
+    asm("nop");
+}
+
+/**
+ * Advances the transaction state machine every time the I2C1 module finishes
+ * a start, repeated start, stop, byte transfer or acknowledge.
+ */
+void __attribute__((__interrupt__, __auto_psv__)) _MI2C1Interrupt() {
+    IFS1bits.MI2C1IF = 0;
+    I2CTransaction *t = (I2CTransaction *) queue[queueHead];
+    
+    // The phase finished in time: add it to the transaction time and restart
+    // the watchdog for the next phase
+    transactionTime += TMR5;
+    TMR5 = 0;
+    IFS1bits.T5IF = 0;
+    
+    switch(state) {
+        case STATE_START:
+            I2C1TRN = t->deviceAddress; // slave address with the write bit (0)
+            state = STATE_ADDRESS_WRITE;
+            break;
+        case STATE_ADDRESS_WRITE:
+            if(I2C1STATbits.ACKSTAT) { // slave did not acknowledge
+                transactionFailed = 1;
+                I2C1CONbits.PEN = 1;
+                state = STATE_STOP;
+                break;
+            }
+            I2C1TRN = t->reg; // data register byte
+            state = STATE_REGISTER;
+            break;
+        case STATE_REGISTER:
+        case STATE_WRITE_DATA:
+            if(I2C1STATbits.ACKSTAT) {
+                transactionFailed = 1;
+                I2C1CONbits.PEN = 1;
+                state = STATE_STOP;
+            }
+            else if(t->read) {
+                I2C1CONbits.RSEN = 1; // repeated start to turn the bus around
+                state = STATE_RESTART;
+            }
+            else if(byteIndex < t->length) {
+                I2C1TRN = t->data[byteIndex++]; // data to be sent
+                state = STATE_WRITE_DATA;
+            }
+            else {
+                I2C1CONbits.PEN = 1; // stop bit
+                state = STATE_STOP;
+            }
+            break;
+        case STATE_RESTART:
+            I2C1TRN = t->deviceAddress | 0x01; // slave address with the read bit (1)
+            state = STATE_ADDRESS_READ;
+            break;
+        case STATE_ADDRESS_READ:
+            if(I2C1STATbits.ACKSTAT) {
+                transactionFailed = 1;
+                I2C1CONbits.PEN = 1;
+                state = STATE_STOP;
+                break;
+            }
+            I2C1CONbits.RCEN = 1; // Enable receive mode
+            state = STATE_READ_DATA;
+            break;
+        case STATE_READ_DATA:
+            t->data[byteIndex++] = I2C1RCV;
+            I2C1CONbits.ACKDT = (byteIndex >= t->length); // NACK the last byte
+            I2C1CONbits.ACKEN = 1;
+            state = STATE_ACK;
+            break;
+        case STATE_ACK:
+            if(byteIndex < t->length) {
+                I2C1CONbits.RCEN = 1; // receive the next byte
+                state = STATE_READ_DATA;
+            }
+            else {
+                I2C1CONbits.PEN = 1; // stop bit
+                state = STATE_STOP;
+            }
+            break;
+        case STATE_STOP:
+            finishTransaction();
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Interrupts when a bus phase has not completed within I2C_PHASE_TIMEOUT. The
+ * bus is recovered and the attempt fails, so it is retried or retired.
+ */
+void __attribute__((__interrupt__, __auto_psv__)) _T5Interrupt() {
+    IFS1bits.T5IF = 0;
+    if(state == STATE_IDLE) {
+        T5CONbits.TON = 0;
+        return;
+    }
+    transactionTime += I2C_PHASE_TIMEOUT;
+    timeoutCount++;
+    transactionFailed = 1;
+    recoverBus();
+    finishTransaction();
+}
@@ -0,0 +1,159 @@
+/*
+ * File:   I2C.h
+ * Author: Sharmarke Ahmed
+ * The I2C library is an interrupt-driven master driver for the I2C1 module of
+ * the PIC24FJ64GA002. Transactions are described by an I2CTransaction and
+ * queued with submitI2CTransaction(); the _MI2C1Interrupt state machine then
+ * clocks the whole transaction out without the CPU waiting on the bus. The
+ * status field of the transaction (and its optional callback) reports when it
+ * has finished. Every bus phase (start, byte, acknowledge, stop) must complete
+ * within I2C_PHASE_TIMEOUT: a phase that takes longer is treated as a stuck
+ * bus, which is recovered by clocking SCL nine times and sending a stop
+ * condition. A failed transaction (timeout or missing acknowledge) is retried
+ * up to I2C_MAX_RETRIES times, so every transaction finishes in a bounded
+ * time. The library uses the I2C1 module and Timer5 on the microcontroller.
+ * Ensure that these modules are not being used elsewhere.
+ * Initialize the driver with the initI2C() function before submitting
+ * transactions.
+ *
+ * Created on December 4, 2023, 1:15 PM
+ */
+
+#ifndef I2C_H
+#define	I2C_H
+
+#include "stdint.h"
+#include "Clock.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define I2C_QUEUE_SIZE 8 // maximum number of transactions waiting for the bus
+
+#define I2C_FSCL 400000UL // bus speed: 100000, 400000 or 1000000 Hz
+
+// Baud rate generator value from the I2C section of the PIC24FJ64GA004 family
+// datasheet, I2C1BRG = FCY/FSCL - FCY/10000000 - 1. The second term
+// compensates for the pulse gobbler delay. Everything is scaled by 10 so the
+// integer result rounds the same way as the datasheet table (157 at 100 kHz)
+#define I2C_BRG(fscl) (((FCY) * 10 / (fscl) - (FCY) / 1000000UL - 10) / 10)
+
+// Slew rate control is meant for 400 kHz; it is disabled at 100 kHz and 1 MHz
+#define I2C_DISSLW ((I2C_FSCL) == 400000UL ? 0 : 1)
+
+#if I2C_BRG(I2C_FSCL) < 2
+#error "I2C_FSCL is too fast for FCY: I2C1BRG values of 0 and 1 are not supported"
+#endif
+
+// Timer5 runs at FCY/8 (0.5 microseconds per tick at 16 MHz) while a
+// transaction is on the bus. It times every phase and every transaction
+#define I2C_TICKS_PER_BYTE (9 * ((FCY) / 8) / (I2C_FSCL)) // 8 bits + acknowledge
+
+// Budget for one bus phase, in Timer5 ticks: four byte times leaves room for a
+// slave stretching the clock (180 ticks, 90 microseconds at 400 kHz)
+#ifndef I2C_PHASE_TIMEOUT
+#define I2C_PHASE_TIMEOUT (4 * I2C_TICKS_PER_BYTE)
+#endif
+
+// Number of times a failed transaction is started again before it is retired
+// with I2C_STATUS_ERROR
+#ifndef I2C_MAX_RETRIES
+#define I2C_MAX_RETRIES 2
+#endif
+
+// Values of the status field of an I2CTransaction
+#define I2C_STATUS_IDLE 0 // not submitted yet
+#define I2C_STATUS_QUEUED 1 // waiting in the queue or on the bus
+#define I2C_STATUS_DONE 2 // completed successfully
+#define I2C_STATUS_ERROR 3 // the slave did not acknowledge or the bus was stuck,
+                           // on every attempt
+
+/**
+ * Describes one register read or write. A write sends the register address
+ * followed by length data bytes. A read sends the register address, then a
+ * repeated start, then receives length data bytes (ACK on every byte but the
+ * last, NACK on the last). The transaction must stay in memory until its
+ * status is I2C_STATUS_DONE or I2C_STATUS_ERROR.
+ */
+typedef struct I2CTransaction {
+    uint8_t deviceAddress; // 8-bit slave address with the R/W bit cleared
+    uint8_t reg; // register sub-address sent after the slave address
+    uint8_t read; // 1 for a read, 0 for a write
+    uint8_t length; // number of data bytes to transfer
+    uint8_t *data; // data to send, or buffer for the data received
+    volatile uint8_t status; // one of the I2C_STATUS_ values
+    // Called from the I2C interrupt once the transaction completes. May be 0
+    void (*callback)(struct I2CTransaction *transaction);
+} I2CTransaction;
+
+/**
+ * Initializes the I2C1 module of the microcontroller for an I2C_FSCL bus and
+ * enables the master I2C1 interrupt used by the transaction state machine.
+ */
+void initI2C();
+
+/**
+ * Adds a transaction to the queue. If the bus is idle, the transaction is
+ * started immediately. Can be called from a transaction callback.
+ * @param transaction the transaction to queue
+ * @return 1 if the transaction was queued, 0 if the queue is full
+ */
+int submitI2CTransaction(I2CTransaction *transaction);
+
+/**
+ * Queues a transaction and waits until it completes. Must not be called from
+ * an interrupt at or above the priority of the I2C1 interrupt.
+ * @param transaction the transaction to run
+ * @return 1 if the transaction succeeded, otherwise return 0
+ */
+int runI2CTransaction(I2CTransaction *transaction);
+
+/**
+ * @return 1 if no transaction is queued or running, otherwise return 0
+ */
+int isI2CIdle();
+
+/**
+ * @return time the last completed transaction spent on the bus, from the
+ * start condition to the end of the stop condition and including retries, in
+ * Timer5 ticks. Bus recovery is not included
+ */
+uint16_t getI2CLastTime();
+
+/**
+ * @return longest transaction time since the counters were reset, in Timer5
+ * ticks
+ */
+uint16_t getI2CMaxTime();
+
+/**
+ * @return number of failed attempts (missing acknowledge or timeout) since the
+ * counters were reset
+ */
+uint16_t getI2CErrorCount();
+
+/**
+ * @return number of phases that went over I2C_PHASE_TIMEOUT since the
+ * counters were reset. Each one caused a bus recovery
+ */
+uint16_t getI2CTimeoutCount();
+
+/**
+ * @return number of attempts started again after a failure since the
+ * counters were reset
+ */
+uint16_t getI2CRetryCount();
+
+/**
+ * Clears the error, timeout and retry counters and the maximum transaction
+ * time.
+ */
+void resetI2CCounters();
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* I2C_H */
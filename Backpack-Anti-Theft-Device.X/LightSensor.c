@@ -6,27 +6,97 @@
  * a 4.7 k ohm resistor and the voltage is read using a peripheral pin on the
  * microcontroller. This value is analog so an analog to digital converter
  * converts it into a voltage. Compatible with 3.0 V and 3.3 V sources
+ * In light-watch mode the ADC is stopped and comparator 1 watches the divider
+ * instead: connect the divider to pin RB2 (C1IN-) as well as to pin RA0.
+ * Several light sensors (one per compartment) can be read at once: every
+ * analog input set in LIGHT_CHANNELS is converted in turn by the ADC scan, and
+ * each one has its own averaging buffer and step detector.
  *
  * Created on December 1, 2023, 11:35 AM
  */
 
 #include "xc.h"
 #include "stdint.h"
+#include "LightSensor.h"
 
-#define BUFSIZE 10
+// Number of analog inputs set in LIGHT_CHANNELS, and its base 2 log rounded up
+#define LIGHT_CHANNEL_COUNT (((LIGHT_CHANNELS) & 1) + (((LIGHT_CHANNELS) >> 1) & 1) + \
+    (((LIGHT_CHANNELS) >> 2) & 1) + (((LIGHT_CHANNELS) >> 3) & 1) + \
+    (((LIGHT_CHANNELS) >> 4) & 1) + (((LIGHT_CHANNELS) >> 5) & 1) + \
+    (((LIGHT_CHANNELS) >> 9) & 1) + (((LIGHT_CHANNELS) >> 10) & 1) + \
+    (((LIGHT_CHANNELS) >> 11) & 1) + (((LIGHT_CHANNELS) >> 12) & 1))
+#define CHANNEL_LOG2 (LIGHT_CHANNEL_COUNT > 8 ? 4 : LIGHT_CHANNEL_COUNT > 4 ? 3 : \
+    LIGHT_CHANNEL_COUNT > 2 ? 2 : LIGHT_CHANNEL_COUNT > 1 ? 1 : 0)
+
+#if LIGHT_CHANNEL_COUNT == 0 || ((LIGHT_CHANNELS) & ~0x1E3F)
+#error "LIGHT_CHANNELS must select at least one of AN0-AN5, AN9-AN12"
+#endif
+
+#if LIGHT_BLOCK_MODE
+#define BLOCK_LOG2 (4 - CHANNEL_LOG2)
+#define BLOCK_SIZE (1 << BLOCK_LOG2) // conversions of each channel per interrupt
+#define SAMPLE_FRAC 4 // a block sum scaled to the mean with 4 fraction bits
+#define BUFSIZE_LOG2 1 // blocks averaged by lightDetected() (2 s)
+#define EWMA_SHIFT 6 // baseline time constant of 64 samples (about 1 minute)
+#define MIN_STEP_SAMPLES 2 // samples past the step threshold to detect (2 s)
+#else
+#define SAMPLE_FRAC 0
+#define BUFSIZE_LOG2 3 // conversions averaged by lightDetected() (0.5 s)
+#define EWMA_SHIFT 10 // baseline time constant of 1024 samples (about 1 minute)
+#define MIN_STEP_SAMPLES 8 // samples past the step threshold to detect (0.5 s)
+#endif
+#define BUFSIZE (1 << BUFSIZE_LOG2) // power of two, so the average is a shift
 #define NUMSAMPLES 128
-#define THRESHOLD 2
-volatile int adc_buffer[BUFSIZE];
-volatile int buffer_index = 0;
-volatile float adcval = 0;
+#define VDD_MV 3000 // supply voltage, also the ADC reference (AVdd)
+#define THRESHOLD_MV 2000 // divider voltage at or below which the backpack is open
+#define THRESHOLD ((THRESHOLD_MV * 1024UL) / VDD_MV) // in ADC counts (682)
+// Timer3 triggers one conversion at a time, so it runs LIGHT_CHANNEL_COUNT
+// times faster to convert every channel 16 times per second (1:64)
+#define PR3_SAMPLE (250000UL / (16 * LIGHT_CHANNEL_COUNT) - 1) // 15624 for 1 channel
+// A wake is confirmed at the normal sample rate, so MIN_STEP_SAMPLES and
+// EWMA_SHIFT keep their meaning in time
+#define CONFIRM_SAMPLES (2 * MIN_STEP_SAMPLES) // samples taken to confirm a wake
+#define WATCH_OFF 0 // continuous ADC sampling
+#define WATCH_COMPARATOR 1 // ADC stopped, comparator 1 watching the divider
+#define WATCH_CONFIRM 2 // comparator tripped, ADC confirming the step
+#define BASE_FRAC 8 // extra fraction bits kept by the baseline
+#define STEP_ENTER_SHIFT 2 // a drop of 1/4 of the baseline starts a step
+#define STEP_EXIT_SHIFT 3 // the step ends when the drop is back under 1/8
+
+// Averaging buffer and step detector of one light sensor
+typedef struct {
+    unsigned int adc_buffer[BUFSIZE]; // ADC counts with SAMPLE_FRAC fraction bits
+    unsigned int adc_sum; // running sum of adc_buffer
+    long baseline; // EWMA of the samples, SAMPLE_FRAC + BASE_FRAC fraction bits
+    unsigned int step_samples; // consecutive samples past the step threshold
+    int step_detected;
+} LightChannel;
+
+volatile LightChannel channels[LIGHT_CHANNEL_COUNT]; // in scan (AN number) order
+volatile int buffer_index = 0; // shared, every channel gets a sample per interrupt
+volatile unsigned long adc_interrupts = 0; // number of _ADC1Interrupt calls
+volatile int buffer_full = 0; // set once every entry of adc_buffer holds a sample
+volatile int calibrated = 0; // set by calibrateLightSensor()
+volatile int watch_state = 0; // WATCH_OFF, WATCH_COMPARATOR or WATCH_CONFIRM
+volatile unsigned int confirm_samples = 0; // samples taken since the comparator woke
 
 void delay_ms(unsigned long int ms);
 void initLightSensor();
 void initBuffer();
-void putVal(int ADCvalue);
-int getAvg();
+void putVal(volatile LightChannel *channel, unsigned int ADCvalue);
+unsigned int getAvg(volatile LightChannel *channel);
+void updateBaseline(volatile LightChannel *channel, unsigned int ADCvalue);
+void calibrateLightSensor();
 void __attribute__((__interrupt__, __auto_psv__)) _ADC1Interrupt();
 int lightDetected();
+unsigned int getOpenedCompartments();
+unsigned long getLightSensorInterrupts();
+void initLightWatch();
+void stopLightWatch();
+void startSampling();
+int setComparatorReference(unsigned int base);
+void armComparator();
+void __attribute__((__interrupt__, __auto_psv__)) _CompInterrupt();
 
 /**
  * Assembly function that uses "nop" to delay for the specified
@@ -45,27 +115,41 @@ void delay_ms(unsigned long int ms){
 
 void initLightSensor(){ // initializes ADC and assigns it to timer 3, no arguments, no return values
     _RCDIV = 0;
-    TRISAbits.TRISA0 = 1;
+    // Analog inputs of LIGHT_CHANNELS: AN0-AN1 are RA0-RA1, AN2-AN5 are
+    // RB0-RB3 and AN9-AN12 are RB15-RB12
+    TRISA |= LIGHT_CHANNELS & 0x0003;
+    TRISB |= ((LIGHT_CHANNELS >> 2) & 0x000F) | ((LIGHT_CHANNELS & 0x0200) << 6) |
+            ((LIGHT_CHANNELS & 0x0400) << 4) | ((LIGHT_CHANNELS & 0x0800) << 2) |
+            (LIGHT_CHANNELS & 0x1000);
     
-    AD1PCFGbits.PCFG0 = 0;
+    AD1PCFG &= ~(LIGHT_CHANNELS);
     
     AD1CON2bits.VCFG = 0b000;
+    AD1CON2bits.CSCNA = 1; // scan the inputs selected in AD1CSSL
+    AD1CSSL = LIGHT_CHANNELS;
+    AD1CHSbits.CH0NA = 0; // negative input is VR-
     AD1CON3bits.ADCS = 1;
     AD1CON1bits.SSRC = 0b010;
     AD1CON3bits.SAMC = 1;
     AD1CON1bits.FORM = 0;
     
     AD1CON1bits.ASAM = 1;
-    AD1CON2bits.SMPI = 0;
+#if LIGHT_BLOCK_MODE
+    AD1CON2bits.BUFM = 0; // one 16-word buffer
+    AD1CON2bits.SMPI = BLOCK_SIZE * LIGHT_CHANNEL_COUNT - 1; // interrupt once the blocks are in
+#else
+    AD1CON2bits.SMPI = LIGHT_CHANNEL_COUNT - 1; // interrupt after every scan
+#endif
     AD1CON1bits.ADON = 1;
     
+    initBuffer();
     _AD1IF = 0;
     _AD1IE = 1;
     
     TMR3 = 0;
     T3CON = 0;
     T3CONbits.TCKPS = 0b10;
-    PR3 = 15624;
+    PR3 = PR3_SAMPLE;
     T3CONbits.TON = 1;
 }
 
@@ -73,54 +157,308 @@ void initLightSensor(){ // initializes ADC and assigns it to timer 3, no argumen
  * creates Buffer array to store ADC buffer values
  */
 
-void initBuffer(){ //initializes buffer to size of 10, no arguments, no return values
-    for(int i=0; i<BUFSIZE; i++){
-        adc_buffer[i] = 0;
+void initBuffer(){ //initializes the buffer of every channel to size of BUFSIZE, no arguments, no return values
+    for(int c=0; c<LIGHT_CHANNEL_COUNT; c++){
+        for(int i=0; i<BUFSIZE; i++){
+            channels[c].adc_buffer[i] = 0;
+        }
+        channels[c].adc_sum = 0;
     }
+    buffer_index = 0;
+    buffer_full = 0;
 }
 
 /**
- * Takes the value from the buffer and puts it in the array.
+ * Takes the value from the buffer and puts it in the array of a channel, at
+ * buffer_index. The running sum is updated by swapping the oldest value for
+ * the new one.
  */
-void putVal(int ADCvalue){ //Fills buffer with ADC values, the ADC value is the argument, no return values
-    adc_buffer[buffer_index++] = ADCvalue;
-    if(buffer_index >= BUFSIZE){
-        buffer_index = 0;
-    }
+void putVal(volatile LightChannel *channel, unsigned int ADCvalue){ //Fills buffer with ADC values, the channel and the ADC value are the arguments, no return values
+    channel->adc_sum = channel->adc_sum - channel->adc_buffer[buffer_index] + ADCvalue;
+    channel->adc_buffer[buffer_index] = ADCvalue;
 }
 
 /**
- * averages the values of the array.
+ * averages the values of the array of a channel.
  */
-int getAvg(){ // averages the values in the buffer, no arguments, no return values
-    unsigned long int sum = 0;
-    int average;
-    
-    for(int i=0; i<BUFSIZE; i++){
-        sum = sum + adc_buffer[i];
+unsigned int getAvg(volatile LightChannel *channel){ // averages the values in the buffer, the channel is the argument, returns the average in ADC counts with SAMPLE_FRAC fraction bits
+    return channel->adc_sum >> BUFSIZE_LOG2;
+}
+
+/**
+ * Compares a new sample against the baseline. More light on the sensor lowers
+ * the divider voltage, so a step is a drop of more than 1/4 of the baseline
+ * lasting MIN_STEP_SAMPLES samples; it ends once the drop is back under 1/8.
+ * Outside of a step the baseline follows the samples with an integer EWMA, so
+ * slow changes of the ambient light are absorbed but an opening is not.
+ */
+void updateBaseline(volatile LightChannel *channel, unsigned int ADCvalue){
+    unsigned int base = channel->baseline >> BASE_FRAC;
+    unsigned int drop = ADCvalue < base ? base - ADCvalue : 0;
+    if(drop > (base >> STEP_ENTER_SHIFT)){
+        if(channel->step_samples < MIN_STEP_SAMPLES){
+            channel->step_samples++;
+        }
+        if(channel->step_samples >= MIN_STEP_SAMPLES){
+            channel->step_detected = 1;
+        }
+    }
+    else{
+        channel->step_samples = 0;
+        if(drop < (base >> STEP_EXIT_SHIFT)){
+            channel->step_detected = 0;
+            channel->baseline = channel->baseline +
+                    ((((long) ADCvalue << BASE_FRAC) - channel->baseline) >> EWMA_SHIFT);
+        }
     }
-    average = sum/BUFSIZE;
-    return average;
+}
+
+/**
+ * Captures the current light level of every channel as the baseline of its
+ * step detector. Call it when the security mechanism is turned on, with the
+ * backpack closed. Until then lightDetected() uses the absolute 2 V threshold.
+ */
+void calibrateLightSensor(){
+    while(!buffer_full); // wait for a full window of samples
+    _AD1IE = 0;
+    for(int c=0; c<LIGHT_CHANNEL_COUNT; c++){
+        channels[c].baseline = (long) getAvg(&channels[c]) << BASE_FRAC;
+        channels[c].step_samples = 0;
+        channels[c].step_detected = 0;
     }
+    calibrated = 1;
+    _AD1IE = 1;
+}
 
 /**
- * waits until buffer is full and puts value in array.
+ * waits until buffer is full and puts value in array. The scan stores the
+ * channels one after the other (ADC1BUF0 is the first channel of LIGHT_CHANNELS,
+ * ADC1BUF1 the second, and so on, starting over after the last one), so every
+ * channel gets one sample per interrupt. In block mode the BLOCK_SIZE results
+ * of each channel are decimated into one value: their sum, scaled to the mean
+ * of the block with 4 fraction bits.
  */
 void __attribute__((__interrupt__, __auto_psv__)) _ADC1Interrupt(){ //everytime buffer is full it puts the value in the buffer
     _AD1IF = 0;
-    putVal(ADC1BUF0);
+    adc_interrupts++;
+    volatile unsigned int *result = &ADC1BUF0; // the 16 buffers are consecutive
+    for(int c=0; c<LIGHT_CHANNEL_COUNT; c++){
+#if LIGHT_BLOCK_MODE
+        unsigned int block_sum = 0;
+        for(int i=0; i<BLOCK_SIZE; i++){
+            block_sum = block_sum + result[i * LIGHT_CHANNEL_COUNT + c];
+        }
+        unsigned int value = block_sum << CHANNEL_LOG2;
+#else
+        unsigned int value = result[c];
+#endif
+        putVal(&channels[c], value);
+        if(calibrated){
+            updateBaseline(&channels[c], value);
+        }
+    }
+    if(++buffer_index >= BUFSIZE){
+        buffer_index = 0;
+        buffer_full = 1;
+    }
+    if(watch_state == WATCH_CONFIRM){
+        confirm_samples++;
+    }
 }
 
 /**
  * checks if light detected is above the voltage threshold needed to set off alarm (2.5 V)
+ * on any channel. After calibrateLightSensor(), checks for a step up in light from the
+ * baseline instead
  */
 int lightDetected(){
-    adcval = ((float) 3.0 /1024)*getAvg(); //dark = 3.29, partially open = 1.743 w/ 3.3 V source || dark = 2.997, partially open = 1.863 w/ 3.0 V source
-    if(adc_buffer[9] == 0){ //buffer is not full in progress
+    if(!buffer_full){ //buffer is not full in progress
         return -1;
     }
-    else if(adcval <= THRESHOLD){ //open backpack
+    else if(watch_state == WATCH_CONFIRM && !channels[0].step_detected &&
+            channels[0].step_samples == 0 && confirm_samples >= CONFIRM_SAMPLES){ //false wake, back to the comparator
+        armComparator();
+        return 0;
+    }
+    else if(getOpenedCompartments()){ //open backpack
         return 1;
     }
         return 0;
 }
+
+/**
+ * @return one bit per channel of LIGHT_CHANNELS, in AN number order (bit 0 is
+ * the lowest analog input of LIGHT_CHANNELS), set when that compartment is open
+ */
+unsigned int getOpenedCompartments(){
+    unsigned int opened = 0;
+    if(!buffer_full){
+        return 0;
+    }
+    for(int c=0; c<LIGHT_CHANNEL_COUNT; c++){
+        //dark = 3.29, partially open = 1.743 w/ 3.3 V source || dark = 2.997, partially open = 1.863 w/ 3.0 V source
+        if(calibrated ? channels[c].step_detected :
+                getAvg(&channels[c]) <= (THRESHOLD << SAMPLE_FRAC)){
+            opened |= 1 << c;
+        }
+    }
+    return opened;
+}
+
+/**
+ * @return number of ADC interrupts since the microcontroller started. One
+ * per conversion (16 per second), or one per 16 conversions (1 per second)
+ * in block mode
+ */
+unsigned long getLightSensorInterrupts(){
+    return adc_interrupts;
+}
+
+/**
+ * Starts light-watch mode: the ADC and Timer3 are stopped, and comparator 1
+ * compares the divider on pin RB2 (C1IN-) against the internal voltage
+ * reference, set between the step threshold and the baseline. The comparator
+ * interrupt wakes the CPU when the backpack brightens; the ADC then samples
+ * until the step detector confirms the opening (lightDetected() returns 1) or
+ * rejects it, in which case the comparator watches again. Calibrates the
+ * light sensor first if calibrateLightSensor() has not been called. There is
+ * one comparator input, so with more than one channel in LIGHT_CHANNELS the
+ * function does nothing and the ADC keeps sampling. The ADC also keeps
+ * sampling when no CVREF lies between the threshold and the baseline: CVREF
+ * tops out at 0.72 VDD and its low range has steps of VDD/24, so the baseline
+ * must be 43-56, 86-113 or 129-981 ADC counts (0.13 V to 2.87 V at VDD = 3 V,
+ * apart from 0.17-0.25 V and 0.33-0.38 V).
+ * The baseline does not follow the ambient light while the comparator
+ * watches, as there are no samples: it stays at its value when the
+ * comparator was armed (and is updated during each false wake). A slow
+ * brightening that continuous sampling would have absorbed therefore wakes
+ * the ADC once it crosses the threshold, and is confirmed as an opening if it
+ * stays more than 1/4 below that baseline.
+ */
+void initLightWatch(){
+    if(LIGHT_CHANNEL_COUNT > 1){
+        return;
+    }
+    if(!calibrated){
+        calibrateLightSensor();
+    }
+    TRISBbits.TRISB2 = 1;
+    AD1PCFGbits.PCFG4 = 0; // C1IN- is an analog input
+    IPC4bits.CMIP = 4;
+    armComparator();
+}
+
+/**
+ * Leaves light-watch mode: comparator 1 and the voltage reference are turned
+ * off and the ADC samples continuously again.
+ */
+void stopLightWatch(){
+    if(watch_state == WATCH_OFF){
+        return;
+    }
+    IEC1bits.CMIE = 0;
+    CMCONbits.C1EN = 0;
+    CVRCONbits.CVREN = 0;
+    watch_state = WATCH_OFF;
+    startSampling();
+}
+
+/**
+ * Helper function that restarts Timer3-triggered ADC conversions.
+ */
+void startSampling(){
+    TMR3 = 0;
+    PR3 = PR3_SAMPLE;
+    AD1CON1bits.ADON = 1;
+    _AD1IF = 0;
+    _AD1IE = 1;
+    T3CONbits.TON = 1;
+}
+
+/**
+ * Helper function that sets CVREF to the lowest level, in either range, at or
+ * above the step threshold of a baseline, so every drop the step detector
+ * would count trips the comparator. CVREF must also stay below the baseline,
+ * or the comparator would trip at once. In ADC counts (1024 = VDD), the high
+ * range gives 256 + 32*CVR and the low range 128*CVR/3, compared here in
+ * thirds of a count.
+ * @param base baseline in ADC counts
+ * @return 1 if CVREF was set, 0 if no level lies between the threshold and
+ * the baseline
+ */
+int setComparatorReference(unsigned int base){
+    unsigned long target = 3UL * (base - (base >> STEP_ENTER_SHIFT));
+    unsigned long high_ref = 0;
+    unsigned int high_cvr = 0;
+    if(target > 3UL * 256){
+        high_cvr = (target - 3UL * 256 + 95) / 96; // rounded up
+    }
+    if(high_cvr <= 15){
+        high_ref = 3UL * (256 + 32 * high_cvr);
+    }
+    unsigned int low_cvr = (target + 127) >> 7; // rounded up
+    unsigned long low_ref = 128UL * low_cvr;
+    int low = low_cvr <= 15 && (high_ref == 0 || low_ref < high_ref);
+    unsigned long ref = low ? low_ref : high_ref;
+    if(ref == 0 || ref >= 3UL * base){
+        return 0;
+    }
+    CVRCONbits.CVRR = low;
+    CVRCONbits.CVR = low ? low_cvr : high_cvr;
+    return 1;
+}
+
+/**
+ * Helper function that stops the ADC and sets comparator 1 to trip when the
+ * divider voltage falls below CVREF, just above the step threshold of the
+ * baseline. The ADC keeps sampling when there is no such CVREF.
+ */
+void armComparator(){
+    IEC1bits.CMIE = 0;
+    unsigned int base = channels[0].baseline >> (BASE_FRAC + SAMPLE_FRAC); // ADC counts
+    if(!setComparatorReference(base)){
+        CMCONbits.C1EN = 0;
+        CVRCONbits.CVREN = 0;
+        watch_state = WATCH_OFF;
+        startSampling();
+        return;
+    }
+    T3CONbits.TON = 0;
+    _AD1IE = 0;
+    AD1CON1bits.ADON = 0;
+    
+    CVRCONbits.CVRSS = 0; // reference from AVdd and AVss
+    CVRCONbits.CVROE = 0; // not output on a pin
+    CVRCONbits.CVREN = 1;
+    
+    CMCONbits.C1NEG = 0; // C1IN- on the inverting input
+    CMCONbits.C1POS = 0; // CVREF on the non-inverting input
+    CMCONbits.C1INV = 0; // C1OUT = 1 when the divider is below CVREF
+    CMCONbits.C1OUTEN = 0;
+    CMCONbits.C1EN = 1;
+    delay_ms(1); // let CVREF and the comparator settle
+    
+    watch_state = WATCH_COMPARATOR;
+    CMCONbits.C1EVT = 0;
+    IFS1bits.CMIF = 0;
+    IEC1bits.CMIE = 1;
+    if(CMCONbits.C1OUT){ // already brighter than the threshold
+        IFS1bits.CMIF = 1;
+    }
+}
+
+/**
+ * Interrupts when the output of comparator 1 changes. When the divider has
+ * fallen below CVREF, the ADC is restarted to confirm the step.
+ */
+void __attribute__((__interrupt__, __auto_psv__)) _CompInterrupt(){
+    IFS1bits.CMIF = 0;
+    CMCONbits.C1EVT = 0;
+    if(watch_state == WATCH_COMPARATOR && CMCONbits.C1OUT){
+        IEC1bits.CMIE = 0;
+        watch_state = WATCH_CONFIRM;
+        confirm_samples = 0;
+        channels[0].step_samples = 0;
+        startSampling();
+    }
+}
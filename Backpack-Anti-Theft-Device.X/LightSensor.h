@@ -6,6 +6,11 @@
  * a 4.7 k ohm resistor and the voltage is read using a peripheral pin on the
  * microcontroller. This value is analog so an analog to digital converter
  * converts it into a voltage. Compatible with 3.0 V and 3.3 V sources
+ * In light-watch mode the ADC is stopped and comparator 1 watches the divider
+ * instead: connect the divider to pin RB2 (C1IN-) as well as to pin RA0.
+ * Several light sensors (one per compartment) can be read at once: every
+ * analog input set in LIGHT_CHANNELS is converted in turn by the ADC scan, and
+ * each one has its own averaging buffer and step detector.
  *
  * Created on December 1, 2023, 11:35 AM
  */
@@ -17,6 +22,18 @@
 extern "C" {
 #endif
 
+// Set to 1 to let the ADC fill its 16-word buffer before interrupting
+// (SMPI = 15): each interrupt decimates a block of 16 conversions into one
+// sample, so the CPU is woken once per second instead of 16 times
+#ifndef LIGHT_BLOCK_MODE
+#define LIGHT_BLOCK_MODE 1
+#endif
+
+// Analog inputs with a light sensor, one bit per ANx input (bit 0 is AN0).
+// AN0 (RA0) is the main compartment; AN1 (RA1), AN5 (RB3) and AN12 (RB12) are
+// free for more compartments, e.g. 0x0003 for AN0 and AN1
+#define LIGHT_CHANNELS 0x0001
+
 /**
  * Initializes light sensor pin as well as setting up AD conversion
  */
@@ -24,9 +41,60 @@ void initLightSensor();
 
 /**
  * checks if light detected is above the voltage threshold needed to set off alarm (2.5 V)
+ * on any channel. After calibrateLightSensor(), checks for a step up in light from the
+ * baseline instead
  */
 int lightDetected();
 
+/**
+ * @return one bit per channel of LIGHT_CHANNELS, in AN number order (bit 0 is
+ * the lowest analog input of LIGHT_CHANNELS), set when that compartment is open
+ */
+unsigned int getOpenedCompartments();
+
+/**
+ * Captures the current light level as the baseline of the step detector.
+ * Call it when the security mechanism is turned on, with the backpack closed.
+ * Until then lightDetected() uses the absolute 2 V threshold.
+ */
+void calibrateLightSensor();
+
+/**
+ * Starts light-watch mode: the ADC and Timer3 are stopped, and comparator 1
+ * compares the divider on pin RB2 (C1IN-) against the internal voltage
+ * reference, set between the step threshold and the baseline. The comparator
+ * interrupt wakes the CPU when the backpack brightens; the ADC then samples
+ * until the step detector confirms the opening (lightDetected() returns 1) or
+ * rejects it, in which case the comparator watches again. Calibrates the
+ * light sensor first if calibrateLightSensor() has not been called. There is
+ * one comparator input, so with more than one channel in LIGHT_CHANNELS the
+ * function does nothing and the ADC keeps sampling. The ADC also keeps
+ * sampling when no CVREF lies between the threshold and the baseline: CVREF
+ * tops out at 0.72 VDD and its low range has steps of VDD/24, so the baseline
+ * must be 43-56, 86-113 or 129-981 ADC counts (0.13 V to 2.87 V at VDD = 3 V,
+ * apart from 0.17-0.25 V and 0.33-0.38 V).
+ * The baseline does not follow the ambient light while the comparator
+ * watches, as there are no samples: it stays at its value when the
+ * comparator was armed (and is updated during each false wake). A slow
+ * brightening that continuous sampling would have absorbed therefore wakes
+ * the ADC once it crosses the threshold, and is confirmed as an opening if it
+ * stays more than 1/4 below that baseline.
+ */
+void initLightWatch();
+
+/**
+ * Leaves light-watch mode: comparator 1 and the voltage reference are turned
+ * off and the ADC samples continuously again.
+ */
+void stopLightWatch();
+
+/**
+ * @return number of ADC interrupts since the microcontroller started. One
+ * per conversion (16 per second), or one per 16 conversions (1 per second)
+ * in block mode
+ */
+unsigned long getLightSensorInterrupts();
+
 #ifdef	__cplusplus
 }
 #endif
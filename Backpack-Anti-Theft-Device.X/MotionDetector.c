@@ -0,0 +1,132 @@
+/*
+ * File:   MotionDetector.c
+ * Author: Sharmarke Ahmed
+ * The MotionDetector library decides whether the backpack is moving from a
+ * stream of LIS3DH samples. It keeps a running estimate of gravity on each
+ * axis with an integer low-pass filter, and compares the squared magnitude of
+ * what is left over (the residual) against an enter and an exit threshold, so
+ * the result does not depend on how the backpack is oriented. The library
+ * only uses integer shifts, adds and the hardware multiplier: no division,
+ * square root or floating point. Initialize the library with the
+ * initMotionDetector() function before using other functions.
+ *
+ * Created on December 8, 2023, 10:20 AM
+ */
+
+
+#include "xc.h"
+#include "stdint.h"
+#include "MotionDetector.h"
+
+#define SAMPLE_SHIFT 4 // LIS3DH data is left-justified 12-bit
+#define GRAVITY_SHIFT 7 // gravity filter time constant of 128 samples
+
+// Function declarations
+void initMotionDetector();
+void setMotionThresholds(uint32_t enterThreshold, uint32_t exitThreshold,
+        uint8_t minSamples);
+int updateMotionDetector(int16_t x, int16_t y, int16_t z);
+uint32_t getMotionResidual();
+int16_t removeGravity(int32_t *gravity, int16_t sample);
+
+// Gravity estimate of each axis, scaled up by 2^GRAVITY_SHIFT
+int32_t gravityX, gravityY, gravityZ;
+int gravityReady = 0; // 0 until the first sample seeds the gravity estimate
+
+uint32_t enterLevel = MOTION_ENTER_THRESHOLD;
+uint32_t exitLevel = MOTION_EXIT_THRESHOLD;
+uint8_t minDuration = MOTION_MIN_SAMPLES;
+
+uint8_t samplesAbove = 0; // consecutive samples above the enter threshold
+int moving = 0;
+uint32_t residual = 0;
+
+/**
+ * Resets the gravity estimate and the detector state. The thresholds are kept.
+ * The next sample becomes the initial gravity estimate.
+ */
+void initMotionDetector() {
+    gravityReady = 0;
+    samplesAbove = 0;
+    moving = 0;
+    residual = 0;
+}
+
+/**
+ * Changes the detector thresholds.
+ * @param enterThreshold squared residual above which a sample counts as motion
+ * @param exitThreshold squared residual below which motion has stopped. Must
+ * not be greater than enterThreshold
+ * @param minSamples number of consecutive samples above enterThreshold needed
+ * before motion is reported
+ */
+void setMotionThresholds(uint32_t enterThreshold, uint32_t exitThreshold,
+        uint8_t minSamples) {
+    enterLevel = enterThreshold;
+    exitLevel = exitThreshold;
+    minDuration = minSamples;
+}
+
+/**
+ * Helper function that updates the gravity estimate of one axis with a
+ * first-order low-pass filter, gravity += sample - gravity / 2^GRAVITY_SHIFT.
+ * @param gravity gravity estimate of the axis, scaled up by 2^GRAVITY_SHIFT
+ * @param sample 12-bit acceleration of the axis
+ * @return the acceleration of the axis with gravity removed
+ */
+int16_t removeGravity(int32_t *gravity, int16_t sample) {
+    *gravity += sample - (*gravity >> GRAVITY_SHIFT);
+    return sample - (int16_t) (*gravity >> GRAVITY_SHIFT);
+}
+
+/**
+ * Feeds one sample to the detector.
+ * @param x raw x-axis acceleration (OUT_X_H:OUT_X_L)
+ * @param y raw y-axis acceleration (OUT_Y_H:OUT_Y_L)
+ * @param z raw z-axis acceleration (OUT_Z_H:OUT_Z_L)
+ * @return 1 while the backpack is moving, otherwise return 0
+ */
+int updateMotionDetector(int16_t x, int16_t y, int16_t z) {
+    x >>= SAMPLE_SHIFT;
+    y >>= SAMPLE_SHIFT;
+    z >>= SAMPLE_SHIFT;
+    
+    if(!gravityReady) { // seed the filter so it does not start from zero
+        gravityX = (int32_t) x << GRAVITY_SHIFT;
+        gravityY = (int32_t) y << GRAVITY_SHIFT;
+        gravityZ = (int32_t) z << GRAVITY_SHIFT;
+        gravityReady = 1;
+    }
+    
+    int16_t rx = removeGravity(&gravityX, x);
+    int16_t ry = removeGravity(&gravityY, y);
+    int16_t rz = removeGravity(&gravityZ, z);
+    
+    // Each residual fits in 13 bits, so every square fits in 26 bits and the
+    // sum in 28 bits. __builtin_mulss is a single 16x16 hardware multiply
+    residual = (uint32_t) (__builtin_mulss(rx, rx) + __builtin_mulss(ry, ry)
+            + __builtin_mulss(rz, rz));
+    
+    if(moving) {
+        if(residual < exitLevel) {
+            moving = 0;
+            samplesAbove = 0;
+        }
+    }
+    else if(residual > enterLevel) {
+        if(++samplesAbove >= minDuration) {
+            moving = 1;
+        }
+    }
+    else {
+        samplesAbove = 0;
+    }
+    return moving;
+}
+
+/**
+ * @return squared magnitude of the residual of the last sample
+ */
+uint32_t getMotionResidual() {
+    return residual;
+}
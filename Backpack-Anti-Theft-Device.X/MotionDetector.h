@@ -0,0 +1,66 @@
+/*
+ * File:   MotionDetector.h
+ * Author: Sharmarke Ahmed
+ * The MotionDetector library decides whether the backpack is moving from a
+ * stream of LIS3DH samples. It keeps a running estimate of gravity on each
+ * axis with an integer low-pass filter, and compares the squared magnitude of
+ * what is left over (the residual) against an enter and an exit threshold, so
+ * the result does not depend on how the backpack is oriented. The library
+ * only uses integer shifts, adds and the hardware multiplier: no division,
+ * square root or floating point. Initialize the library with the
+ * initMotionDetector() function before using other functions.
+ *
+ * Created on December 8, 2023, 10:20 AM
+ */
+
+#ifndef MOTIONDETECTOR_H
+#define	MOTIONDETECTOR_H
+
+#include "stdint.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// Default thresholds, in squared 12-bit counts (1 count = 1 mg at +/-2 g)
+#define MOTION_ENTER_THRESHOLD 90000UL // (300 mg)^2
+#define MOTION_EXIT_THRESHOLD 40000UL // (200 mg)^2
+#define MOTION_MIN_SAMPLES 4 // samples above the enter threshold to trigger
+
+/**
+ * Resets the gravity estimate and the detector state. The thresholds are kept.
+ * The next sample becomes the initial gravity estimate.
+ */
+void initMotionDetector();
+
+/**
+ * Changes the detector thresholds.
+ * @param enterThreshold squared residual above which a sample counts as motion
+ * @param exitThreshold squared residual below which motion has stopped. Must
+ * not be greater than enterThreshold
+ * @param minSamples number of consecutive samples above enterThreshold needed
+ * before motion is reported
+ */
+void setMotionThresholds(uint32_t enterThreshold, uint32_t exitThreshold,
+        uint8_t minSamples);
+
+/**
+ * Feeds one sample to the detector.
+ * @param x raw x-axis acceleration (OUT_X_H:OUT_X_L)
+ * @param y raw y-axis acceleration (OUT_Y_H:OUT_Y_L)
+ * @param z raw z-axis acceleration (OUT_Z_H:OUT_Z_L)
+ * @return 1 while the backpack is moving, otherwise return 0
+ */
+int updateMotionDetector(int16_t x, int16_t y, int16_t z);
+
+/**
+ * @return squared magnitude of the residual of the last sample
+ */
+uint32_t getMotionResidual();
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* MOTIONDETECTOR_H */
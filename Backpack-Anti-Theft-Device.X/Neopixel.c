@@ -4,18 +4,44 @@
  * The Neopixel library contains an assortment of functions useful for 
  * controlling the neopixel, a LED that can change color via serial 
  * communication, on the PIC24FJ64GA002. Connect the neopixel to pin RB13. 
- * The Neopixel library uses Timer1 module on the microcontroller. Ensure this 
- * module is not being used elsewhere.
+ * A strip of NEOPIXEL_COUNT neopixels can be connected to the same pin and
+ * driven through a frame buffer with setPixel() and show().
+ * Every color written goes through a gamma correction and the global
+ * brightness set by setBrightness(), both read from tables in program memory.
+ * Animations (blink, breathe, rainbow, strobe) are played by playAnimation():
+ * Timer1 steps through keyframes every 20 ms, and the INT2 interrupt, used as
+ * a low priority software interrupt, writes the new color.
+ * The Neopixel library uses Timer1 module and the INT2 interrupt on the
+ * microcontroller, and the SPI2 module when NEOPIXEL_USE_SPI is 1. Ensure
+ * these modules are not being used elsewhere.
  * 
  * Created on September 28, 2023, 9:46 PM
  */
 
 #include "xc.h"
+#include "stdint.h"
 #include "Neopixel_asmLib.h"
+#include "Neopixel.h"
 #include "stdio.h"
 
 #define PERIOD 5 // directive constant for number of milliseconds to delay the
 // color writing
+#define RESET_GAP 3 // low time that latches the colors, in 100 us steps (the
+// WS2812B needs more than 280 us)
+#define SDO2_FUNCTION 10 // PPS output function number of SDO2
+#define TICK_PERIOD 39999 // Timer1 period for a 20 ms animation tick
+// (0.02 seconds) * (16 * 10 ^6)/8 cycles/sec -1 = 39999
+
+// Color wheel entries built by the compiler, with the same arithmetic as the
+// original Wheel() function
+#define WHEEL_PACK(r, g, b) ((((uint32_t) (r)) << 16) | (((uint32_t) (g)) << 8) | ((uint32_t) (b)))
+#define WHEEL_RGB(q) ((q) < 85 ? WHEEL_PACK(255 - (q) * 3, 0, (q) * 3) : \
+    (q) < 170 ? WHEEL_PACK(0, ((q) - 85) * 3, 255 - ((q) - 85) * 3) : \
+    WHEEL_PACK(((q) - 170) * 3, 255 - ((q) - 170) * 3, 0))
+#define WHEEL_ENTRY(p) WHEEL_RGB(255 - (p))
+#define WHEEL_4(p) WHEEL_ENTRY(p), WHEEL_ENTRY((p) + 1), WHEEL_ENTRY((p) + 2), WHEEL_ENTRY((p) + 3)
+#define WHEEL_16(p) WHEEL_4(p), WHEEL_4((p) + 4), WHEEL_4((p) + 8), WHEEL_4((p) + 12)
+#define WHEEL_64(p) WHEEL_16(p), WHEEL_16((p) + 16), WHEEL_16((p) + 32), WHEEL_16((p) + 48)
 
 // Function declarations:
 void initNeopixel();
@@ -30,12 +56,111 @@ unsigned char getB(uint32_t RGBval);
 void writePacCol(uint32_t PackedColor);
 void blinkGreen();
 void blinkRed();
+void playAnimation(int animation, uint32_t color);
+void stopAnimation();
+int isAnimationPlaying();
+uint16_t getAnimationISRTime();
+uint16_t getAnimationISRMaxTime();
+uint32_t scaleColor(uint32_t color, uint8_t level);
+void setBrightness(uint8_t level);
+uint8_t getBrightness();
+void __attribute__((__interrupt__, __auto_psv__)) _T1Interrupt();
+void __attribute__((__interrupt__, __auto_psv__)) _INT2Interrupt();
+void setPixel(int i, uint32_t rgb);
+void show();
+void latch();
+void sendPixels(const uint8_t *grb, uint16_t n);
+void waitNeopixel();
+void fillSPI();
+void __attribute__((__interrupt__, __auto_psv__)) _SPI2Interrupt();
+
+// One step of an animation. The level is a brightness, or a Wheel() position
+// for the rainbow; it is held for the whole keyframe, or moves linearly to the
+// level of the next keyframe when fade is set
+typedef struct {
+    uint8_t level;
+    uint8_t ticks; // length of the keyframe in 20 ms ticks
+    uint8_t fade;
+} Keyframe;
+
+typedef struct {
+    const Keyframe *keyframes;
+    uint8_t count; // number of keyframes
+    uint8_t repeats; // times the keyframes are played, 0 to play forever
+    uint8_t wheel; // 1 when the levels are Wheel() positions
+} Animation;
+
+const Keyframe blinkKeyframes[] = {{255, 10, 0}, {0, 10, 0}}; // 0.2 s on, 0.2 s off
+const Keyframe breatheKeyframes[] = {{0, 75, 1}, {255, 75, 1}}; // 3 s per breath
+const Keyframe rainbowKeyframes[] = {{0, 250, 1}, {255, 1, 0}}; // 5 s per turn
+const Keyframe strobeKeyframes[] = {{255, 2, 0}, {0, 3, 0}}; // 10 Hz flashes
+const Animation animations[] = {
+    {blinkKeyframes, 2, 4, 0}, // ANIMATION_BLINK: four times in 1.6 seconds
+    {breatheKeyframes, 2, 0, 0}, // ANIMATION_BREATHE
+    {rainbowKeyframes, 2, 0, 1}, // ANIMATION_RAINBOW
+    {strobeKeyframes, 2, 0, 0} // ANIMATION_STROBE
+};
+
+// Animation state, advanced by _T1Interrupt()
+const Animation * volatile currentAnimation = 0; // 0 when no animation is playing
+volatile uint8_t keyframeIndex = 0;
+volatile uint8_t keyframeTick = 0; // ticks since the start of the keyframe
+volatile uint8_t repeatCount = 0;
+volatile uint32_t animationColor = 0; // color scaled by the levels
+volatile int frameDirty = 0; // set when the color must be written again
+
+// Execution time of _T1Interrupt(), in Timer1 ticks (0.5 us)
+volatile uint16_t isrTime = 0;
+volatile uint16_t isrMaxTime = 0;
+
+// Constant tables are kept in program memory and read through the PSV window,
+// so they take no RAM
+// Wheel() for every position, 1 kB of flash
+const uint32_t __attribute__((space(auto_psv))) wheelTable[256] = {
+    WHEEL_64(0), WHEEL_64(64), WHEEL_64(128), WHEEL_64(192)};
+
+// Gamma correction, round(255 * (i / 255) ^ 2.2): the eye sees equal steps of
+// the corrected value as equal steps of brightness
+const uint8_t __attribute__((space(auto_psv))) gammaTable[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255};
 
-volatile int overflowTMR1 = 0; // count number of times TMR1 overflows
+// Value sent for each color level: gammaTable[] scaled by the global
+// brightness, rebuilt by setBrightness() so writing a color stays one table
+// read per byte. The scaling comes after the gamma correction so the pulse
+// width, and with it the LED current, is proportional to the brightness
+uint8_t levelTable[256];
+uint8_t brightness = 0;
 
-// blinkGreen or blinkRed modes
-volatile int modeGreen = 0;
-volatile int modeRed = 0;
+// Frame buffer of the strip, 3 bytes per pixel in the order they are sent
+// (green, red, blue)
+uint8_t frame[NEOPIXEL_COUNT * 3];
+
+volatile int frameSent = 0; // set while a frame sent over SPI2 is not latched yet
+#if NEOPIXEL_USE_SPI
+// Each neopixel bit is sent as 4 SPI bits at 3.2 MHz (312.5 ns per SPI bit):
+// 1000 for a 0 (T0H 312 ns, T0L 938 ns) and 1110 for a 1 (T1H 938 ns,
+// T1L 312 ns). A 16-bit SPI word therefore carries one nibble of color
+const uint16_t nibbleSymbols[16] = {
+    0x8888, 0x888E, 0x88E8, 0x88EE, 0x8E88, 0x8E8E, 0x8EE8, 0x8EEE,
+    0xE888, 0xE88E, 0xE8E8, 0xE8EE, 0xEE88, 0xEE8E, 0xEEE8, 0xEEEE};
+const uint8_t *spiSource; // next color byte to send
+volatile uint16_t spiWordsLeft = 0; // SPI words (nibbles) left to queue
+#endif
 
 /**
  * Initializes pin RB13 to be used with the Neopixel on PIC24
@@ -45,19 +170,49 @@ void initNeopixel() {
     AD1PCFGbits.PCFG11 = 1; // Set pin RB13 (AN11) to digital mode
     TRISBbits.TRISB13 = 0; // Set pin RB6 to output
     LATBbits.LATB13 = 0; // set pin RB6 low
+    setBrightness(NEOPIXEL_BRIGHTNESS);
+#if NEOPIXEL_USE_SPI
+    SPI2STATbits.SPIEN = 0;
+    IEC2bits.SPI2IE = 0;
+    SPI2CON1 = 0;
+    SPI2CON1bits.MSTEN = 1; // master
+    SPI2CON1bits.MODE16 = 1; // 16-bit words, one nibble of color each
+    SPI2CON1bits.DISSCK = 1; // only SDO2 is used
+    SPI2CON1bits.DISSDI = 1;
+    SPI2CON1bits.PPRE = 0b11; // 1:1 primary prescale
+    SPI2CON1bits.SPRE = 0b011; // 5:1 secondary prescale, 16 MHz / 5 = 3.2 MHz
+    SPI2CON2 = 0;
+    SPI2CON2bits.SPIBEN = 1; // 8-word enhanced buffer
+    SPI2STATbits.SISEL = 0b110; // interrupt when the transmit buffer is empty
+    
+    __builtin_write_OSCCONL(OSCCON & 0xBF); // unlock PPS
+    RPOR6bits.RP13R = SDO2_FUNCTION; // SDO2 drives RP13 instead of LATB13
+    __builtin_write_OSCCONL(OSCCON | 0x40); // lock PPS
+    
+    // Higher than every other interrupt, so the buffer is refilled before the
+    // last word (5 us) has been shifted out
+    IPC8bits.SPI2IP = 6;
+    IFS2bits.SPI2IF = 0;
+    SPI2STATbits.SPIEN = 1;
+#endif
 }
 
 /**
- * Helper function to initialize Timer1 on the PIC24 for a 0.2 second period. To
- * be used with the blinkGreen() and blinkRed() functions
+ * Helper function to initialize Timer1 on the PIC24 for the 20 ms animation
+ * tick, and the INT2 interrupt that writes the colors. To be used with the
+ * playAnimation() function
  */
 void initTimer1() {
-    overflowTMR1 = 0;
-    T1CONbits.TCKPS = 0b10; // 1:64 prescale
-    PR1 = 49999; // 0.2 second period
-    // (0.2 seconds) * (16 * 10 ^6)/64 cycles/sec -1 = 49999
+    T1CON = 0;
+    TMR1 = 0;
+    T1CONbits.TCKPS = 0b01; // 1:8 prescale
+    PR1 = TICK_PERIOD;
     IEC0bits.T1IE = 1; // Enable Timer1 interrupts
     IFS0bits.T1IF = 0; // Reset Timer1 interrupt flag
+    
+    IPC7bits.INT2IP = 1; // below every other interrupt
+    IFS1bits.INT2IF = 0;
+    IEC1bits.INT2IE = 1; // only ever set by software
     T1CONbits.TON = 1; // Turn on TMR1
 }
 
@@ -69,32 +224,9 @@ void initTimer1() {
  * @param b Blue color (0-255)
  */
 void writeColor(int r, int g, int b) {
-    
-    // bit shifting to make rgb one 24-bit value with rgb
-    uint32_t rgb = 0;
-    rgb += r;
-    rgb = ( rgb << 8);
-    rgb += g;
-    rgb = (rgb << 8);
-    rgb += b;
-    
-    uint32_t grabBit = 0b100000000000000000000000; // 24 bits
-    
-    while(grabBit > 0) {
-        uint32_t selector = grabBit & rgb;
-        
-        if(selector != 0) {
-            write_1();
-        }
-        else {
-            write_0();
-        }
-        
-        grabBit = grabBit >> 1; // move one bit at a time each time during while loop
-    }
-    
-    delay(5);
-    
+    uint8_t rgb[3] = {levelTable[(uint8_t) r], levelTable[(uint8_t) g], levelTable[(uint8_t) b]};
+    sendPixels(rgb, 1);
+    waitNeopixel(); // rgb must stay in memory until it is sent
 }
 
 /**
@@ -115,19 +247,7 @@ void delay(int delay_in_ms) {
  * @return 32 bit value representing 24 bit RGB colors
  */
 uint32_t Wheel(unsigned char WheelPos) {
-    WheelPos = 255 - WheelPos;
-    
-    if(WheelPos < 85){
-        return packColor((unsigned char) 255 - WheelPos * 3, 0, (unsigned char) WheelPos * 3);
-    }
-    if (WheelPos < 170) {
-        WheelPos -= 85;
-        return packColor(0, WheelPos * 3, 255- WheelPos * 3);
-    }
-    
-    WheelPos -= 170;
-    
-    return packColor(WheelPos * 3, 255 - WheelPos * 3, 0);
+    return wheelTable[WheelPos];
 }
 
 /**
@@ -173,61 +293,289 @@ unsigned char getB(uint32_t RGBval) {
  * the NeoPixel connected to port RA0 with the given RGB values.
  */
 void writePacCol(uint32_t PackedColor) {
-    
-    uint32_t grabBit = 0b100000000000000000000000; // 24 bits
-    
-    while(grabBit > 0) {
-        uint32_t selector = grabBit & PackedColor;
-        
-        if(selector != 0) {
-            write_1();
+    uint8_t rgb[3] = {levelTable[getR(PackedColor)], levelTable[getG(PackedColor)],
+        levelTable[getB(PackedColor)]};
+    sendPixels(rgb, 1);
+    waitNeopixel(); // rgb must stay in memory until it is sent
+}
+
+/**
+ * Stores the color of one pixel of the strip in the frame buffer. The strip is
+ * only updated by show().
+ * @param i index of the pixel, 0 being the one closest to the microcontroller
+ * @param rgb 24-bit RGB value, as returned by packColor()
+ */
+void setPixel(int i, uint32_t rgb) {
+    if(i < 0 || i >= NEOPIXEL_COUNT) {
+        return;
+    }
+    waitNeopixel(); // the previous frame may still be going out over SPI2
+    frame[i * 3] = levelTable[getG(rgb)]; // the strip expects green first
+    frame[i * 3 + 1] = levelTable[getR(rgb)];
+    frame[i * 3 + 2] = levelTable[getB(rgb)];
+}
+
+/**
+ * Sends the whole frame buffer to the strip, every pixel back to back, then
+ * holds the line low once so the strip latches the new colors. Interrupts are
+ * held off while the pixels are sent, since a pause longer than the reset gap
+ * would latch half a frame. Takes 30 us per pixel (24 bits of 1.25 us) and
+ * 300 us for the reset gap. When NEOPIXEL_USE_SPI is 1, the function returns
+ * as soon as the frame is queued: the SPI2 interrupt sends it while interrupts
+ * stay enabled, and the reset gap is held before the next frame.
+ */
+void show() {
+    sendPixels(frame, NEOPIXEL_COUNT);
+}
+
+/**
+ * Helper function that holds the data line low long enough for the neopixels
+ * to latch the colors they received.
+ */
+void latch() {
+    for(int i = 0; i < RESET_GAP; i++) {
+        wait_100us();
+    }
+}
+
+/**
+ * Helper function that sends n pixels (3 bytes each, in the order the pixels
+ * expect them). The bit-banged version blocks until the pixels are latched.
+ * The SPI2 version waits for the previous frame, queues the first words and
+ * lets _SPI2Interrupt() send the rest; call waitNeopixel() before reusing grb.
+ */
+void sendPixels(const uint8_t *grb, uint16_t n) {
+#if NEOPIXEL_USE_SPI
+    waitNeopixel();
+    spiSource = grb;
+    spiWordsLeft = n * 6; // 2 words per color byte
+    frameSent = 1;
+    IFS2bits.SPI2IF = 0; // cleared before filling, so an early empty buffer still interrupts
+    fillSPI();
+    IEC2bits.SPI2IE = 1;
+#else
+    write_pixels(grb, n);
+    latch();
+#endif
+}
+
+/**
+ * Helper function that waits until the last frame sent over SPI2 has been
+ * shifted out, then holds the reset gap so it is latched. Returns right away
+ * when no frame is pending.
+ */
+void waitNeopixel() {
+    if(!frameSent) {
+        return;
+    }
+#if NEOPIXEL_USE_SPI
+    while(spiWordsLeft > 0 || SPI2STATbits.SPIBEC || !SPI2STATbits.SRMPT);
+#endif
+    latch();
+    frameSent = 0;
+}
+
+#if NEOPIXEL_USE_SPI
+/**
+ * Helper function that converts color bytes into SPI words until the transmit
+ * buffer is full or the frame has been queued. The high nibble of each byte
+ * goes first.
+ */
+void fillSPI() {
+    while(spiWordsLeft > 0 && !SPI2STATbits.SPITBF) {
+        if(spiWordsLeft & 1) { // low nibble, then move to the next byte
+            SPI2BUF = nibbleSymbols[*spiSource++ & 0x0F];
         }
         else {
-            write_0();
+            SPI2BUF = nibbleSymbols[*spiSource >> 4];
         }
-        
-        grabBit = grabBit >> 1; // move one bit at a time each time during while loop
+        spiWordsLeft--;
     }
-    
-    delay(5);
 }
 
+/**
+ * Interrupts when the SPI2 transmit buffer is empty and refills it. The
+ * interrupt is turned off once the whole frame has been queued.
+ */
+void __attribute__((__interrupt__, __auto_psv__)) _SPI2Interrupt() {
+    IFS2bits.SPI2IF = 0;
+    while(!SPI2STATbits.SRXMPT) { // nothing is received, discard the buffer
+        (void) SPI2BUF;
+    }
+    SPI2STATbits.SPIROV = 0;
+    fillSPI();
+    if(spiWordsLeft == 0) {
+        IEC2bits.SPI2IE = 0;
+    }
+}
+#endif
+
 /**
  * This function will blink the neopixel green four times in 1.6 seconds.
  */
 void blinkGreen() {
-    writeColor(0, 255, 0);
-    modeRed = 0;
-    modeGreen = 1;
-    initTimer1();
+    playAnimation(ANIMATION_BLINK, packColor(0, 255, 0));
 }
 
 /**
  * This function will blink the neopixel red four times in 1.6 seconds.
  */
 void blinkRed() {
-    writeColor(255, 0, 0);
-    modeGreen = 0;
-    modeRed = 1;
+    playAnimation(ANIMATION_BLINK, packColor(255, 0, 0));
+}
+
+/**
+ * Starts an animation on the neopixel, replacing the one playing. The function
+ * returns right away; the animation runs from interrupts.
+ * @param animation ANIMATION_BLINK, ANIMATION_BREATHE, ANIMATION_RAINBOW or
+ * ANIMATION_STROBE
+ * @param color 24-bit RGB value at full brightness, as returned by packColor().
+ * Not used by ANIMATION_RAINBOW
+ */
+void playAnimation(int animation, uint32_t color) {
+    IEC0bits.T1IE = 0;
+    currentAnimation = &animations[animation];
+    animationColor = color;
+    keyframeIndex = 0;
+    keyframeTick = 0;
+    repeatCount = 0;
+    frameDirty = 1;
     initTimer1();
+    IFS1bits.INT2IF = 1; // write the first keyframe now
 }
 
+/**
+ * Stops the animation playing and turns the neopixel off.
+ */
+void stopAnimation() {
+    IEC0bits.T1IE = 0;
+    T1CONbits.TON = 0;
+    currentAnimation = 0;
+    frameDirty = 1;
+    IFS1bits.INT2IF = 1;
+}
+
+/**
+ * @return 1 while an animation is playing, otherwise return 0
+ */
+int isAnimationPlaying() {
+    return currentAnimation != 0;
+}
+
+/**
+ * @return execution time of the last Timer1 interrupt, from the end of the
+ * Timer1 period to the end of the interrupt (interrupt latency included), in
+ * 0.5 us ticks
+ */
+uint16_t getAnimationISRTime() {
+    return isrTime;
+}
+
+/**
+ * @return longest execution time of the Timer1 interrupt, in 0.5 us ticks
+ */
+uint16_t getAnimationISRMaxTime() {
+    return isrMaxTime;
+}
+
+/**
+ * Sets the brightness of every color written from now on. The LED current is
+ * proportional to the brightness: each LED draws up to 20 mA at full
+ * brightness. Colors already in the frame buffer keep their brightness until
+ * they are set again.
+ * @param level 255 for full brightness, 0 for off
+ */
+void setBrightness(uint8_t level) {
+    brightness = level;
+    unsigned int scale = level + 1;
+    for(unsigned int i = 0; i < 256; i++) {
+        levelTable[i] = (gammaTable[i] * scale) >> 8;
+    }
+}
+
+/**
+ * @return brightness set by setBrightness()
+ */
+uint8_t getBrightness() {
+    return brightness;
+}
+
+/**
+ * Helper function that scales a color by a brightness level.
+ * @param color 24-bit RGB value
+ * @param level brightness, 255 being full brightness
+ * @return the scaled 24-bit RGB value
+ */
+uint32_t scaleColor(uint32_t color, uint8_t level) {
+    unsigned int scale = level + 1;
+    return packColor((getR(color) * scale) >> 8, (getG(color) * scale) >> 8,
+            (getB(color) * scale) >> 8);
+}
+
+/**
+ * Interrupts every 20 ms while an animation is playing. Only moves the
+ * animation forward and asks the INT2 interrupt to write the color when it
+ * changes, so it takes a few microseconds.
+ */
 void __attribute__((__interrupt__, __auto_psv__)) _T1Interrupt() {
-    overflowTMR1++;
-    if(overflowTMR1 >= 7) { // Stop blinking & turn off TMR1
-        writeColor(0, 0, 0);
-        T1CONbits.TON = 0; // Turn off TMR1
+    IFS0bits.T1IF = 0; // Reset Timer1 interrupt flag
+    const Animation *a = currentAnimation;
+    if(a) {
+        if(++keyframeTick >= a->keyframes[keyframeIndex].ticks) { // next keyframe
+            keyframeTick = 0;
+            if(++keyframeIndex >= a->count) {
+                keyframeIndex = 0;
+                if(a->repeats && ++repeatCount >= a->repeats) { // finished
+                    currentAnimation = 0;
+                    T1CONbits.TON = 0; // Turn off TMR1
+                }
+            }
+            frameDirty = 1;
+        }
+        else if(a->keyframes[keyframeIndex].fade) {
+            frameDirty = 1;
+        }
+        if(frameDirty) {
+            IFS1bits.INT2IF = 1; // write the color at low priority
+        }
+    }
+    isrTime = TMR1; // TMR1 restarted from 0 at the end of the period
+    if(isrTime > isrMaxTime) {
+        isrMaxTime = isrTime;
+    }
+}
+
+/**
+ * Software interrupt (nothing is connected to INT2) at the lowest priority:
+ * works out the color of the current animation step and writes it, so the
+ * time spent sending to the neopixel never delays another interrupt.
+ */
+void __attribute__((__interrupt__, __auto_psv__)) _INT2Interrupt() {
+    IFS1bits.INT2IF = 0;
+    if(!frameDirty) {
+        return;
     }
-    else if(overflowTMR1 % 2) { // overflow is odd, turn off neopixel
+    IEC0bits.T1IE = 0; // take a consistent copy of the state
+    frameDirty = 0;
+    const Animation *a = currentAnimation;
+    uint8_t index = keyframeIndex;
+    uint8_t tick = keyframeTick;
+    IEC0bits.T1IE = 1;
+    
+    if(!a) { // animation stopped or finished
         writeColor(0, 0, 0);
+        return;
     }
-    else { // overflow is even, turn on neopixel again
-        if(modeGreen) {
-            writeColor(0, 255, 0);
-        }
-        if(modeRed) {
-            writeColor(255, 0, 0);
-        }
+    const Keyframe *k = &a->keyframes[index];
+    int level = k->level;
+    if(k->fade) { // linear fade to the next keyframe
+        int next = a->keyframes[(index + 1) % a->count].level;
+        level += ((next - level) * tick) / k->ticks;
+    }
+    if(a->wheel) {
+        writePacCol(Wheel(level));
+    }
+    else {
+        writePacCol(scaleColor(animationColor, level));
     }
-    IFS0bits.T1IF = 0; // Reset Timer1 interrupt flag
 }
\ No newline at end of file
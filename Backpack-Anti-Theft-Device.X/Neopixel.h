@@ -4,8 +4,16 @@
  * The Neopixel library contains an assortment of functions useful for 
  * controlling the neopixel, a LED that can change color via serial 
  * communication, on the PIC24FJ64GA002. Connect the neopixel to pin RB13. 
- * The Neopixel library uses Timer1 module on the microcontroller. Ensure this 
- * module is not being used elsewhere.
+ * A strip of NEOPIXEL_COUNT neopixels can be connected to the same pin and
+ * driven through a frame buffer with setPixel() and show().
+ * Every color written goes through a gamma correction and the global
+ * brightness set by setBrightness(), both read from tables in program memory.
+ * Animations (blink, breathe, rainbow, strobe) are played by playAnimation():
+ * Timer1 steps through keyframes every 20 ms, and the INT2 interrupt, used as
+ * a low priority software interrupt, writes the new color.
+ * The Neopixel library uses Timer1 module and the INT2 interrupt on the
+ * microcontroller, and the SPI2 module when NEOPIXEL_USE_SPI is 1. Ensure
+ * these modules are not being used elsewhere.
  * 
  * Created on November 22, 2023, 11:26 AM
  */
@@ -17,6 +25,22 @@
 extern "C" {
 #endif
 
+#define NEOPIXEL_COUNT 8 // number of pixels in the strip
+
+// Set to 1 to generate the neopixel waveform with SPI2 (SDO2 mapped to RP13)
+// instead of bit-banging RB13 with interrupts held off
+#define NEOPIXEL_USE_SPI 0
+
+// Brightness set by initNeopixel(), 255 being full brightness. Half
+// brightness is plenty for a status light and halves the LED current
+#define NEOPIXEL_BRIGHTNESS 128
+
+// Animations for playAnimation()
+#define ANIMATION_BLINK 0 // four 0.2 s flashes, then off
+#define ANIMATION_BREATHE 1 // fades in and out every 3 seconds
+#define ANIMATION_RAINBOW 2 // goes around the color wheel every 5 seconds
+#define ANIMATION_STROBE 3 // 10 Hz flashes
+
 /**
  * Initializes pin RB6 to be used with the Neopixel on PIC24
  */
@@ -85,6 +109,71 @@ void blinkGreen();
  */
 void blinkRed();
 
+/**
+ * Starts an animation on the neopixel, replacing the one playing. The function
+ * returns right away; the animation runs from interrupts.
+ * @param animation ANIMATION_BLINK, ANIMATION_BREATHE, ANIMATION_RAINBOW or
+ * ANIMATION_STROBE
+ * @param color 24-bit RGB value at full brightness, as returned by packColor().
+ * Not used by ANIMATION_RAINBOW
+ */
+void playAnimation(int animation, uint32_t color);
+
+/**
+ * Stops the animation playing and turns the neopixel off.
+ */
+void stopAnimation();
+
+/**
+ * Sets the brightness of every color written from now on. The LED current is
+ * proportional to the brightness: each LED draws up to 20 mA at full
+ * brightness. Colors already in the frame buffer keep their brightness until
+ * they are set again.
+ * @param level 255 for full brightness, 0 for off
+ */
+void setBrightness(uint8_t level);
+
+/**
+ * @return brightness set by setBrightness()
+ */
+uint8_t getBrightness();
+
+/**
+ * @return 1 while an animation is playing, otherwise return 0
+ */
+int isAnimationPlaying();
+
+/**
+ * @return execution time of the last Timer1 interrupt, from the end of the
+ * Timer1 period to the end of the interrupt (interrupt latency included), in
+ * 0.5 us ticks
+ */
+uint16_t getAnimationISRTime();
+
+/**
+ * @return longest execution time of the Timer1 interrupt, in 0.5 us ticks
+ */
+uint16_t getAnimationISRMaxTime();
+
+/**
+ * Stores the color of one pixel of the strip in the frame buffer. The strip is
+ * only updated by show().
+ * @param i index of the pixel, 0 being the one closest to the microcontroller
+ * @param rgb 24-bit RGB value, as returned by packColor()
+ */
+void setPixel(int i, uint32_t rgb);
+
+/**
+ * Sends the whole frame buffer to the strip, every pixel back to back, then
+ * holds the line low once so the strip latches the new colors. Interrupts are
+ * held off while the pixels are sent, since a pause longer than the reset gap
+ * would latch half a frame. Takes 30 us per pixel (24 bits of 1.25 us) and
+ * 300 us for the reset gap. When NEOPIXEL_USE_SPI is 1, the function returns
+ * as soon as the frame is queued: the SPI2 interrupt sends it while interrupts
+ * stay enabled, and the reset gap is held before the next frame.
+ */
+void show();
+
 
 #ifdef	__cplusplus
 }
@@ -8,15 +8,22 @@
 #ifndef NEOPIXEL_ASMLIB_H
 #define	NEOPIXEL_ASMLIB_H
 
+#include "stdint.h"
+
 #ifdef	__cplusplus
 extern "C" {
 #endif
 
-void write_0(void);
-void write_1(void);
 void wait_100us(void);
 void wait_1ms(void);
 
+/**
+ * Sends n pixels (3 bytes each, in the order the pixels expect them) back to
+ * back on RB13 with interrupts held off. Every bit takes 20 cycles. The caller
+ * holds the line low afterwards so the pixels latch the colors.
+ */
+void write_pixels(const uint8_t *grb, uint16_t n);
+
 #ifdef	__cplusplus
 }
 #endif
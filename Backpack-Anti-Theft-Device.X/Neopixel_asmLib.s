@@ -9,40 +9,8 @@
 ; underscore (_) and be included in a comment delimited list below.
 .global _example_public_function, _second_public_function
     
-    .global _write_0, _write_1, _wait_100us, _wait_1ms
+    .global _wait_100us, _wait_1ms, _write_pixels
 
-_write_0: ; TOTAL : 6 highs, 14 lows
-    
-    BSET LATB, #13
-    repeat #3
-    nop
-
-    ; 14 LOW (Note, 3 low during return, 2 low during next function call)
-    
-    ; --- 9 cycles ---
-    BCLR LATB, #13 ; 1 cycle for clr
-    repeat #6
-    nop
-    ; ----------------
-    
-    return ; 3 cycles
-	
-_write_1: ; TOTAL: 11 HIGH, 9 LOW
-    
-    ; 11 HIGH
-    BSET LATB, #13
-    repeat #8
-    nop
-    
-    ; 9 LOW ( Note, 3 low during return, 2 low during next function call)
-    
-    ; -- 4 cycles ---
-    BCLR LATB, #13
-    repeat #1
-    nop
-    
-    return ; 3 cycles
-    
 _wait_100us:
     repeat #1593 ; 1 cycle to load and prep
     nop ; 11 cycles to execute NOP 
@@ -53,6 +21,86 @@ _wait_1ms:
     nop
     return
     ; total 16000 cycles
+
+; Sends one bit of W2 in exactly 20 cycles (1.25 us at 16 MIPS). The line goes
+; high at cycle 0 and low at cycle 6 for a 0 (T0H 375 ns, T0L 875 ns) or at
+; cycle 12 for a 1 (T1H 750 ns, T1L 500 ns). BTSS takes 1 cycle when it does
+; not skip and 2 when it skips the first BCLR, so both paths reach cycle 7
+; together.
+.macro SEND_BIT bit
+    BSET LATB, #13 ; cycle 0
+    nop ; 1
+    nop ; 2
+    nop ; 3
+    nop ; 4
+    BTSS W2, #\bit ; 5 (5-6 when the bit is 1)
+    BCLR LATB, #13 ; 6, end of a 0
+    nop ; 7
+    nop ; 8
+    nop ; 9
+    nop ; 10
+    nop ; 11
+    BCLR LATB, #13 ; 12, end of a 1
+    nop ; 13
+    nop ; 14
+    nop ; 15
+    nop ; 16
+    nop ; 17
+    nop ; 18
+    nop ; 19
+.endm
+
+; void write_pixels(const uint8_t *grb, uint16_t n)
+; W0: pointer to 3 * n bytes, in the order the pixels expect them
+; W1: number of pixels
+; Sends every byte back to back, most significant bit first, with the CPU
+; priority raised to 7 so that no interrupt can stretch a bit. The caller must
+; hold the line low afterwards (reset gap) for the pixels to latch the colors.
+_write_pixels:
+    cp0 W1
+    bra z, write_pixels_return ; nothing to send
+    push SR ; save the CPU priority
+    bset SR, #5
+    bset SR, #6
+    bset SR, #7 ; IPL = 7, interrupts held off
+    add W1, W1, W4
+    add W4, W1, W4 ; W4 = bytes left to send (3 * n)
+    mov.b [W0++], W2 ; first byte
+
+write_pixels_byte:
+    SEND_BIT 7
+    SEND_BIT 6
+    SEND_BIT 5
+    SEND_BIT 4
+    SEND_BIT 3
+    SEND_BIT 2
+    SEND_BIT 1
+    
+    ; bit 0: same timing as SEND_BIT, with the byte loop in the low time
+    BSET LATB, #13 ; cycle 0
+    nop ; 1
+    nop ; 2
+    nop ; 3
+    nop ; 4
+    BTSS W2, #0 ; 5 (5-6 when the bit is 1)
+    BCLR LATB, #13 ; 6, end of a 0
+    nop ; 7
+    nop ; 8
+    nop ; 9
+    nop ; 10
+    nop ; 11
+    BCLR LATB, #13 ; 12, end of a 1
+    dec W4, W4 ; 13
+    bra z, write_pixels_done ; 14 (14-15 when the frame is done)
+    mov.b [W0++], W2 ; 15, next byte: never read past the end of the buffer
+    nop ; 16
+    nop ; 17
+    bra write_pixels_byte ; 18-19
+    
+write_pixels_done:
+    pop SR ; restore the CPU priority
+write_pixels_return:
+    return
     
     
     
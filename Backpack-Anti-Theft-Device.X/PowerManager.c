@@ -0,0 +1,185 @@
+/*
+ * File:   PowerManager.c
+ * Author: Sharmarke Ahmed
+ * The PowerManager library keeps the system timebase of the device and puts
+ * the PIC24FJ64GA002 into a low-power mode while it waits for an interrupt.
+ * It also counts how long the CPU spends awake and asleep, so the duty cycle
+ * of the device can be measured, and measures the supply (battery) voltage
+ * against the internal band gap reference. The library uses Timer4 on the
+ * microcontroller. Ensure this module is not being used elsewhere. Initialize
+ * the library with the initPowerManager() function before using other
+ * functions.
+ *
+ * Created on December 6, 2023, 3:40 PM
+ */
+
+
+#include "xc.h"
+#include "stdint.h"
+#include "PowerManager.h"
+
+#define BAND_GAP_MV 1200 // nominal voltage of the band gap reference
+#define BAND_GAP_SETTLE_TICKS 63 // 1 ms for the band gap to settle
+
+// Function declarations
+void initPowerManager();
+uint32_t getTicks();
+void sleepUntilInterrupt(int mode);
+uint32_t getAwakeTicks();
+uint32_t getSleepTicks();
+void resetDutyCycle();
+unsigned int getSupplyMillivolts();
+void __attribute__((__interrupt__, __auto_psv__)) _T4Interrupt();
+
+// The device can only run for a maximum of ~19 hours with a 32 bit timer. Use
+// 64-bit values for very long term applications
+volatile uint32_t overflowTMR4 = 0;
+
+uint32_t awakeTicks = 0;
+uint32_t sleepTicks = 0;
+uint32_t lastWake = 0; // time the CPU last woke up (or the counters were reset)
+
+/**
+ * Initializes Timer4 as a free-running timebase with a period of 1.05 seconds
+ * (16 microseconds per tick) and resets the duty cycle counters.
+ */
+void initPowerManager() {
+    CLKDIVbits.RCDIV = 0; // 16MHz instruction clock
+    overflowTMR4 = 0;
+    T4CON = 0;
+    TMR4 = 0;
+    
+    T4CONbits.TCKPS = 0b11; // 1:256 prescale
+    PR4 = 65535;
+    
+    // Enable interrupts and disable interrupt flag for TMR4
+    _T4IE = 1;
+    _T4IF = 0;
+    T4CONbits.TON = 1; // Turn on TMR4
+    resetDutyCycle();
+}
+
+/**
+ * @return number of Timer4 ticks (16 microseconds each) since
+ * initPowerManager() was called. Can be called from interrupts
+ */
+uint32_t getTicks() {
+    uint32_t overflows;
+    uint16_t ticks;
+    int pending;
+    do { // read again if TMR4 overflowed between the two reads
+        overflows = overflowTMR4;
+        ticks = TMR4;
+        pending = _T4IF;
+    } while(overflows != overflowTMR4);
+    if(pending && ticks < 0x8000) { // called from an interrupt that holds off
+        // _T4Interrupt(): TMR4 has wrapped but the overflow is not counted yet
+        overflows++;
+    }
+    return (overflows << 16) | ticks;
+}
+
+/**
+ * Puts the CPU in a low-power mode until the next enabled interrupt, then
+ * returns. Check for events before calling this function: an event flagged
+ * between the check and the call is only seen after the next interrupt.
+ * @param mode POWER_IDLE keeps the timers and the ADC running. POWER_SLEEP
+ * also stops them (including this library's timebase), so only pin interrupts
+ * such as the push button or the accelerometer can wake the CPU
+ */
+void sleepUntilInterrupt(int mode) {
+    uint32_t start = getTicks();
+    awakeTicks += start - lastWake;
+    if(mode == POWER_SLEEP) {
+        Sleep();
+    }
+    else {
+        Idle();
+    }
+    lastWake = getTicks();
+    sleepTicks += lastWake - start;
+}
+
+/**
+ * @return number of Timer4 ticks the CPU has spent awake since the duty cycle
+ * counters were last reset
+ */
+uint32_t getAwakeTicks() {
+    return awakeTicks + (getTicks() - lastWake);
+}
+
+/**
+ * @return number of Timer4 ticks the CPU has spent in Idle since the duty
+ * cycle counters were last reset. Time spent in Sleep is not counted since
+ * Timer4 stops during Sleep
+ */
+uint32_t getSleepTicks() {
+    return sleepTicks;
+}
+
+/**
+ * Resets the awake and asleep counters to zero.
+ */
+void resetDutyCycle() {
+    awakeTicks = 0;
+    sleepTicks = 0;
+    lastWake = getTicks();
+}
+
+/**
+ * Measures the supply voltage, i.e. the voltage of the batteries, by
+ * converting the internal band gap reference (AN15, 1.2 V) against VDD. The
+ * ADC is borrowed for about 1 ms and its settings are restored afterwards, so
+ * the light sensor only misses a sample.
+ * @return supply voltage in millivolts
+ */
+unsigned int getSupplyMillivolts() {
+    int interruptOn = IEC0bits.AD1IE;
+    IEC0bits.AD1IE = 0;
+    unsigned int con1 = AD1CON1; // settings of the light sensor
+    unsigned int con2 = AD1CON2;
+    unsigned int con3 = AD1CON3;
+    unsigned int chs = AD1CHS;
+    unsigned int cssl = AD1CSSL;
+    unsigned int pcfg = AD1PCFG;
+    
+    AD1CON1 = 0; // turn the ADC off before changing it
+    AD1PCFGbits.PCFG15 = 0; // enable the band gap reference input
+    AD1CON2 = 0; // AVDD and AVSS references, no scan
+    AD1CON3 = 0;
+    AD1CON3bits.ADCS = 1; // TAD = 2 Tcy
+    AD1CON3bits.SAMC = 31; // long sampling time for the band gap
+    AD1CHS = 15; // AN15 is the band gap reference
+    AD1CON1bits.SSRC = 0b111; // convert when the sampling time ends
+    AD1CON1bits.ADON = 1;
+    uint32_t start = getTicks();
+    while(getTicks() - start < BAND_GAP_SETTLE_TICKS);
+    AD1CON1bits.DONE = 0;
+    AD1CON1bits.SAMP = 1;
+    while(!AD1CON1bits.DONE);
+    unsigned int reading = ADC1BUF0;
+    
+    AD1CON1bits.ADON = 0;
+    AD1PCFG = pcfg;
+    AD1CSSL = cssl;
+    AD1CHS = chs;
+    AD1CON3 = con3;
+    AD1CON2 = con2;
+    IFS0bits.AD1IF = 0;
+    AD1CON1 = con1; // turns the ADC back on if it was on
+    IEC0bits.AD1IE = interruptOn;
+    
+    if(reading == 0) {
+        return 0;
+    }
+    return (BAND_GAP_MV * 1024UL) / reading; // reading = 1.2 V * 1024 / VDD
+}
+
+/**
+ * Interrupts on TMR4 overflow, incrementing the global variable to keep
+ * track of how many times TMR4 has overflowed
+ */
+void __attribute__((__interrupt__, __auto_psv__)) _T4Interrupt() {
+    overflowTMR4++;
+    _T4IF = 0; // Reset TImer4 interrupt flag
+}
@@ -0,0 +1,82 @@
+/*
+ * File:   PowerManager.h
+ * Author: Sharmarke Ahmed
+ * The PowerManager library keeps the system timebase of the device and puts
+ * the PIC24FJ64GA002 into a low-power mode while it waits for an interrupt.
+ * It also counts how long the CPU spends awake and asleep, so the duty cycle
+ * of the device can be measured, and measures the supply (battery) voltage
+ * against the internal band gap reference. The library uses Timer4 on the
+ * microcontroller. Ensure this module is not being used elsewhere. Initialize
+ * the library with the initPowerManager() function before using other
+ * functions.
+ *
+ * Created on December 6, 2023, 3:40 PM
+ */
+
+#ifndef POWERMANAGER_H
+#define	POWERMANAGER_H
+
+#include "stdint.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define POWER_IDLE 0 // CPU stops, peripherals (timers, ADC, I2C) keep running
+#define POWER_SLEEP 1 // CPU and peripheral clocks stop; only pin interrupts wake
+
+/**
+ * Initializes Timer4 as a free-running timebase with a period of 1.05 seconds
+ * (16 microseconds per tick) and resets the duty cycle counters.
+ */
+void initPowerManager();
+
+/**
+ * @return number of Timer4 ticks (16 microseconds each) since
+ * initPowerManager() was called. Can be called from interrupts
+ */
+uint32_t getTicks();
+
+/**
+ * Puts the CPU in a low-power mode until the next enabled interrupt, then
+ * returns. Check for events before calling this function: an event flagged
+ * between the check and the call is only seen after the next interrupt.
+ * @param mode POWER_IDLE keeps the timers and the ADC running. POWER_SLEEP
+ * also stops them (including this library's timebase), so only pin interrupts
+ * such as the push button or the accelerometer can wake the CPU
+ */
+void sleepUntilInterrupt(int mode);
+
+/**
+ * @return number of Timer4 ticks the CPU has spent awake since the duty cycle
+ * counters were last reset
+ */
+uint32_t getAwakeTicks();
+
+/**
+ * @return number of Timer4 ticks the CPU has spent in Idle since the duty
+ * cycle counters were last reset. Time spent in Sleep is not counted since
+ * Timer4 stops during Sleep
+ */
+uint32_t getSleepTicks();
+
+/**
+ * Resets the awake and asleep counters to zero.
+ */
+void resetDutyCycle();
+
+/**
+ * Measures the supply voltage, i.e. the voltage of the batteries, by
+ * converting the internal band gap reference (AN15, 1.2 V) against VDD. The
+ * ADC is borrowed for about 1 ms and its settings are restored afterwards, so
+ * the light sensor only misses a sample.
+ * @return supply voltage in millivolts
+ */
+unsigned int getSupplyMillivolts();
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* POWERMANAGER_H */
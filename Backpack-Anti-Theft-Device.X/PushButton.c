@@ -11,6 +11,11 @@
  * interrupt on the PIC24. To use this library, first initialize the PushButton
  * using the initPushButton() function. Then, call the isButtonPressed() function
  * when wanting to determine whether the button was pressed.
+ * The change notification interrupt stores every press and release, stamped
+ * with the PowerManager timebase, in a queue that the main code reads in
+ * batches. getButtonGesture() turns them into short presses, long presses,
+ * double presses and a knock code (a rhythm of presses set by the owner) used
+ * to disarm the device.
  * Created on November 22, 2023, 7:18 PM
  */
 
@@ -18,11 +23,52 @@
 #include "xc.h"
 #include "stdint.h"
 #include "Neopixel.h"
+#include "PushButton.h"
+#include "PowerManager.h"
+
+#define QUEUE_MASK (BUTTON_QUEUE_SIZE - 1)
+#define LONG_PRESS_TICKS 62500 // 1 s in PowerManager ticks (16 us)
+#define DOUBLE_PRESS_TICKS 25000 // 0.4 s, longest gap of a double press
+#define KNOCK_SHORT_GAP_TICKS 25000 // 0.4 s, longest short gap of a knock
+#define KNOCK_GAP_TICKS 75000 // 1.2 s, a longer pause ends the knock
+#define GESTURE_QUEUE_SIZE 4 // gestures recognized but not returned yet
 
 void initPushButton();
 int isButtonPressed();
+int getButtonGesture();
+int readButtonEvents(ButtonEvent *events, int max);
+unsigned int getButtonEventsDropped();
+void setKnockCode(uint8_t gaps, uint8_t length);
+void recordKnockCode();
+int hasKnockCode();
+void buttonEvent(uint32_t time, int pressed);
+uint32_t sequenceTimeout();
+void endSequence();
+void pushGesture(int gesture);
+void __attribute__((__interrupt__,__auto_psv__)) _CNInterrupt(void);
+
+// Queue of press and release events. Only the interrupt writes queueHead and
+// only readButtonEvents() writes queueTail, so neither needs interrupts off.
+// The slots are volatile too, so the compiler keeps the slot accesses on the
+// right side of the queueHead and queueTail accesses that hand them over
+volatile ButtonEvent queue[BUTTON_QUEUE_SIZE];
+volatile uint8_t queueHead = 0; // next event written by the interrupt
+volatile uint8_t queueTail = 0; // next event read by the main code
+volatile unsigned int eventsDropped = 0;
 
-volatile int buttonPress = 0;
+// Gesture recognizer state, only used by the main code. Presses less than
+// sequenceTimeout() apart form a sequence, which is turned into a gesture
+// when it ends (or as soon as it matches the knock code)
+int buttonDown = 0;
+uint32_t pressTime = 0; // time of the last press
+uint32_t releaseTime = 0; // time of the last release
+uint8_t knockPresses = 0; // presses in the current sequence, 0 when none
+uint8_t knockGaps = 0; // gaps of the current sequence, 1 for long
+uint8_t knockCode = 0; // gaps of the knock code
+uint8_t knockLength = 0; // gaps in the knock code, 0 when not set
+int recordingKnock = 0;
+uint8_t gestures[GESTURE_QUEUE_SIZE];
+uint8_t gestureCount = 0;
 
 /**
  * Initialize pin RP15 in detecting button presses. The function will initialize
@@ -30,7 +76,11 @@ volatile int buttonPress = 0;
  * resistor for it.
  */
 void initPushButton() {
-    buttonPress = 0;
+    queueHead = 0;
+    queueTail = 0;
+    gestureCount = 0;
+    knockPresses = 0;
+    buttonDown = 0;
     CLKDIVbits.RCDIV = 0;  //Set RCDIV=1:1 (default 2:1) 32MHz or FCY/2=16M
     AD1PCFGbits.PCFG9 = 1; // Configure pin RP15 (AN9) as digital
     TRISBbits.TRISB15 = 1; // Set pin RP15 as input
@@ -45,11 +95,10 @@ void initPushButton() {
 /**
  * @return 1 if a button was pressed, otherwise return 0. Note that after
  * returning that a button was pressed, the function will discard that button
- * press and return 0 until the next press
+ * press and return 0 until the next press. Any gesture counts as a press
  */
 int isButtonPressed() {
-    if(buttonPress) {
-        buttonPress = 0;
+    if(getButtonGesture() != BUTTON_NONE) {
         return 1;
     }
     else {
@@ -57,9 +106,214 @@ int isButtonPressed() {
     }
 }
 
+/**
+ * Reads the events waiting in the queue and returns the next gesture
+ * recognized. A short press is only reported once the time for a double press
+ * has passed (the time for a knock, 1.2 s, while a knock code is set or being
+ * recorded), so call this function again later (e.g. every time the CPU wakes
+ * up) to get it. No short or double press is reported while a knock code is
+ * being recorded.
+ * @return BUTTON_NONE, BUTTON_SHORT_PRESS, BUTTON_LONG_PRESS,
+ * BUTTON_DOUBLE_PRESS, BUTTON_KNOCK_CODE or BUTTON_KNOCK_SET
+ */
+int getButtonGesture() {
+    ButtonEvent events[BUTTON_QUEUE_SIZE];
+    int count = readButtonEvents(events, BUTTON_QUEUE_SIZE);
+    for(int i = 0; i < count; i++) {
+        buttonEvent(events[i].time, events[i].pressed);
+    }
+    
+    if(!buttonDown && knockPresses && getTicks() - releaseTime > sequenceTimeout()) {
+        endSequence();
+    }
+    
+    if(gestureCount == 0) {
+        return BUTTON_NONE;
+    }
+    int gesture = gestures[0];
+    gestureCount--;
+    for(int i = 0; i < gestureCount; i++) {
+        gestures[i] = gestures[i + 1];
+    }
+    return gesture;
+}
+
+/**
+ * Moves the press and release events waiting in the queue to events, oldest
+ * first. The queue is written by the change notification interrupt and read
+ * here without turning interrupts off.
+ * @param events array that receives the events
+ * @param max size of events, at most BUTTON_QUEUE_SIZE is useful
+ * @return number of events moved
+ */
+int readButtonEvents(ButtonEvent *events, int max) {
+    uint8_t head = queueHead; // events up to here are complete
+    uint8_t tail = queueTail;
+    int count = 0;
+    while(tail != head && count < max) {
+        events[count].time = queue[tail].time;
+        events[count].pressed = queue[tail].pressed;
+        count++;
+        tail = (tail + 1) & QUEUE_MASK;
+    }
+    queueTail = tail; // frees the slots for the interrupt
+    return count;
+}
+
+/**
+ * @return number of events lost because the queue was full
+ */
+unsigned int getButtonEventsDropped() {
+    return eventsDropped;
+}
+
+/**
+ * Sets the knock code: length + 1 short presses, with the gap after press i
+ * (bit i of gaps) short (0, under 0.4 s) or long (1, 0.4 s to 1.2 s).
+ * @param gaps one bit per gap, first gap in bit 0
+ * @param length number of gaps, 1 to 8. 0 removes the knock code
+ */
+void setKnockCode(uint8_t gaps, uint8_t length) {
+    if(length > 8) {
+        length = 8;
+    }
+    knockCode = gaps;
+    knockLength = length;
+    recordingKnock = 0;
+}
+
+/**
+ * Records the next sequence of presses (at least two, ended by a pause of more
+ * than 1.2 s) as the knock code. getButtonGesture() returns BUTTON_KNOCK_SET
+ * once it is recorded.
+ */
+void recordKnockCode() {
+    recordingKnock = 1;
+    knockPresses = 0;
+}
+
+/**
+ * @return 1 if a knock code is set, otherwise return 0
+ */
+int hasKnockCode() {
+    return knockLength != 0;
+}
+
+/**
+ * Helper function that feeds one press or release to the gesture recognizer.
+ * Repeated presses or releases (an edge lost to a full queue) are ignored.
+ * A press that comes after the end of a sequence first turns that sequence
+ * into its gesture, even when getButtonGesture() was not called in between.
+ */
+void buttonEvent(uint32_t time, int pressed) {
+    if(pressed) {
+        if(buttonDown) {
+            return;
+        }
+        buttonDown = 1;
+        uint32_t gap = time - releaseTime;
+        if(knockPresses && gap > sequenceTimeout()) {
+            endSequence();
+        }
+        if(knockPresses) { // next press of the sequence
+            if(knockPresses <= 8 && gap > KNOCK_SHORT_GAP_TICKS) {
+                knockGaps |= 1 << (knockPresses - 1);
+            }
+            if(knockPresses < 255) {
+                knockPresses++;
+            }
+        }
+        else { // first press of a sequence
+            knockPresses = 1;
+            knockGaps = 0;
+        }
+        pressTime = time;
+        return;
+    }
+    
+    if(!buttonDown) {
+        return;
+    }
+    buttonDown = 0;
+    releaseTime = time;
+    if(time - pressTime >= LONG_PRESS_TICKS) {
+        knockPresses = 0; // a long press is never part of a knock
+        pushGesture(BUTTON_LONG_PRESS);
+        return;
+    }
+    if(!recordingKnock && knockLength && knockPresses == knockLength + 1
+            && knockGaps == knockCode) {
+        knockPresses = 0;
+        pushGesture(BUTTON_KNOCK_CODE);
+        return;
+    }
+    if(!recordingKnock && !knockLength && knockPresses == 2) { // no knock to
+        knockPresses = 0; // wait for, the second press ends the sequence
+        pushGesture(BUTTON_DOUBLE_PRESS);
+    }
+}
+
+/**
+ * Helper function that gives the longest gap between two presses of a
+ * sequence: the double press time, or the knock time while a knock code is
+ * set or being recorded.
+ */
+uint32_t sequenceTimeout() {
+    if(recordingKnock || knockLength) {
+        return KNOCK_GAP_TICKS;
+    }
+    return DOUBLE_PRESS_TICKS;
+}
+
+/**
+ * Helper function that turns the sequence of presses that just ended into its
+ * gesture: the new knock code while one is being recorded (at least two
+ * presses), otherwise a short press or a double press. Other sequences, such
+ * as a wrong knock, give no gesture.
+ */
+void endSequence() {
+    if(recordingKnock) {
+        if(knockPresses >= 2 && knockPresses <= 9) {
+            setKnockCode(knockGaps, knockPresses - 1);
+            pushGesture(BUTTON_KNOCK_SET);
+        }
+    }
+    else if(knockPresses == 1) {
+        pushGesture(BUTTON_SHORT_PRESS);
+    }
+    else if(knockPresses == 2 && !(knockGaps & 1)) {
+        pushGesture(BUTTON_DOUBLE_PRESS);
+    }
+    knockPresses = 0;
+}
+
+/**
+ * Helper function that keeps a recognized gesture until getButtonGesture()
+ * returns it. The oldest gesture is dropped when there is no room left.
+ */
+void pushGesture(int gesture) {
+    if(gestureCount == GESTURE_QUEUE_SIZE) {
+        gestureCount--;
+        for(int i = 0; i < gestureCount; i++) {
+            gestures[i] = gestures[i + 1];
+        }
+    }
+    gestures[gestureCount++] = gesture;
+}
+
+/**
+ * Stores the new state of the button with the time it changed. Takes the same
+ * time whatever the state of the queue: the event is dropped when it is full.
+ */
 void __attribute__((__interrupt__,__auto_psv__)) _CNInterrupt(void) {
     IFS1bits.CNIF = 0;
-    if(PORTBbits.RB15 == 0) {
-        buttonPress = 1;
+    uint8_t head = queueHead;
+    uint8_t next = (head + 1) & QUEUE_MASK;
+    if(next == queueTail) { // full, the main code has fallen behind
+        eventsDropped++;
+        return;
     }
-}
+    queue[head].time = getTicks();
+    queue[head].pressed = PORTBbits.RB15 == 0;
+    queueHead = next; // publish the event once it is complete
+}
\ No newline at end of file
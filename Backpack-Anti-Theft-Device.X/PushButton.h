@@ -11,16 +11,40 @@
  * interrupt on the PIC24. To use this library, first initialize the PushButton
  * using the initPushButton() function. Then, call the isButtonPressed() function
  * when wanting to determine whether the button was pressed.
+ * The change notification interrupt stores every press and release, stamped
+ * with the PowerManager timebase, in a queue that the main code reads in
+ * batches. getButtonGesture() turns them into short presses, long presses,
+ * double presses and a knock code (a rhythm of presses set by the owner) used
+ * to disarm the device.
  * Created on November 22, 2023, 7:18 PM
  */
 
 #ifndef PUSHBUTTON_H
 #define	PUSHBUTTON_H
 
+#include "stdint.h"
+
 #ifdef	__cplusplus
 extern "C" {
 #endif
 
+// Gestures returned by getButtonGesture()
+#define BUTTON_NONE 0
+#define BUTTON_SHORT_PRESS 1 // pressed and released, then nothing for 0.4 s
+                             // (1.2 s while a knock code is set)
+#define BUTTON_LONG_PRESS 2 // held for 1 second or more
+#define BUTTON_DOUBLE_PRESS 3 // two short presses less than 0.4 s apart
+#define BUTTON_KNOCK_CODE 4 // the presses matched the knock code
+#define BUTTON_KNOCK_SET 5 // a new knock code was recorded
+
+#define BUTTON_QUEUE_SIZE 16 // press and release events kept, a power of 2
+
+// A press or a release of the button
+typedef struct {
+    uint32_t time; // PowerManager ticks (16 us)
+    uint8_t pressed; // 1 for a press, 0 for a release
+} ButtonEvent;
+
 /**
  * Initialize pin RP15 in detecting button presses. The function will initialize
  * the change notification interrupt for the pin and the internal pull-up
@@ -31,10 +55,57 @@ void initPushButton();
 /**
  * @return 1 if a button was pressed, otherwise return 0. Note that after
  * returning that a button was pressed, the function will discard that button
- * press and return 0 until the next press
+ * press and return 0 until the next press. Any gesture counts as a press
  */
 int isButtonPressed();
 
+/**
+ * Reads the events waiting in the queue and returns the next gesture
+ * recognized. A short press is only reported once the time for a double press
+ * has passed (the time for a knock, 1.2 s, while a knock code is set or being
+ * recorded), so call this function again later (e.g. every time the CPU wakes
+ * up) to get it. No short or double press is reported while a knock code is
+ * being recorded.
+ * @return BUTTON_NONE, BUTTON_SHORT_PRESS, BUTTON_LONG_PRESS,
+ * BUTTON_DOUBLE_PRESS, BUTTON_KNOCK_CODE or BUTTON_KNOCK_SET
+ */
+int getButtonGesture();
+
+/**
+ * Moves the press and release events waiting in the queue to events, oldest
+ * first. The queue is written by the change notification interrupt and read
+ * here without turning interrupts off.
+ * @param events array that receives the events
+ * @param max size of events, at most BUTTON_QUEUE_SIZE is useful
+ * @return number of events moved
+ */
+int readButtonEvents(ButtonEvent *events, int max);
+
+/**
+ * @return number of events lost because the queue was full
+ */
+unsigned int getButtonEventsDropped();
+
+/**
+ * Sets the knock code: length + 1 short presses, with the gap after press i
+ * (bit i of gaps) short (0, under 0.4 s) or long (1, 0.4 s to 1.2 s).
+ * @param gaps one bit per gap, first gap in bit 0
+ * @param length number of gaps, 1 to 8. 0 removes the knock code
+ */
+void setKnockCode(uint8_t gaps, uint8_t length);
+
+/**
+ * Records the next sequence of presses (at least two, ended by a pause of more
+ * than 1.2 s) as the knock code. getButtonGesture() returns BUTTON_KNOCK_SET
+ * once it is recorded.
+ */
+void recordKnockCode();
+
+/**
+ * @return 1 if a knock code is set, otherwise return 0
+ */
+int hasKnockCode();
+
 
 #ifdef	__cplusplus
 }
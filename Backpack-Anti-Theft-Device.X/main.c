@@ -3,8 +3,10 @@
 #include "Accelerometer.h"
 #include "PushButton.h"
 #include "Alarm.h"
+#include "AlarmSounds.h"
 #include "Neopixel.h"
 #include "LightSensor.h"
+#include "PowerManager.h"
 
 
 // CW1: FLASH CONFIGURATION WORD 1 (see PIC24 Family Reference Manual 24.1)
@@ -24,16 +26,13 @@
 #pragma config FNOSC = FRCPLL      // Oscillator Select (Fast RC Oscillator with PLL module (FRCPLL))
 
 
-// The device can only run for a maximum of ~19 hours with a 32 bit timer. Use
-// 64-bit values for very long term applications
-volatile uint32_t overflowTMR4 = 0;
 volatile uint32_t time1 = 0;
 volatile uint32_t time2 = 0;
 
 
 void setup();
 void loop();
-void __attribute__((__interrupt__, __auto_psv__)) _T4Interrupt();
+int disarmRequested();
 
 
 
@@ -45,90 +44,122 @@ int main(){
 }
 
 void setup() {
+    initPowerManager(); // Timer4 timebase used for the waiting periods below
     initAlarm(10);
     initAccelerometer();
     initNeopixel();
     initPushButton();
     initLightSensor();
-    
-    // Initialize TMR4 for a 1 second period
-    T4CON = 0;
-    TMR4 = 0;
-    
-    T4CONbits.TCKPS = 0b11;
-    PR4 = 65535;
-    
-    // Enable interrupts and disable interrupt flag for TMR4
-    _T4IE = 1;
-    _T4IF = 0;
-    T4CONbits.TON = 1; // Turn on TMR4
 }
 
 void loop() {
     int exitMechanism = 0; // variable to track whether or not the user wishes
     // to turn off the anti theft mechanism after the device is turned on
     while(1) {
-        if(isButtonPressed()) { // Turn on security mechanism
+        int gesture = getButtonGesture();
+        if(gesture == BUTTON_LONG_PRESS) { // the next presses are the new
+            // knock code that turns the device off
+            recordKnockCode();
+            playAnimation(ANIMATION_BREATHE, packColor(0, 0, 255));
+        }
+        else if(gesture == BUTTON_KNOCK_SET) {
+            stopAnimation();
+        }
+        else if(gesture == BUTTON_SHORT_PRESS) { // Turn on security mechanism
             blinkGreen(); // indicate mechanism is ON
-            time1 = TMR4 + overflowTMR4 * 65535;
+            time1 = getTicks();
             time2 = time1;
             uint32_t difference = time2 - time1;
             while( difference < (uint32_t) (65535 * 7) && !exitMechanism) { // wait 7 seconds for person to store
                 // device before actually turning on security mechanism
-                time2 = TMR4 + overflowTMR4 * 65535;
+                time2 = getTicks();
                 difference = time2 - time1;
-                if(isButtonPressed()) { // Turn off device
+                if(disarmRequested()) { // Turn off device
                     exitMechanism = 1;
                 }
+                sleepUntilInterrupt(POWER_IDLE);
             }
             if(!exitMechanism) { // Turn on security mechanism
+                initAccelerometerGovernor(); // 10 Hz low power until the
+                // bag starts moving
+                resetMovementDetection();
+                calibrateLightSensor(); // light level of the closed backpack
+                initLightWatch(); // comparator instead of the ADC until the
+                // backpack brightens
                 while(!exitMechanism) {
-                    if(isButtonPressed()) { // Check if user wants to turn off
+                    if(disarmRequested()) { // Check if user wants to turn off
                         // the device
                         exitMechanism = 1;
                     }
                     if(movementDetected() || lightDetected()) {
+                        // full rate and resolution for the grace period
+                        setAccelerometerTier(ACCEL_TIER_ALARM);
                         // wait 4 seconds, make sure the owner of the backpack
                         // is not about to turn off the device first
-                        time1 = TMR4 + overflowTMR4 * 65535;
+                        time1 = getTicks();
                         time2 = time1;
                         difference = time2 - time1;
                         while( difference < (uint32_t) (65535 * 4) && !exitMechanism) { 
                             // wait 4 seconds, make sure the owner of the 
                             // backpack is not about to turn off the device 
                             // first
-                            time2 = TMR4 + overflowTMR4 * 65535;
+                            time2 = getTicks();
                             difference = time2 - time1;
-                            if(isButtonPressed()) {
+                            if(disarmRequested()) {
                                 exitMechanism = 1;
                             }
+                            sleepUntilInterrupt(POWER_IDLE);
                         }
                         
                         if(!exitMechanism) { // 4-second waiting period
                             // ended, turn on alarm, backpack is stolen!
-                            turnOnAlarm();
+                            playAlarmSound(&chirpSound, 3); // warning
+                            // chirps, then the siren
+                            playAnimation(ANIMATION_STROBE, packColor(255, 0, 0));
+                            int sirenOn = 0;
                             while(!exitMechanism) {
-                                if(isButtonPressed()) { // alarm will
+                                if(disarmRequested()) { // alarm will
                                     // continue to play until button is pressed
                                     exitMechanism = 1;
                                 }
+                                if(!sirenOn && !isAlarmSoundPlaying()) {
+                                    turnOnSiren(SIREN_WAIL, SIREN_WAIL_MS);
+                                    startAlarmSchedule(); // quieter and
+                                    // pulsed as the alarm goes on, to last
+                                    // for hours
+                                    sirenOn = 1;
+                                }
+                                updateAlarm();
+                                sleepUntilInterrupt(POWER_IDLE);
                             }
                         }
                     }
+                    else {
+                        // Idle until the accelerometer, the light sensor, the
+                        // button or the timebase raises an interrupt. Idle
+                        // rather than Sleep keeps Timer3 triggering the ADC
+                        sleepUntilInterrupt(POWER_IDLE);
+                    }
                 }
+                stopAccelerometerGovernor();
+                stopLightWatch();
             } // turn off device
             exitMechanism = 0;
             blinkRed(); // indicate mechanism is OFF
             turnOffAlarm();
         }
+        sleepUntilInterrupt(POWER_IDLE); // wait for the button to be pressed
     }
 }
 
 /**
- * Interrupts on TMR4 overflow, incrementing the global variable to keep
- * track of how many times TMR4 has overflowed
+ * @return 1 if the owner asked to turn off the device: with the knock code
+ * when one is set, otherwise with any press of the button
  */
-void __attribute__((__interrupt__, __auto_psv__)) _T4Interrupt() {
-    overflowTMR4++;
-    _T4IF = 0; // Reset TImer4 interrupt flag
+int disarmRequested() {
+    int gesture = getButtonGesture();
+    if(hasKnockCode()) {
+        return gesture == BUTTON_KNOCK_CODE;
+    }
+    return gesture != BUTTON_NONE;
 }
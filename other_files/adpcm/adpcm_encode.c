@@ -0,0 +1,241 @@
+/*
+ * File:   adpcm_encode.c
+ * Author: Sharmarke Ahmed
+ * PC tool that encodes 8 kHz audio into 4-bit IMA-ADPCM for the Alarm
+ * library, and writes it as a C source file to add to the project. The
+ * encoder reconstructs every sample the way the decoder will, and the result
+ * is checked bit for bit against the decoder of the firmware
+ * (Backpack-Anti-Theft-Device.X/Adpcm.c), built into this tool.
+ *
+ * Build:  gcc -O2 -I../../Backpack-Anti-Theft-Device.X -o adpcm_encode
+ *         adpcm_encode.c ../../Backpack-Anti-Theft-Device.X/Adpcm.c -lm
+ * Usage:  adpcm_encode name input.raw > AlarmSounds.c
+ *           input.raw is 16-bit little-endian mono PCM at 8 kHz, e.g. from
+ *           sox voice.wav -r 8000 -c 1 -b 16 -e signed -L voice.raw
+ *         adpcm_encode name -chirp > AlarmSounds.c
+ *           synthesizes the chirp used by the firmware
+ *         adpcm_encode -t
+ *           test: encodes test signals and compares both decoders
+ *
+ * Created on December 12, 2023, 3:30 PM
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stdint.h"
+#include "Adpcm.h"
+
+#define SAMPLE_RATE 8000
+#define MAX_SAMPLES 65535 // AdpcmSound counts samples in 16 bits
+
+// Step sizes of the IMA-ADPCM standard, kept separate from the firmware's
+// table so the test compares two implementations
+static const int steps[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+    45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209,
+    230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876,
+    963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493,
+    10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623,
+    27086, 29794, 32767};
+static const int indexChange[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+/**
+ * Encodes n samples into codes[] (one code per entry) and stores the sample
+ * the decoder will rebuild from each code in decoded[].
+ */
+static void encode(const int16_t *samples, int n, uint8_t *codes, int16_t *decoded) {
+    int predictor = 0;
+    int index = 0;
+    for(int i = 0; i < n; i++) {
+        int step = steps[index];
+        int difference = samples[i] - predictor;
+        int code = 0;
+        if(difference < 0) {
+            code = 8;
+            difference = -difference;
+        }
+        // quantize |difference| / step to 3 bits, rebuilding the decoder's
+        // difference as it goes
+        int rebuilt = step >> 3;
+        if(difference >= step) {
+            code |= 4;
+            difference -= step;
+            rebuilt += step;
+        }
+        if(difference >= step >> 1) {
+            code |= 2;
+            difference -= step >> 1;
+            rebuilt += step >> 1;
+        }
+        if(difference >= step >> 2) {
+            code |= 1;
+            rebuilt += step >> 2;
+        }
+        predictor += (code & 8) ? -rebuilt : rebuilt;
+        if(predictor > 32767) {
+            predictor = 32767;
+        }
+        if(predictor < -32768) {
+            predictor = -32768;
+        }
+        index += indexChange[code & 7];
+        if(index < 0) {
+            index = 0;
+        }
+        if(index > 88) {
+            index = 88;
+        }
+        codes[i] = code;
+        decoded[i] = predictor;
+    }
+}
+
+/**
+ * Packs the codes two per byte as the firmware reads them (first sample in
+ * the low nibble), then decodes the packed bytes with the firmware decoder.
+ * @return number of samples whose decoded value differs from expected[]
+ */
+static int checkDecoder(const uint8_t *codes, const int16_t *expected, int n,
+        uint8_t *packed) {
+    memset(packed, 0, (n + 1) / 2);
+    for(int i = 0; i < n; i++) {
+        packed[i >> 1] |= codes[i] << ((i & 1) * 4);
+    }
+    AdpcmSound sound = {packed, n, 0, 0};
+    AdpcmState state;
+    resetAdpcm(&state, &sound);
+    int errors = 0;
+    for(int i = 0; i < n; i++) {
+        uint8_t code = (packed[i >> 1] >> ((i & 1) * 4)) & 0x0F;
+        if(decodeAdpcm(&state, code) != expected[i]) {
+            if(errors < 5) {
+                fprintf(stderr, "sample %d: decoder %d, encoder %d\n", i,
+                        state.predictor, expected[i]);
+            }
+            errors++;
+        }
+    }
+    return errors;
+}
+
+/**
+ * The chirp played by the alarm: 0.5 s sweeping up from 1 kHz to 3 kHz, with
+ * 10 ms fades so it starts and stops without a click.
+ */
+static int makeChirp(int16_t *samples) {
+    int n = SAMPLE_RATE / 2;
+    int fade = SAMPLE_RATE / 100;
+    double phase = 0;
+    for(int i = 0; i < n; i++) {
+        double frequency = 1000.0 + 2000.0 * i / n;
+        phase += 2 * M_PI * frequency / SAMPLE_RATE;
+        double gain = 1.0;
+        if(i < fade) {
+            gain = (double) i / fade;
+        }
+        else if(n - i < fade) {
+            gain = (double) (n - i) / fade;
+        }
+        samples[i] = (int16_t) lround(29000.0 * gain * sin(phase));
+    }
+    return n;
+}
+
+/**
+ * Encodes test signals that reach every code and both clamps of the
+ * predictor and the step index, and checks the firmware decoder against the
+ * encoder sample by sample.
+ */
+static int runTest() {
+    static int16_t samples[MAX_SAMPLES];
+    static int16_t decoded[MAX_SAMPLES];
+    static uint8_t codes[MAX_SAMPLES];
+    static uint8_t packed[(MAX_SAMPLES + 1) / 2];
+    const char *names[] = {"chirp", "full-scale square wave", "noise", "silence"};
+    int failed = 0;
+    for(int signal = 0; signal < 4; signal++) {
+        int n = SAMPLE_RATE;
+        uint32_t random = 12345;
+        for(int i = 0; i < n; i++) {
+            switch(signal) {
+                case 1:
+                    samples[i] = (i / 40) & 1 ? 32767 : -32768;
+                    break;
+                case 2:
+                    random = random * 1103515245 + 12345;
+                    samples[i] = (int16_t) (random >> 16);
+                    break;
+                default:
+                    samples[i] = 0;
+            }
+        }
+        if(signal == 0) {
+            n = makeChirp(samples);
+        }
+        encode(samples, n, codes, decoded);
+        int errors = checkDecoder(codes, decoded, n, packed);
+        printf("%-24s %5d samples: %s\n", names[signal], n, errors ? "FAIL" : "ok");
+        failed |= errors != 0;
+    }
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    static int16_t samples[MAX_SAMPLES];
+    static int16_t decoded[MAX_SAMPLES];
+    static uint8_t codes[MAX_SAMPLES];
+    static uint8_t packed[(MAX_SAMPLES + 1) / 2];
+    if(argc == 2 && strcmp(argv[1], "-t") == 0) {
+        return runTest();
+    }
+    if(argc != 3) {
+        fprintf(stderr, "usage: %s name input.raw|-chirp > AlarmSounds.c\n"
+                "       %s -t\n", argv[0], argv[0]);
+        return 2;
+    }
+    
+    int n;
+    if(strcmp(argv[2], "-chirp") == 0) {
+        n = makeChirp(samples);
+    }
+    else {
+        FILE *input = fopen(argv[2], "rb");
+        if(!input) {
+            perror(argv[2]);
+            return 1;
+        }
+        uint8_t bytes[2];
+        for(n = 0; n < MAX_SAMPLES && fread(bytes, 1, 2, input) == 2; n++) {
+            samples[n] = (int16_t) (bytes[0] | bytes[1] << 8);
+        }
+        fclose(input);
+    }
+    
+    encode(samples, n, codes, decoded);
+    if(checkDecoder(codes, decoded, n, packed)) {
+        fprintf(stderr, "the firmware decoder does not match the encoder\n");
+        return 1;
+    }
+    double error = 0;
+    for(int i = 0; i < n; i++) {
+        error += (double) (samples[i] - decoded[i]) * (samples[i] - decoded[i]);
+    }
+    fprintf(stderr, "%d samples (%.2f s), %d bytes, rms error %.0f\n", n,
+            (double) n / SAMPLE_RATE, (n + 1) / 2, n ? sqrt(error / n) : 0.0);
+    
+    const char *name = argv[1];
+    printf("/*\n * File:   AlarmSounds.c\n * Sounds played by playAlarmSound(), "
+            "generated by other_files/adpcm/adpcm_encode.\n"
+            " * 4-bit IMA-ADPCM at 8 kHz, two samples per byte.\n */\n\n");
+    printf("#include \"stdint.h\"\n#include \"Adpcm.h\"\n#include \"AlarmSounds.h\"\n\n");
+    printf("const uint8_t __attribute__((space(auto_psv))) %sData[%d] = {", name, (n + 1) / 2);
+    for(int i = 0; i < (n + 1) / 2; i++) {
+        printf("%s0x%02X%s", i % 12 ? " " : "\n    ", packed[i],
+                i < (n + 1) / 2 - 1 ? "," : "");
+    }
+    printf("};\n\nconst AdpcmSound %sSound = {%sData, %d, 0, 0};\n", name, name, n);
+    return 0;
+}
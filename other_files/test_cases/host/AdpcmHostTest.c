@@ -0,0 +1,120 @@
+/*
+ * File:   AdpcmHostTest.c
+ * Author: Sharmarke Ahmed
+ * Host test of the Adpcm library against an IMA-ADPCM decoder from outside
+ * the repository. The expected samples were decoded by adpcm2lin() of the
+ * audioop module of CPython 3.11 (a C implementation of the Intel/DVI
+ * IMA-ADPCM reference decoder, with its own step and index tables), so an
+ * error shared by Adpcm.c and the encoder in other_files/adpcm does not pass.
+ * Fixed code sequences are decoded from a given state: every code, codes that
+ * drive the predictor into both clamps and the step table to its end,
+ * pseudo-random codes, and a tone encoded by audioop. Every sample and the
+ * final state must match bit for bit. audioop reads the high nibble of a byte
+ * first, so the codes are kept one per byte here.
+ *
+ * Build:  gcc -O2 -I. -o AdpcmHostTest AdpcmHostTest.c sfr.c cpu.c
+ *         ../../../Backpack-Anti-Theft-Device.X/Adpcm.c
+ * Usage:  AdpcmHostTest
+ *
+ * Created on December 16, 2023, 3:40 PM
+ */
+
+#include <stdio.h>
+#include "../../../Backpack-Anti-Theft-Device.X/Adpcm.h"
+
+// Every code from silence, from predictor 0 and index 0
+static const uint8_t everyCodeCodes[32] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6,
+    7, 8, 9, 10, 11, 12, 13, 14, 15};
+static const int16_t everyCodeSamples[32] = {
+    0, 1, 4, 8, 15, 27, 47, 88, 82, 66, 41, 10, -28, -84, -181, -380, -352,
+    -274, -156, -6, 170, 430, 882, 1807, 1675, 1315, 768, 72, -742, -1946,
+    -4029, -8289};
+
+// Clamped at both ends, from predictor 0 and index 0
+static const uint8_t clampedCodes[80] = {
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15};
+static const int16_t clampedSamples[80] = {
+    11, 41, 104, 240, 533, 1164, 2521, 5431, 11667, 25039, 32767, 32767, 32767,
+    32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767,
+    32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767,
+    32767, 32767, 32767, 32767, 32767, -28669, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768};
+
+// Pseudo-random codes, from predictor 1000 and index 40
+static const uint8_t randomCodesCodes[96] = {
+    5, 4, 11, 2, 8, 12, 14, 12, 8, 8, 10, 14, 7, 2, 3, 5, 5, 5, 7, 3, 14, 9, 12,
+    15, 9, 12, 12, 7, 6, 10, 15, 1, 6, 10, 2, 6, 3, 7, 13, 2, 4, 11, 10, 8, 15,
+    9, 13, 4, 5, 9, 4, 6, 3, 2, 1, 4, 4, 11, 5, 15, 4, 12, 14, 4, 15, 9, 11, 11,
+    11, 13, 14, 7, 15, 9, 9, 15, 4, 14, 0, 15, 5, 1, 7, 5, 1, 11, 2, 8, 3, 8,
+    14, 12, 12, 4, 3, 7};
+static const int16_t randomCodesSamples[96] = {
+    1463, 2018, 1496, 1836, 1775, 1270, 386, -697, -842, -974, -1575, -2998,
+    -88, 1990, 4636, 8415, 13950, 22053, 32767, 32767, 5438, -5734, -32768,
+    -32768, -32768, -32768, -32768, 28668, 32767, 12289, -32768, -20482, 27933,
+    7455, 26076, 32767, 32767, 32767, -12286, 8192, 32767, 4098, -14523, -17908,
+    -32768, -32768, -32768, 4094, 32767, 20481, 32767, 32767, 32767, 32767,
+    32767, 32767, 32767, 4098, 32767, -28669, 8193, -28669, -32768, 4094,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, 28668, -32768,
+    -32768, -32768, -32768, 4094, -32768, -28673, -32768, 12285, 24571, 32767,
+    32767, 32767, 6698, 23626, 20549, 32767, 30224, 162, -32768, -32768, 4094,
+    32763, 32767};
+
+// Encoded 400 Hz tone, from predictor -500 and index 60
+static const uint8_t toneCodes[64] = {
+    0, 7, 3, 2, 1, 0, 8, 10, 12, 12, 11, 12, 11, 11, 9, 8, 0, 2, 4, 5, 3, 4, 2,
+    2, 2, 0, 8, 10, 12, 12, 12, 11, 10, 11, 9, 9, 1, 2, 4, 5, 3, 3, 4, 2, 1, 1,
+    9, 10, 11, 14, 11, 12, 10, 10, 10, 8, 0, 2, 4, 4, 4, 3, 2, 3};
+static const int16_t toneSamples[64] = {
+    -216, 3657, 7531, 10047, 11419, 11834, 11456, 9739, 6928, 3526, 324, -3418,
+    -6940, -10142, -11388, -11766, -11423, -9862, -7306, -3527, -5, 4112, 6879,
+    9395, 11682, 12097, 11719, 10002, 7191, 3789, -328, -4202, -6718, -9920,
+    -11166, -12300, -11270, -9709, -7153, -3374, 148, 3350, 7092, 9608, 10980,
+    12226, 11092, 9375, 7190, 3498, -24, -4141, -6908, -9424, -11711, -12126,
+    -11748, -10031, -7220, -3818, 299, 4173, 6689, 9891};
+
+typedef struct {
+    const char *name;
+    const uint8_t *codes;
+    const int16_t *samples;
+    uint16_t count;
+    int16_t predictor; // state before the first code
+    uint8_t index;
+    int16_t finalPredictor; // state after the last code
+    uint8_t finalIndex;
+} Sequence;
+
+static const Sequence sequences[] = {
+    {"every code from silence", everyCodeCodes, everyCodeSamples, 32, 0, 0, -8289, 68},
+    {"clamped at both ends", clampedCodes, clampedSamples, 80, 0, 0, -32768, 88},
+    {"pseudo-random codes", randomCodesCodes, randomCodesSamples, 96, 1000, 40, 32767, 88},
+    {"encoded 400 Hz tone", toneCodes, toneSamples, 64, -500, 60, 9891, 64},
+};
+
+int main(void) {
+    int failed = 0;
+    for(unsigned int s = 0; s < sizeof(sequences) / sizeof(sequences[0]); s++) {
+        const Sequence *q = &sequences[s];
+        AdpcmSound sound = {0, q->count, q->predictor, q->index};
+        AdpcmState state;
+        resetAdpcm(&state, &sound);
+        int ok = 1;
+        for(int i = 0; i < q->count && ok; i++) {
+            int16_t sample = decodeAdpcm(&state, q->codes[i]);
+            if(sample != q->samples[i]) {
+                printf("    sample %d: %d, reference %d\n", i, sample, q->samples[i]);
+                ok = 0;
+            }
+        }
+        ok &= state.predictor == q->finalPredictor && state.index == q->finalIndex;
+        failed |= !ok;
+        printf("%-48s %s\n", q->name, ok ? "ok" : "FAIL");
+    }
+    return failed;
+}
@@ -0,0 +1,256 @@
+/*
+ * File:   AlarmHostTest.c
+ * Author: Sharmarke Ahmed
+ * Host test of the siren of the Alarm library. Timer2 is modelled at 1:1:
+ * each period match calls _T2Interrupt() after the 5 cycle interrupt latency
+ * of the PIC24, single stepped with TMR2 counting one per instruction, so the
+ * load reported by getAlarmLoad() is the one the firmware measures, with host
+ * instructions in place of PIC24 cycles. Each pattern is played for 10 s of
+ * Timer2 time, and the interrupt rate, the instructions per interrupt, the
+ * load, the frequencies swept and the length of a cycle of the pattern are
+ * checked. getAlarmLoad() is also checked at the load of a sound (8%) over
+ * the 268 s its counters cover.
+ * The escalation schedule is then played for an hour of siren, with the
+ * battery voltage scripted for each policy, and the energy the buzzer takes
+ * in each minute is worked out from the time the pin is high. The buzzer is
+ * modelled as a load drawing BUZZER_MA while the pin is high; the figures
+ * scale with the current of the buzzer actually fitted.
+ * The PIC24 cycle count needs the XC16 compiler and its simulator, which the
+ * host build does not have. The interrupt adds 32-bit counters, which take
+ * two instructions on the 16-bit PIC24 and one on the host, so the load is
+ * held under half the 1% target to leave room for the difference.
+ *
+ * Build:  gcc -O2 -I. -o AlarmHostTest AlarmHostTest.c sfr.c cpu.c
+ *         ../../../Backpack-Anti-Theft-Device.X/Alarm.c
+ *         ../../../Backpack-Anti-Theft-Device.X/Adpcm.c
+ * Usage:  AlarmHostTest
+ *
+ * Created on December 16, 2023, 10:15 AM
+ */
+
+#include <stdio.h>
+#include "xc.h"
+#include "cpu.h"
+#include "../../../Backpack-Anti-Theft-Device.X/Alarm.h"
+#include "../../../Backpack-Anti-Theft-Device.X/PowerManager.h"
+
+#define INTERRUPT_LATENCY 5 // cycles from the period match to the first
+// instruction of the interrupt
+#define PLAY_SECONDS 10
+#define LOAD_LIMIT 50 // hundredths of a percent, half the 1% target
+#define SWEEP_LOW_HZ 700
+#define SWEEP_HIGH_HZ 1600
+#define BUZZER_MA 15.0 // current of the buzzer while the pin is high
+#define ALARM_MINUTES 60
+#define PACK_MAH 2000 // two AA cells
+
+extern volatile int sirenIndex;
+extern volatile uint32_t sirenBusyCycles;
+extern volatile uint32_t sirenCycles;
+
+void __attribute__((__interrupt__, __auto_psv__)) _T2Interrupt();
+
+static unsigned long long cycles = 0; // Timer2 time, in cycles
+
+uint32_t getTicks() {
+    return cycles / 256; // 16 us PowerManager ticks
+}
+
+static unsigned int supplyMillivolts = 3000;
+
+unsigned int getSupplyMillivolts() {
+    return supplyMillivolts;
+}
+
+static void countTimer2() {
+    TMR2++;
+}
+
+/**
+ * Runs Timer2 from one period match to the next, and the interrupt at the
+ * match when it is enabled.
+ * @param stepped 1 to count the instructions of the interrupt
+ * @return host instructions of the interrupt, latency included
+ */
+static unsigned int nextPeriod(int stepped) {
+    unsigned int busy = 0;
+    TMR2 = 0;
+    IFS0bits.T2IF = 1;
+    if(IEC0bits.T2IE && !stepped) {
+        _T2Interrupt();
+    }
+    else if(IEC0bits.T2IE) {
+        TMR2 = INTERRUPT_LATENCY;
+        startStepping(countTimer2);
+        _T2Interrupt();
+        stopStepping();
+        busy = TMR2;
+    }
+    cycles += PR2 + 1; // the interrupt writes PR2 before the next match
+    return busy;
+}
+
+static int testSiren(const char *name, int pattern, unsigned int sweepMs) {
+    resetSFRs();
+    initAlarm(2000);
+    turnOnSiren(pattern, sweepMs);
+    unsigned long long start = cycles;
+    unsigned long long end = start + (unsigned long long) PLAY_SECONDS * FCY;
+    unsigned long long firstTurn = 0; // start of the first cycle of the pattern
+    unsigned long long lastTurn = 0;
+    unsigned long interrupts = 0;
+    unsigned long turns = 0;
+    unsigned int least = ~0U;
+    unsigned int most = 0;
+    unsigned int lowHz = ~0U;
+    unsigned int highHz = 0;
+    int previous = sirenIndex;
+    while(cycles < end) {
+        unsigned int busy = nextPeriod(1);
+        interrupts++;
+        if(busy < least) {
+            least = busy;
+        }
+        if(busy > most) {
+            most = busy;
+        }
+        unsigned int hz = (FCY + (PR2 + 1) / 2) / (PR2 + 1);
+        if(hz < lowHz) {
+            lowHz = hz;
+        }
+        if(hz > highHz) {
+            highHz = hz;
+        }
+        if(sirenIndex == 0 && previous != 0) { // back at the bottom
+            if(turns++ == 0) {
+                firstTurn = cycles;
+            }
+            lastTurn = cycles;
+        }
+        previous = sirenIndex;
+    }
+    unsigned int load = getAlarmLoad();
+    double seconds = (double) (cycles - start) / FCY;
+    double cycleMs = turns > 1 ? (double) (lastTurn - firstTurn) * 1000 / FCY / (turns - 1) : 0;
+    turnOffAlarm();
+
+    int swept = lowHz >= SWEEP_LOW_HZ - 5 && lowHz <= SWEEP_LOW_HZ + 5
+            && highHz >= SWEEP_HIGH_HZ - 5 && highHz <= SWEEP_HIGH_HZ + 5
+            && cycleMs > sweepMs * 0.95 && cycleMs < sweepMs * 1.05;
+    int light = load < LOAD_LIMIT;
+    char title[48];
+    snprintf(title, sizeof(title), "%s: sweep and interrupt load", name);
+    printf("%-48s %s\n", title, swept && light ? "ok" : "FAIL");
+    printf("    %u-%u Hz, cycle of %.0f ms (%u ms set)\n", lowHz, highHz, cycleMs, sweepMs);
+    printf("    %.0f interrupts/s, %u-%u host instructions each, load %u.%02u %%\n",
+            interrupts / seconds, least, most, load / 100, load % 100);
+    return !swept || !light;
+}
+
+/**
+ * Plays the siren for ALARM_MINUTES, as main() does once theft is confirmed,
+ * with or without the escalation schedule.
+ * @param minuteMillijoules energy taken by the buzzer in each minute
+ */
+static void playAlarm(int schedule, unsigned int millivolts, double *minuteMillijoules) {
+    resetSFRs();
+    initAlarm(10);
+    supplyMillivolts = millivolts;
+    turnOnSiren(SIREN_WAIL, SIREN_WAIL_MS);
+    setAlarmVolume(100);
+    if(schedule) {
+        startAlarmSchedule();
+    }
+    unsigned long long start = cycles;
+    for(int minute = 0; minute < ALARM_MINUTES; minute++) {
+        unsigned long long end = start + (minute + 1) * 60ULL * FCY;
+        unsigned long long high = 0; // cycles with the pin high
+        while(cycles < end) {
+            // OC1RS and the gate are latched at the start of the period
+            unsigned int period = PR2 + 1;
+            unsigned int duty = OC1RS < period ? OC1RS : period;
+            int gated = OC1CONbits.OCM == 0b110;
+            nextPeriod(0);
+            if(gated) {
+                high += duty;
+            }
+            updateAlarm(); // the main loop wakes up at least this often
+        }
+        minuteMillijoules[minute] = millivolts * BUZZER_MA * high / FCY / 1000;
+    }
+    turnOffAlarm();
+}
+
+static int testSchedule() {
+    static const char *names[4] = {"full volume, no schedule", "schedule, 3.0 V",
+        "schedule, 2.4 V (low)", "schedule, 2.2 V (critical)"};
+    static const int schedules[4] = {0, 1, 1, 1};
+    static const unsigned int millivolts[4] = {3000, 3000, 2400, 2200};
+    double energy[4][ALARM_MINUTES];
+    double total[4] = {0};
+    for(int p = 0; p < 4; p++) {
+        playAlarm(schedules[p], millivolts[p], energy[p]);
+        for(int m = 0; m < ALARM_MINUTES; m++) {
+            total[p] += energy[p][m];
+        }
+    }
+    printf("    buzzer energy per alarm minute at %.0f mA while the pin is high:\n",
+            BUZZER_MA);
+    printf("    %-28s %7s %7s %7s %7s %8s\n", "policy", "min 1", "min 2", "min 5",
+            "min 30", "1 h avg");
+    for(int p = 0; p < 4; p++) {
+        printf("    %-28s %7.0f %7.0f %7.0f %7.0f %8.0f mJ\n", names[p], energy[p][0],
+                energy[p][1], energy[p][4], energy[p][29], total[p] / ALARM_MINUTES);
+    }
+    // The last minute is the stage the alarm keeps to until it is disarmed
+    printf("    buzzer current, and hours of alarm on a %d mAh pack at the last stage:\n",
+            PACK_MAH);
+    for(int p = 0; p < 4; p++) {
+        double volts = millivolts[p] / 1000.0;
+        double mA = total[p] / ALARM_MINUTES / 60 / volts;
+        double lastMA = energy[p][ALARM_MINUTES - 1] / 60 / volts;
+        printf("    %-28s %5.2f mA over 1 h, %5.2f mA after, %5.0f h\n", names[p], mA,
+                lastMA, PACK_MAH / lastMA);
+    }
+
+    // Shares of the pin high time of the full volume alarm, at the same
+    // voltage: 50% duty at full volume, stage 2 is 60% volume half the time,
+    // stage 3 is 30% volume one second in five
+    double full = energy[0][0];
+    int ok = energy[1][0] > 0.99 * full && energy[1][0] < 1.01 * full;
+    ok &= energy[1][4] > 0.29 * full && energy[1][4] < 0.31 * full;
+    ok &= energy[1][29] > 0.055 * full && energy[1][29] < 0.065 * full;
+    // After the first battery check (60 s), a low battery skips to stage 2
+    // and a critical one to stage 3
+    double low = full * 2400 / 3000;
+    double critical = full * 2200 / 3000;
+    ok &= energy[2][1] > 0.29 * low && energy[2][1] < 0.31 * low;
+    ok &= energy[3][1] > 0.055 * critical && energy[3][1] < 0.065 * critical;
+    printf("%-48s %s\n", "escalation and battery policies", ok ? "ok" : "FAIL");
+    return !ok;
+}
+
+/**
+ * A sound keeps the interrupt about 8% busy: the load must not overflow
+ * however long it has been since the last call, within the 268 s the
+ * counters cover.
+ */
+static int testSoundLoad() {
+    int ok = 1;
+    for(uint32_t seconds = 1; seconds <= 268; seconds++) {
+        sirenCycles = seconds * FCY;
+        sirenBusyCycles = sirenCycles / 100 * 8;
+        ok &= getAlarmLoad() == 800;
+    }
+    printf("%-48s %s\n", "sound load over 268 s without overflow", ok ? "ok" : "FAIL");
+    return !ok;
+}
+
+int main(void) {
+    int failed = testSiren("wail", SIREN_WAIL, SIREN_WAIL_MS);
+    failed |= testSiren("yelp", SIREN_YELP, SIREN_YELP_MS);
+    failed |= testSiren("hi-lo", SIREN_HILO, SIREN_HILO_MS);
+    failed |= testSoundLoad();
+    failed |= testSchedule();
+    return failed;
+}
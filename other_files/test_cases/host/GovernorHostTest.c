@@ -0,0 +1,161 @@
+/*
+ * File:   GovernorHostTest.c
+ * Author: Sharmarke Ahmed
+ * Host simulation of the accelerometer governor. The I2C1, Timer5 and LIS3DH
+ * model of LIS3DHModel.c produces samples at the rate the governor sets, and
+ * the main loop of the armed device is played over a scripted hour: the bag
+ * rests on the floor, is brushed against every 5 minutes, then is picked up
+ * and carried away for the last minute. Reports the time spent in each
+ * tier, the average sample rate and the bus traffic, against the 400 Hz the
+ * LIS3DH ran at before the governor.
+ *
+ * Build:  gcc -O2 -I. -o GovernorHostTest GovernorHostTest.c LIS3DHModel.c
+ *         sfr.c cpu.c ../../../Backpack-Anti-Theft-Device.X/Accelerometer.c
+ *         ../../../Backpack-Anti-Theft-Device.X/MotionDetector.c
+ *         ../../../Backpack-Anti-Theft-Device.X/I2C.c -lm
+ * Usage:  GovernorHostTest
+ *
+ * Created on December 15, 2023, 11:40 AM
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "xc.h"
+#include "cpu.h"
+#include "LIS3DHModel.h"
+#include "../../../Backpack-Anti-Theft-Device.X/Clock.h"
+#include "../../../Backpack-Anti-Theft-Device.X/I2C.h"
+#include "../../../Backpack-Anti-Theft-Device.X/Accelerometer.h"
+
+#define SCENARIO_SECONDS 3600
+#define BRUSH_PERIOD 300 // seconds between two brushes against the bag
+#define LIFT_TIME 3540 // the bag is picked up 59 minutes in
+#define NOISE_MG 4.0
+#define FIXED_RATE 400 // Hz, CTRL_REG1 = 0x77 before the governor
+#define BURST_BYTES 9 // bus bytes of a six byte burst read
+
+extern volatile int governorTier;
+extern volatile int requestedTier;
+
+static const char *tierNames[3] = {"idle", "suspicious", "alarm"};
+static uint32_t seed = 12345;
+static double detectedAt = -1;
+static unsigned long long tierCycles[3];
+static int stepUps = 0;
+
+static double gaussian() {
+    double sum = 0;
+    for(int i = 0; i < 12; i++) {
+        seed = seed * 1664525 + 1013904223;
+        sum += (seed >> 8) / 16777216.0;
+    }
+    return sum - 6;
+}
+
+/**
+ * The scripted hour, in milli-g: gravity on z, a 150 mg brush of 200 ms
+ * along x every BRUSH_PERIOD seconds until the lift, then a lift and a walk.
+ */
+static void scenario(double t, double *mg) {
+    mg[0] = 0;
+    mg[1] = 0;
+    mg[2] = 1000;
+    if(t < LIFT_TIME) {
+        double since = fmod(t, BRUSH_PERIOD);
+        if(t >= BRUSH_PERIOD && since < 0.2) {
+            mg[0] += 150 * sin(M_PI * since / 0.2);
+        }
+    }
+    else {
+        double s = t - LIFT_TIME;
+        mg[2] += s < 0.25 ? 400 : s < 0.5 ? -400 : 250 * sin(2 * M_PI * 2 * s);
+        mg[0] += s < 0.5 ? 0 : 250 * sin(2 * M_PI * s);
+    }
+    for(int i = 0; i < 3; i++) {
+        mg[i] += NOISE_MG * gaussian();
+    }
+}
+
+/**
+ * What the armed main loop does each time the microcontroller wakes up: the
+ * blocking calls are single stepped so the bus keeps running under them.
+ */
+static void poll() {
+    int moving;
+    if(requestedTier != governorTier) { // the tier change waits on the bus
+        startStepping(stepBusModel);
+        moving = movementDetected();
+        stopStepping();
+    }
+    else {
+        moving = movementDetected();
+    }
+    if(moving && detectedAt < 0) {
+        detectedAt = (double) cycles / FCY;
+        startStepping(stepBusModel);
+        setAccelerometerTier(ACCEL_TIER_ALARM);
+        stopStepping();
+    }
+}
+
+int main(void) {
+    int failed = 0;
+    resetSFRs();
+    initBusModel();
+    lis3dhSource = scenario;
+    startStepping(stepBusModel);
+    initAccelerometer();
+    initAccelerometerGovernor();
+    resetMovementDetection();
+    stopStepping();
+
+    unsigned long long start = cycles;
+    unsigned long samplesBefore = lis3dhSamples;
+    unsigned long bytesBefore = busCounters.bytes;
+    unsigned long long end = start + (unsigned long long) SCENARIO_SECONDS * FCY;
+    while(cycles < end) {
+        unsigned long long before = cycles;
+        int tier = governorTier;
+        if(isI2CIdle()) {
+            skipBusModel(end); // Idle until the next interrupt
+        }
+        else {
+            stepBusModel();
+        }
+        if(isI2CIdle()) {
+            poll();
+        }
+        tierCycles[tier] += cycles - before;
+        if(tier == ACCEL_TIER_IDLE && governorTier == ACCEL_TIER_SUSPICIOUS) {
+            stepUps++;
+        }
+    }
+
+    double seconds = (double) (cycles - start) / FCY;
+    unsigned long samples = lis3dhSamples - samplesBefore;
+    unsigned long bytes = busCounters.bytes - bytesBefore;
+    double rate = samples / seconds;
+    int brushes = (LIFT_TIME - 1) / BRUSH_PERIOD;
+    double quietSeconds = LIFT_TIME - brushes * 3.0; // at most 3 s per brush
+
+    printf("    scripted hour: %d brushes, lifted at %d s\n", brushes, LIFT_TIME);
+    for(int i = 0; i < 3; i++) {
+        printf("    %-10s tier %7.1f s\n", tierNames[i], (double) tierCycles[i] / FCY);
+    }
+    printf("    average sample rate %.1f Hz, %.0f bus bytes/s\n", rate, bytes / seconds);
+    printf("    without the governor: %d Hz, %d bus bytes/s\n", FIXED_RATE,
+            FIXED_RATE * BURST_BYTES);
+    failed |= stepUps != brushes + 1; // each brush, then the lift
+    printf("%-48s %s\n", "steps up on each brush and on the lift", stepUps
+            == brushes + 1 ? "ok" : "FAIL");
+    int quiet = (double) tierCycles[ACCEL_TIER_IDLE] / FCY >= quietSeconds;
+    failed |= !quiet;
+    printf("%-48s %s\n", "idle tier while the bag rests", quiet ? "ok" : "FAIL");
+    int detected = detectedAt >= LIFT_TIME && detectedAt < LIFT_TIME + 1;
+    failed |= !detected;
+    printf("%-48s %s\n", "lift detected within 1 s", detected ? "ok" : "FAIL");
+    if(detected) {
+        printf("    detected %.0f ms after the lift\n", (detectedAt - LIFT_TIME) * 1000);
+    }
+    return failed;
+}
@@ -0,0 +1,308 @@
+/*
+ * File:   I2CHostTest.c
+ * Author: Sharmarke Ahmed
+ * Host test of the I2C and Accelerometer libraries against the I2C1, Timer5
+ * and LIS3DH model of LIS3DHModel.c. The blocking calls are single stepped
+ * with the model advancing one instruction cycle per step, so the interrupt
+ * state machine runs the bus while the caller waits, as on the chip. Checks
+ * the bytes on the bus and the bus time of a burst read of the three axes
+ * against the single register reads it replaced, and replays the interrupt
+ * sequence of queued transactions: the exact start, byte, acknowledge and stop
+ * phases of reads and writes, a transaction queued from a callback, a full
+ * queue and the configuration of the LIS3DH. Faults are then injected on the
+ * bus: a missing acknowledge, an absent device and a slave holding the bus at
+ * each phase of a burst read, and the recovery, retries and worst case
+ * transaction time are checked. Last, a transaction is submitted from the
+ * main context while the watchdog retires the one on the bus, with the
+ * timeout landing on each instruction of the submit in turn.
+ *
+ * Build:  gcc -O2 -I. -o I2CHostTest I2CHostTest.c LIS3DHModel.c sfr.c cpu.c
+ *         ../../../Backpack-Anti-Theft-Device.X/Accelerometer.c
+ *         ../../../Backpack-Anti-Theft-Device.X/MotionDetector.c
+ *         ../../../Backpack-Anti-Theft-Device.X/I2C.c
+ * Usage:  I2CHostTest
+ *
+ * Created on December 14, 2023, 2:10 PM
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "xc.h"
+#include "cpu.h"
+#include "LIS3DHModel.h"
+#include "../../../Backpack-Anti-Theft-Device.X/I2C.h"
+#include "../../../Backpack-Anti-Theft-Device.X/Accelerometer.h"
+
+#define WHO_AM_I 0x0F
+#define CTRL_REG1 0x20
+#define OUT_X_L 0x28
+#define INT1_CFG 0x30
+#define INT1_THS 0x32
+#define CYCLES_PER_US 16
+#define CYCLE_LIMIT 1000000 // a transaction taking longer is stuck
+#define BURST_PHASES 18 // S, address, register, Sr, address, 6 x (byte, ack), P
+#define RECOVERY_CYCLES (22 * 80) // 22 busDelay() calls of 80 cycles
+#define SUBMIT_WINDOW 200 // cycles before the last timeout swept by the submit
+
+extern volatile uint8_t queueCount;
+
+static I2CTransaction chained;
+static int chainedStatus = -1; // status of chained when the callback queued it
+
+static void startScenario() {
+    resetSFRs();
+    initBusModel();
+    initI2C();
+}
+
+static int check(const char *name, int ok) {
+    printf("%-48s %s\n", name, ok ? "ok" : "FAIL");
+    if(!ok) {
+        printf("    bus: %s\n", busLog);
+    }
+    return !ok;
+}
+
+/**
+ * Runs the model until the queue is empty, without a caller waiting.
+ * @return 1 if the queue emptied within CYCLE_LIMIT cycles
+ */
+static int runUntilIdle() {
+    unsigned long long end = cycles + CYCLE_LIMIT;
+    while(!isI2CIdle() && cycles < end) {
+        stepBusModel();
+    }
+    return isI2CIdle();
+}
+
+static void queueChained(I2CTransaction *transaction) {
+    submitI2CTransaction(&chained);
+    chainedStatus = chained.status;
+}
+
+static int testBurstRead() {
+    const uint8_t sample[6] = {0x10, 0x01, 0x20, 0xFE, 0x30, 0x40};
+    int failed = 0;
+    int16_t x, y, z;
+
+    startScenario();
+    memcpy(&lis3dhRegisters[OUT_X_L], sample, sizeof(sample));
+    startStepping(stepBusModel);
+    getAcceleration3(&x, &y, &z);
+    stopStepping();
+    BusCounters burst = busCounters;
+    uint16_t burstTicks = getI2CLastTime();
+    failed |= check("burst read values", x == 0x0110 && y == (int16_t) 0xFE20
+            && z == 0x4030);
+    failed |= check("burst read on the bus", strcmp(busLog,
+            "S 30a A8a Sr 31a 10a 01a 20a FEa 30a 40n P ") == 0);
+
+    clearBusLog();
+    startStepping(stepBusModel);
+    x = getXAcceleration();
+    y = getYAcceleration();
+    z = getZAcceleration();
+    stopStepping();
+    BusCounters single = busCounters;
+    single.bytes -= burst.bytes;
+    single.busyCycles -= burst.busyCycles;
+    failed |= check("single register reads values", x == 0x0110
+            && y == (int16_t) 0xFE20 && z == 0x4030);
+    failed |= check("burst read moves fewer bytes", burst.bytes == 9
+            && single.bytes == 24);
+    printf("    burst read: %lu bytes, %lu us on the bus (%u Timer5 ticks)\n",
+            burst.bytes, burst.busyCycles / CYCLES_PER_US, burstTicks);
+    printf("    six single register reads: %lu bytes, %lu us on the bus\n",
+            single.bytes, single.busyCycles / CYCLES_PER_US);
+    return failed;
+}
+
+static int testTransactions() {
+    int failed = 0;
+    uint8_t value = 0x77;
+    uint8_t id = 0;
+
+    startScenario();
+    I2CTransaction write = {0x30, CTRL_REG1, 0, 1, &value, I2C_STATUS_IDLE, 0};
+    submitI2CTransaction(&write);
+    int returned = busLog[0] == 0 && write.status == I2C_STATUS_QUEUED;
+    runUntilIdle();
+    failed |= check("submit returns before the bus moves", returned);
+    failed |= check("write transaction", strcmp(busLog, "S 30a 20a 77a P ") == 0
+            && write.status == I2C_STATUS_DONE && lis3dhRegisters[CTRL_REG1] == 0x77);
+
+    clearBusLog();
+    I2CTransaction read = {0x30, WHO_AM_I, 1, 1, &id, I2C_STATUS_IDLE, 0};
+    submitI2CTransaction(&read);
+    runUntilIdle();
+    failed |= check("read transaction", strcmp(busLog, "S 30a 0Fa Sr 31a 33n P ") == 0
+            && read.status == I2C_STATUS_DONE && id == 0x33);
+
+    // The callback of the first read queues the second one, which starts as
+    // soon as the first one is retired
+    clearBusLog();
+    uint8_t first = 0;
+    uint8_t second = 0;
+    lis3dhRegisters[OUT_X_L] = 0x5A;
+    read = (I2CTransaction) {0x30, WHO_AM_I, 1, 1, &first, I2C_STATUS_IDLE, queueChained};
+    chained = (I2CTransaction) {0x30, OUT_X_L, 1, 1, &second, I2C_STATUS_IDLE, 0};
+    submitI2CTransaction(&read);
+    runUntilIdle();
+    failed |= check("transaction queued from a callback", strcmp(busLog,
+            "S 30a 0Fa Sr 31a 33n P S 30a 28a Sr 31a 5An P ") == 0
+            && chainedStatus == I2C_STATUS_QUEUED && chained.status == I2C_STATUS_DONE
+            && first == 0x33 && second == 0x5A);
+
+    // Nothing moves on the bus while the queue is filled
+    startScenario();
+    uint8_t data[I2C_QUEUE_SIZE];
+    I2CTransaction writes[I2C_QUEUE_SIZE + 1];
+    int queued = 0;
+    for(int i = 0; i <= I2C_QUEUE_SIZE; i++) {
+        data[i % I2C_QUEUE_SIZE] = i;
+        writes[i] = (I2CTransaction) {0x30, 0x26, 0, 1, &data[i % I2C_QUEUE_SIZE],
+            I2C_STATUS_IDLE, 0};
+        queued += submitI2CTransaction(&writes[i]);
+    }
+    int done = runUntilIdle();
+    for(int i = 0; i < I2C_QUEUE_SIZE; i++) {
+        done &= writes[i].status == I2C_STATUS_DONE;
+    }
+    failed |= check("full queue", queued == I2C_QUEUE_SIZE && done
+            && writes[I2C_QUEUE_SIZE].status == I2C_STATUS_IDLE
+            && busCounters.stops == I2C_QUEUE_SIZE);
+
+    startScenario();
+    startStepping(stepBusModel);
+    initAccelerometer();
+    stopStepping();
+    failed |= check("LIS3DH configuration", lis3dhRegisters[CTRL_REG1] == 0x77
+            && lis3dhRegisters[CTRL_REG1 + 1] == 0x01
+            && lis3dhRegisters[CTRL_REG1 + 2] == 0x40
+            && lis3dhRegisters[CTRL_REG1 + 3] == 0x84
+            && lis3dhRegisters[INT1_CFG] == 0x2A && lis3dhRegisters[INT1_THS] == 0x20
+            && busCounters.stops == 5); // two reboot writes, three flushed
+    return failed;
+}
+
+static int testFaults() {
+    int failed = 0;
+    uint8_t id = 0;
+
+    startScenario();
+    nackAddresses = 1;
+    I2CTransaction read = {0x30, WHO_AM_I, 1, 1, &id, I2C_STATUS_IDLE, 0};
+    submitI2CTransaction(&read);
+    runUntilIdle();
+    failed |= check("missing acknowledge retried", strcmp(busLog,
+            "S 30n P S 30a 0Fa Sr 31a 33n P ") == 0 && read.status == I2C_STATUS_DONE
+            && id == 0x33 && getI2CErrorCount() == 1 && getI2CRetryCount() == 1);
+
+    startScenario();
+    read = (I2CTransaction) {0x32, WHO_AM_I, 1, 1, &id, I2C_STATUS_IDLE, 0};
+    submitI2CTransaction(&read);
+    runUntilIdle();
+    failed |= check("absent device", read.status == I2C_STATUS_ERROR
+            && busCounters.starts == I2C_MAX_RETRIES + 1
+            && getI2CErrorCount() == I2C_MAX_RETRIES + 1
+            && getI2CTimeoutCount() == 0);
+
+    // The LIS3DH holds the bus during one phase: the blocking call returns
+    // with the data after one recovery
+    startScenario();
+    const uint8_t sample[6] = {1, 2, 3, 4, 5, 6};
+    memcpy(&lis3dhRegisters[OUT_X_L], sample, sizeof(sample));
+    uint8_t raw[6] = {0};
+    stallPhases = 1;
+    stallDelay = 7;
+    startStepping(stepBusModel);
+    accel_read_burst(OUT_X_L, raw, 6);
+    stopStepping();
+    failed |= check("stuck bus recovered", memcmp(raw, sample, 6) == 0
+            && getI2CTimeoutCount() == 1 && getI2CRetryCount() == 1
+            && sclPulses == 9 && recoveryStops == 1);
+
+    // The LIS3DH never lets go, starting at each phase of a burst read in
+    // turn: every transaction is retired within its bound
+    const unsigned long long bound = (I2C_MAX_RETRIES + 1)
+            * (BURST_PHASES * (I2C_PHASE_TIMEOUT + 1) * 8ULL + RECOVERY_CYCLES);
+    unsigned long long worst = 0;
+    int retired = 1;
+    for(int k = 0; k < BURST_PHASES; k++) {
+        startScenario();
+        stallPhases = 1000;
+        stallDelay = k;
+        I2CTransaction burst = {0x30, OUT_X_L | 0x80, 1, 6, raw, I2C_STATUS_IDLE, 0};
+        submitI2CTransaction(&burst);
+        runUntilIdle();
+        retired &= burst.status == I2C_STATUS_ERROR
+                && getI2CTimeoutCount() == I2C_MAX_RETRIES + 1;
+        if(cycles > worst) {
+            worst = cycles;
+        }
+    }
+    failed |= check("bus never released", retired && worst <= bound);
+    printf("    worst case burst read: %llu us, bound %llu us\n",
+            worst / CYCLES_PER_US, bound / CYCLES_PER_US);
+    return failed;
+}
+
+/**
+ * Starts a burst read that times out on every attempt, so the Timer5
+ * interrupt retires it, then runs the model until cycle until.
+ * @return the cycle at which the Timer5 interrupt retired the read
+ */
+static unsigned long long startFailingRead(I2CTransaction *read, uint8_t *raw,
+        unsigned long long until) {
+    unsigned long long retired = 0;
+    startScenario();
+    stallPhases = I2C_MAX_RETRIES + 1; // one stall per attempt, then a free bus
+    stallDelay = 0;
+    *read = (I2CTransaction) {0x30, OUT_X_L | 0x80, 1, 6, raw, I2C_STATUS_IDLE, 0};
+    submitI2CTransaction(read);
+    while(cycles < until && read->status == I2C_STATUS_QUEUED) {
+        retired = cycles + 1; // the step of the interrupt, before its recovery
+        stepBusModel();
+    }
+    return retired;
+}
+
+static int testSubmitDuringTimeout() {
+    uint8_t raw[6];
+    uint8_t id = 0;
+    I2CTransaction read;
+
+    // Cycle at which the last timeout retires the read, without a submit
+    unsigned long long retired = startFailingRead(&read, raw, ~0ULL);
+    int ok = read.status == I2C_STATUS_ERROR;
+
+    // Timer5 interrupts the submit at each instruction in turn: the queue
+    // must still hold the new transaction, once
+    int caught = 0;
+    for(int k = 1; k <= SUBMIT_WINDOW && ok; k++) {
+        startFailingRead(&read, raw, retired - k);
+        I2CTransaction next = {0x30, WHO_AM_I, 1, 1, &id, I2C_STATUS_IDLE, 0};
+        id = 0;
+        startStepping(stepBusModel);
+        int queued = submitI2CTransaction(&next);
+        stopStepping();
+        int done = read.status == I2C_STATUS_ERROR;
+        caught |= done;
+        ok &= queueCount == (done ? 1 : 2); // the new one, behind the read if queued
+        ok &= queued && runUntilIdle() && read.status == I2C_STATUS_ERROR
+                && next.status == I2C_STATUS_DONE && id == 0x33
+                && getI2CTimeoutCount() == I2C_MAX_RETRIES + 1;
+        if(!ok) {
+            printf("    timeout %d cycles after the submit started\n", k);
+        }
+    }
+    return check("timeout during a submit", ok && caught);
+}
+
+int main(void) {
+    int failed = testBurstRead();
+    failed |= testTransactions();
+    failed |= testFaults();
+    failed |= testSubmitDuringTimeout();
+    return failed;
+}
@@ -0,0 +1,379 @@
+/*
+ * File:   LIS3DHModel.c
+ * Author: Sharmarke Ahmed
+ * I2C1 module, Timer5 and LIS3DH model, see LIS3DHModel.h.
+ *
+ * Created on December 14, 2023, 2:10 PM
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "xc.h"
+#include "LIS3DHModel.h"
+#include "../../../Backpack-Anti-Theft-Device.X/Clock.h"
+
+#define BIT_CYCLES 40 // one SCL period at 400 kHz
+#define TRN_EMPTY 0xFFFF // I2C1TRN value meaning no byte was written
+#define LIS3DH_ADDRESS 0x30
+#define CTRL_REG1 0x20
+#define CTRL_REG3 0x22
+#define CTRL_REG4 0x23
+#define OUT_X_L 0x28
+#define OUT_Z_H 0x2D
+#define LPEN 0x08 // CTRL_REG1 low-power mode
+#define I1_ZYXDA 0x10 // CTRL_REG3 data ready on INT1
+#define HR 0x08 // CTRL_REG4 high-resolution mode
+
+#define PHASE_NONE 0
+#define PHASE_START 1
+#define PHASE_RESTART 2
+#define PHASE_STOP 3
+#define PHASE_TRANSMIT 4
+#define PHASE_RECEIVE 5
+#define PHASE_ACKNOWLEDGE 6
+
+void __attribute__((__interrupt__, __auto_psv__)) _MI2C1Interrupt();
+void __attribute__((__interrupt__, __auto_psv__)) _T5Interrupt();
+void __attribute__((__interrupt__, __auto_psv__)) _INT1Interrupt();
+
+BusCounters busCounters;
+unsigned long long cycles = 0;
+uint8_t lis3dhRegisters[0x40];
+char busLog[BUS_LOG_SIZE];
+int nackAddresses = 0;
+int stallPhases = 0;
+int stallDelay = 0;
+int sclPulses = 0;
+int recoveryStops = 0;
+unsigned long lis3dhSamples = 0;
+void (*lis3dhSource)(double seconds, double *mg) = 0;
+
+// Output data rates of CTRL_REG1 ODR values 0 to 9, in Hz (1620 Hz is the
+// low-power mode rate of 9)
+static const unsigned int dataRates[10] = {0, 1, 10, 25, 50, 100, 200, 400,
+    1620, 1344};
+
+static int phase = PHASE_NONE;
+static int phaseCycles = 0; // left in the current phase
+static int stalled = 0; // the current phase hangs until a bus recovery
+static int timer5Prescale = 0;
+
+// Slave side
+static int expectAddress = 0; // next byte is the slave address
+static int addressed = 0; // the LIS3DH acknowledged its address
+static int reading = 0;
+static int subAddressSent = 0;
+static uint8_t pointer = 0; // register address
+static int autoIncrement = 0;
+static unsigned long long nextSample = 0; // cycle of the next LIS3DH sample
+
+// Pins during a bus recovery
+static int lastScl = 1;
+static int lastSda = 1;
+static int pulses = 0; // SCL pulses since the last stop condition
+
+static void logBus(const char *format, unsigned int value) {
+    size_t used = strlen(busLog);
+    if(used < BUS_LOG_SIZE - 16) {
+        snprintf(busLog + used, BUS_LOG_SIZE - used, format, value);
+    }
+}
+
+static void advancePointer() {
+    if(autoIncrement) {
+        pointer = (pointer + 1) & 0x3F;
+    }
+}
+
+/**
+ * Clears the requests of the driver and the byte to send, as the I2C1 module
+ * does when it is disabled. A stalled slave keeps holding the bus.
+ */
+static void resetModule() {
+    I2C1CONbits.SEN = 0;
+    I2C1CONbits.RSEN = 0;
+    I2C1CONbits.PEN = 0;
+    I2C1CONbits.RCEN = 0;
+    I2C1CONbits.ACKEN = 0;
+    I2C1TRN = TRN_EMPTY;
+    if(!stalled) {
+        phase = PHASE_NONE;
+    }
+}
+
+/**
+ * Follows SCL (RB8) and SDA (RB9) while the driver clocks the bus by hand:
+ * the driver calls busDelay() after every change of the pins.
+ */
+static void busDelayHook(const char *instruction) {
+    if(strncmp(instruction, "repeat #", 8) == 0) { // parsed by hand, as it
+        unsigned int count = 0;                    // runs single stepped
+        for(const char *c = instruction + 8; *c >= '0' && *c <= '9'; c++) {
+            count = count * 10 + *c - '0';
+        }
+        cycles += count + 1;
+    }
+    if(I2C1CONbits.I2CEN) {
+        lastScl = 1;
+        lastSda = 1;
+        pulses = 0;
+        return;
+    }
+    resetModule(); // clearing I2CEN resets the module
+    int scl = TRISBbits.TRISB8; // open drain: TRIS = 1 releases the line
+    int sda = TRISBbits.TRISB9;
+    if(scl && !lastScl && sda) { // clocks a bit out of the slave
+        sclPulses++;
+        pulses++;
+    }
+    if(scl && lastScl && sda && !lastSda) { // SDA rises while SCL is high
+        recoveryStops++;
+        if(stalled && pulses >= 9) { // the slave finished its byte
+            stalled = 0;
+            phase = PHASE_NONE;
+        }
+        pulses = 0;
+        expectAddress = 0;
+        addressed = 0;
+    }
+    lastScl = scl;
+    lastSda = sda;
+}
+
+void initBusModel(void) {
+    memset(&busCounters, 0, sizeof(busCounters));
+    memset(lis3dhRegisters, 0, sizeof(lis3dhRegisters));
+    lis3dhRegisters[0x0F] = 0x33; // WHO_AM_I
+    lis3dhRegisters[0x20] = 0x07; // CTRL_REG1
+    clearBusLog();
+    cycles = 0;
+    nackAddresses = 0;
+    stallPhases = 0;
+    stallDelay = 0;
+    sclPulses = 0;
+    recoveryStops = 0;
+    phase = PHASE_NONE;
+    stalled = 0;
+    timer5Prescale = 0;
+    lis3dhSamples = 0;
+    lis3dhSource = 0;
+    nextSample = 0;
+    pulses = 0;
+    expectAddress = 0;
+    addressed = 0;
+    I2C1TRN = TRN_EMPTY;
+    asmHook = busDelayHook;
+}
+
+void clearBusLog(void) {
+    busLog[0] = 0;
+}
+
+/**
+ * Starts a phase, or leaves it hanging when a stall was injected.
+ */
+static void startPhase(int newPhase, int length) {
+    phase = newPhase;
+    phaseCycles = length;
+    if(stallPhases > 0 && stallDelay > 0) {
+        stallDelay--;
+    }
+    else if(stallPhases > 0) {
+        stallPhases--;
+        stalled = 1;
+    }
+}
+
+/**
+ * Carries out the end of the current phase on the slave side.
+ */
+static void finishPhase() {
+    switch(phase) {
+        case PHASE_START:
+        case PHASE_RESTART:
+            I2C1CONbits.SEN = 0;
+            I2C1CONbits.RSEN = 0;
+            logBus(phase == PHASE_START ? "S " : "Sr ", 0);
+            busCounters.starts++;
+            expectAddress = 1;
+            addressed = 0;
+            break;
+        case PHASE_STOP:
+            I2C1CONbits.PEN = 0;
+            logBus("P ", 0);
+            busCounters.stops++;
+            expectAddress = 0;
+            addressed = 0;
+            break;
+        case PHASE_TRANSMIT: {
+            uint8_t byte = I2C1TRN & 0xFF;
+            int ack = 0;
+            I2C1TRN = TRN_EMPTY;
+            busCounters.bytes++;
+            if(expectAddress) {
+                expectAddress = 0;
+                if((byte & 0xFE) == LIS3DH_ADDRESS && nackAddresses == 0) {
+                    ack = 1;
+                    addressed = 1;
+                    reading = byte & 1;
+                    subAddressSent = reading; // a read continues at the pointer
+                }
+                else if((byte & 0xFE) == LIS3DH_ADDRESS) {
+                    nackAddresses--;
+                }
+            }
+            else if(addressed && !reading) {
+                ack = 1;
+                if(!subAddressSent) {
+                    subAddressSent = 1;
+                    pointer = byte & 0x3F;
+                    autoIncrement = byte >> 7;
+                }
+                else {
+                    lis3dhRegisters[pointer] = byte;
+                    advancePointer();
+                }
+            }
+            I2C1STATbits.ACKSTAT = !ack;
+            logBus(ack ? "%02Xa " : "%02Xn ", byte);
+            break;
+        }
+        case PHASE_RECEIVE:
+            I2C1CONbits.RCEN = 0;
+            I2C1RCV = addressed && reading ? lis3dhRegisters[pointer] : 0xFF;
+            if(addressed && reading && pointer == OUT_Z_H) { // data ready clears
+                PORTBbits.RB10 = 0;
+            }
+            advancePointer();
+            busCounters.bytes++;
+            logBus("%02X", I2C1RCV);
+            break;
+        case PHASE_ACKNOWLEDGE:
+            I2C1CONbits.ACKEN = 0;
+            logBus(I2C1CONbits.ACKDT ? "n " : "a ", 0);
+            break;
+        default:
+            break;
+    }
+    phase = PHASE_NONE;
+    IFS1bits.MI2C1IF = 1;
+}
+
+/**
+ * Stores a sample in the output registers, left-justified in the resolution
+ * of the mode: 8 bits in low-power mode, 12 bits in high-resolution mode,
+ * 10 bits otherwise, at +/-2 g.
+ */
+static void produceSample() {
+    double mg[3];
+    int bits = lis3dhRegisters[CTRL_REG1] & LPEN ? 8
+            : lis3dhRegisters[CTRL_REG4] & HR ? 12 : 10;
+    double scale = (1 << bits) / 4000.0; // counts per milli-g
+    lis3dhSource((double) cycles / FCY, mg);
+    for(int i = 0; i < 3; i++) {
+        long counts = lround(mg[i] * scale);
+        long limit = 1L << (bits - 1);
+        if(counts >= limit) {
+            counts = limit - 1;
+        }
+        if(counts < -limit) {
+            counts = -limit;
+        }
+        uint16_t raw = (uint16_t) (counts << (16 - bits));
+        lis3dhRegisters[OUT_X_L + 2 * i] = raw & 0xFF;
+        lis3dhRegisters[OUT_X_L + 2 * i + 1] = raw >> 8;
+    }
+    lis3dhSamples++;
+    if(lis3dhRegisters[CTRL_REG3] & I1_ZYXDA && !PORTBbits.RB10) {
+        PORTBbits.RB10 = 1;
+        IFS1bits.INT1IF = 1; // rising edge
+    }
+}
+
+/**
+ * @return cycles between two samples at the data rate in CTRL_REG1, or 0 in
+ * power down mode
+ */
+static unsigned long long samplePeriod() {
+    unsigned int rate = dataRates[(lis3dhRegisters[CTRL_REG1] >> 4) % 10];
+    return rate ? FCY / rate : 0;
+}
+
+void skipBusModel(unsigned long long until) {
+    unsigned long long period = samplePeriod();
+    if(lis3dhSource && period && nextSample < until) {
+        until = nextSample;
+    }
+    if(until > cycles + 1) {
+        cycles = until - 1; // the step makes the last cycle
+    }
+    stepBusModel();
+}
+
+void stepBusModel(void) {
+    cycles++;
+    if(lis3dhSource) {
+        unsigned long long period = samplePeriod();
+        if(period && cycles >= nextSample) {
+            if(nextSample) {
+                produceSample();
+            }
+            nextSample = cycles + period;
+        }
+    }
+    if(!I2C1CONbits.I2CEN) {
+        resetModule();
+    }
+    else if(phase == PHASE_NONE && !stalled) {
+        if(I2C1CONbits.SEN) {
+            startPhase(PHASE_START, BIT_CYCLES);
+        }
+        else if(I2C1CONbits.RSEN) {
+            startPhase(PHASE_RESTART, BIT_CYCLES);
+        }
+        else if(I2C1CONbits.PEN) {
+            startPhase(PHASE_STOP, BIT_CYCLES);
+        }
+        else if(I2C1CONbits.RCEN) {
+            startPhase(PHASE_RECEIVE, 8 * BIT_CYCLES);
+        }
+        else if(I2C1CONbits.ACKEN) {
+            startPhase(PHASE_ACKNOWLEDGE, BIT_CYCLES);
+        }
+        else if(I2C1TRN != TRN_EMPTY) {
+            startPhase(PHASE_TRANSMIT, 9 * BIT_CYCLES);
+        }
+    }
+    else if(phase != PHASE_NONE && !stalled) {
+        busCounters.busyCycles++;
+        if(--phaseCycles == 0) {
+            finishPhase();
+        }
+    }
+
+    if(T5CONbits.TON) { // 1:8 prescale
+        if(++timer5Prescale >= 8) {
+            timer5Prescale = 0;
+            if(TMR5 >= PR5) {
+                TMR5 = 0;
+                IFS1bits.T5IF = 1;
+            }
+            else {
+                TMR5++;
+            }
+        }
+    }
+
+    // Both interrupts have the same priority, the I2C1 one comes first in the
+    // vector table
+    if(IFS1bits.MI2C1IF && IEC1bits.MI2C1IE) {
+        _MI2C1Interrupt();
+    }
+    else if(IFS1bits.T5IF && IEC1bits.T5IE) {
+        _T5Interrupt();
+    }
+    else if(IFS1bits.INT1IF && IEC1bits.INT1IE) {
+        _INT1Interrupt();
+    }
+}
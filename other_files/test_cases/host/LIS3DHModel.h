@@ -0,0 +1,71 @@
+/*
+ * File:   LIS3DHModel.h
+ * Author: Sharmarke Ahmed
+ * Model of the I2C1 module, Timer5 and a LIS3DH on the bus, for the host
+ * tests of the I2C and Accelerometer libraries. stepBusModel() advances the
+ * model by one instruction cycle: it carries out the start, stop, byte and
+ * acknowledge phases the driver requests through I2C1CON and I2C1TRN, with
+ * their duration at 400 kHz, and calls _MI2C1Interrupt() and _T5Interrupt()
+ * when they are due. The LIS3DH answers at address 0x30 with a register file
+ * and auto-increment. When lis3dhSource is set, it also produces samples at
+ * the data rate and resolution set in CTRL_REG1 and CTRL_REG4, raises its
+ * INT1 pin (RB10) on data ready when CTRL_REG3 routes it there, and calls
+ * _INT1Interrupt(). Faults can be injected: missing acknowledges, and a slave
+ * holding the bus until it is clocked free by the bus recovery.
+ *
+ * Created on December 14, 2023, 2:10 PM
+ */
+
+#ifndef LIS3DHMODEL_H
+#define	LIS3DHMODEL_H
+
+#include <stdint.h>
+
+#define BUS_LOG_SIZE 4096
+
+// Bus activity since initBusModel()
+typedef struct {
+    unsigned long bytes; // bytes transferred, addresses included
+    unsigned long starts; // start and repeated start conditions
+    unsigned long stops;
+    unsigned long busyCycles; // cycles the bus spent in a phase
+} BusCounters;
+
+extern BusCounters busCounters;
+extern unsigned long long cycles; // instruction cycles simulated
+extern uint8_t lis3dhRegisters[0x40];
+extern char busLog[BUS_LOG_SIZE]; // e.g. "S 30a 28a P " for a write of 0x28
+extern int nackAddresses; // next address bytes answered with a NACK
+extern int stallPhases; // bus phases that hang until the bus is recovered
+extern int stallDelay; // phases completed normally before the first one hangs
+extern int sclPulses; // SCL pulses with SDA released, in the bus recoveries
+extern int recoveryStops; // stop conditions sent by the bus recoveries
+extern unsigned long lis3dhSamples; // samples produced by the LIS3DH
+
+// Acceleration in milli-g on each axis at a time in seconds, for the samples
+// of the LIS3DH. 0 leaves the output registers alone
+extern void (*lis3dhSource)(double seconds, double *mg);
+
+/**
+ * Resets the model and the bus counters. Call after resetSFRs().
+ */
+void initBusModel(void);
+
+/**
+ * Advances the I2C1 module, Timer5 and the LIS3DH by one instruction cycle
+ * and runs the interrupts that are due.
+ */
+void stepBusModel(void);
+
+/**
+ * Moves the time on to until, or to the next sample of the LIS3DH if it comes
+ * first, in one go. Only call it while the I2C library is idle.
+ */
+void skipBusModel(unsigned long long until);
+
+/**
+ * Clears busLog.
+ */
+void clearBusLog(void);
+
+#endif	/* LIS3DHMODEL_H */
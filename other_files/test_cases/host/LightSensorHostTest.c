@@ -0,0 +1,350 @@
+/*
+ * File:   LightSensorHostTest.c
+ * Author: Sharmarke Ahmed
+ * Host test of the LightSensor library. Models Timer3 triggering the ADC
+ * scan, the ADC result buffer and its interrupt after SMPI + 1 conversions,
+ * and feeds the conversions from a light level in ADC counts. Counts the ADC
+ * interrupts per second, then replays 10 minute traces of a closed backpack
+ * through the calibrated step detector and reports the detection latency of
+ * an opening and the false positive rate of ambient drift, room lights being
+ * switched on and a shadow passing. No recordings of the light sensor are
+ * kept in the repository, so the traces are synthetic, with a fixed seed.
+ * Light-watch mode is checked last, with comparator 1 and its voltage
+ * reference modelled: the CVREF chosen for every baseline, a shadow waking
+ * the ADC and being rejected, and an opening seen by the comparator.
+ * Built twice by run_host_tests.sh, in block mode and with LIGHT_BLOCK_MODE
+ * set to 0.
+ *
+ * Build:  gcc -O2 -I. [-DLIGHT_BLOCK_MODE=0] -o LightSensorHostTest
+ *         LightSensorHostTest.c sfr.c cpu.c
+ *         ../../../Backpack-Anti-Theft-Device.X/LightSensor.c -lm
+ * Usage:  LightSensorHostTest
+ *
+ * Created on December 15, 2023, 2:30 PM
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "xc.h"
+#include "../../../Backpack-Anti-Theft-Device.X/Clock.h"
+#include "../../../Backpack-Anti-Theft-Device.X/LightSensor.h"
+
+#define TIMER3_PRESCALE 64 // TCKPS = 0b10
+#define TRIALS 100
+#define TRIAL_SECONDS 600
+#define EVENT_SECONDS 300 // the opening, lights or shadow come half way,
+                          // up to 1 s later
+#define NOISE_COUNTS 3.0
+#define MAX_LATENCY 4.0 // seconds an opening may take to be reported
+#define COMPARATOR_STEP (FCY / 100) // comparator checked every 10 ms when idle
+#define WATCH_COMPARATOR 1 // watch_state of LightSensor.c
+
+#define DRIFT 0
+#define LIGHTS_ON 1
+#define SHADOW 2
+#define OPENED 3
+
+void __attribute__((__interrupt__, __auto_psv__)) _ADC1Interrupt();
+void __attribute__((__interrupt__, __auto_psv__)) _CompInterrupt();
+int setComparatorReference(unsigned int base);
+extern volatile int watch_state;
+
+static unsigned long long now = 0; // instruction cycles
+static unsigned long long nextConversion = 0;
+static int bufferIndex = 0; // next ADC1BUF word the ADC fills
+static double (*lightLevel)(double seconds); // divider voltage in ADC counts
+static double detectedAt; // time lightDetected() first returned 1, or -1
+
+static const char *scenarioNames[4] = {"ambient drift", "room lights on",
+    "shadow passing", "opened"};
+static uint32_t seed = 12345;
+static int scenario;
+static double base; // level of the closed backpack at the start, in counts
+static double drift; // relative change of the ambient light over a trial
+static double eventLevel; // relative level after the lights or the opening
+static double eventTime; // seconds
+
+static double uniform() {
+    seed = seed * 1664525 + 1013904223;
+    return (seed >> 8) / 16777216.0;
+}
+
+static double gaussian() {
+    double sum = 0;
+    for(int i = 0; i < 12; i++) {
+        sum += uniform();
+    }
+    return sum - 6;
+}
+
+/**
+ * What the main loop does after an interrupt.
+ */
+static void poll() {
+    if(detectedAt < 0 && lightDetected() == 1) {
+        detectedAt = (double) now / FCY;
+    }
+}
+
+/**
+ * @return CVREF in ADC counts: CVR/24 of VDD in the low range, 1/4 + CVR/32
+ * of VDD in the high range
+ */
+static double reference() {
+    return CVRCONbits.CVRR ? CVRCONbits.CVR * 1024.0 / 24 : 256 + 32.0 * CVRCONbits.CVR;
+}
+
+/**
+ * Stores a conversion in the ADC buffer, which interrupts once SMPI + 1
+ * results are in.
+ */
+static void convert(double level) {
+    ADC1BUF[bufferIndex] = level < 0 ? 0 : level > 1023 ? 1023 : (unsigned int) (level + 0.5);
+    if(++bufferIndex > AD1CON2bits.SMPI) {
+        bufferIndex = 0;
+        _AD1IF = 1;
+    }
+    if(_AD1IF && _AD1IE) {
+        _ADC1Interrupt();
+        poll();
+    }
+}
+
+/**
+ * Updates comparator 1, with the divider on its inverting input and CVREF on
+ * the other: C1OUT is 1 while the divider is below CVREF.
+ */
+static void compare(double level) {
+    int out = CMCONbits.C1EN && CVRCONbits.CVREN && level < reference();
+    if(out != CMCONbits.C1OUT) {
+        CMCONbits.C1OUT = out;
+        CMCONbits.C1EVT = 1;
+        IFS1bits.CMIF = 1;
+    }
+    if(IFS1bits.CMIF && IEC1bits.CMIE) {
+        _CompInterrupt();
+        poll();
+    }
+}
+
+/**
+ * Runs the model until time seconds: Timer3 triggers a conversion every
+ * PR3 + 1 counts while it and the ADC are on, and comparator 1 is checked at
+ * every conversion, or every 10 ms while the ADC is stopped.
+ */
+static void runUntil(double seconds) {
+    unsigned long long end = (unsigned long long) (seconds * FCY);
+    while(now < end) {
+        int sampling = T3CONbits.TON && AD1CON1bits.ADON;
+        unsigned long long period = (unsigned long long) (PR3 + 1) * TIMER3_PRESCALE;
+        unsigned long long next = now + COMPARATOR_STEP;
+        if(sampling) {
+            if(nextConversion == 0 || nextConversion > now + period) {
+                nextConversion = now + period;
+            }
+            next = nextConversion;
+        }
+        else { // the ADC starts over from ADC1BUF0
+            bufferIndex = 0;
+            nextConversion = 0;
+        }
+        if(next > end) {
+            now = end;
+            break;
+        }
+        now = next;
+        double level = lightLevel((double) now / FCY);
+        if(sampling) {
+            nextConversion += period;
+            convert(level);
+        }
+        compare(level);
+    }
+}
+
+static double dark(double seconds) {
+    return 900;
+}
+
+/**
+ * Divider level of a trial: more light lowers it. The ambient light drifts
+ * slowly over the whole trial; the event of the scenario comes at
+ * eventTime.
+ */
+static double trace(double seconds) {
+    double level = base * (1 + drift * seconds / TRIAL_SECONDS);
+    double since = seconds - eventTime;
+    if(since >= 0) {
+        if(scenario == LIGHTS_ON || scenario == OPENED) {
+            level *= eventLevel;
+        }
+        if(scenario == SHADOW && since < 0.3) {
+            level *= eventLevel;
+        }
+    }
+    return level + NOISE_COUNTS * gaussian();
+}
+
+static void startScenario(double (*level)(double seconds)) {
+    resetSFRs();
+    detectedAt = -1;
+    now = 0;
+    nextConversion = 0;
+    bufferIndex = 0;
+    lightLevel = level;
+    initLightSensor();
+}
+
+static int testInterruptRate() {
+    startScenario(dark);
+    runUntil(1); // the first conversions fill the averaging buffer
+    unsigned long before = getLightSensorInterrupts();
+    runUntil(61);
+    double rate = (getLightSensorInterrupts() - before) / 60.0;
+    int expected = LIGHT_BLOCK_MODE ? 1 : 16;
+    int failed = rate != expected;
+    printf("%-48s %s\n", "ADC interrupts per second", failed ? "FAIL" : "ok");
+    printf("    %s: %.2f interrupts per second\n", LIGHT_BLOCK_MODE ? "block mode"
+            : "one conversion per interrupt", rate);
+    return failed;
+}
+
+/**
+ * Plays one trial: the light sensor is calibrated once its averaging buffer
+ * is full, as when the device is armed in a closed backpack.
+ */
+static void runTrial() {
+    base = 150 + 800 * uniform();
+    drift = scenario == DRIFT ? 0.6 * uniform() - 0.3 : 0;
+    eventLevel = scenario == LIGHTS_ON ? 0.8 + 0.1 * uniform() // 10 to 20 %
+            : scenario == SHADOW ? 0.5
+            : 0.2 + 0.4 * uniform(); // opened: 40 to 80 % brighter
+    eventTime = EVENT_SECONDS + uniform(); // any phase of the conversions
+    startScenario(trace);
+    while(lightDetected() == -1) { // averaging buffer not full yet
+        runUntil((double) now / FCY + 0.1);
+    }
+    calibrateLightSensor();
+    detectedAt = -1;
+    runUntil(TRIAL_SECONDS);
+}
+
+static int testReplay() {
+    int failed = 0;
+    printf("    %d trials of %d s per scenario, %s\n", TRIALS, TRIAL_SECONDS,
+            LIGHT_BLOCK_MODE ? "block mode" : "one conversion per interrupt");
+    for(scenario = DRIFT; scenario <= OPENED; scenario++) {
+        int reported = 0;
+        double latency = 0;
+        double worst = 0;
+        for(int i = 0; i < TRIALS; i++) {
+            runTrial();
+            double delay = detectedAt - eventTime;
+            if(scenario == OPENED && delay >= 0 && delay <= MAX_LATENCY) {
+                reported++;
+                latency += delay;
+                worst = delay > worst ? delay : worst;
+            }
+            else if(scenario != OPENED && detectedAt >= 0) {
+                reported++;
+            }
+        }
+        double rate = 100.0 * reported / TRIALS;
+        if(scenario == OPENED) {
+            printf("    %-24s detected %5.1f %%, latency %.2f s mean, %.2f s worst\n",
+                    scenarioNames[scenario], rate, reported ? latency / reported : 0, worst);
+            failed |= reported != TRIALS;
+        }
+        else {
+            printf("    %-24s false positives %5.1f %%\n", scenarioNames[scenario], rate);
+            failed |= reported != 0;
+        }
+    }
+    printf("%-48s %s\n", "detection latency and false positives", failed ? "FAIL" : "ok");
+    return failed;
+}
+
+static int testLightWatch() {
+    int failed = 0;
+
+    // Every step the detector counts must trip the comparator, and a closed
+    // backpack must not: CVREF is at or above the step threshold and below
+    // the baseline, and is only missing when none of the 32 levels fits
+    int wrong = 0;
+    int placed = 0;
+    for(int b = 0; b < 1024; b++) {
+        int fits = 0;
+        for(int level = 0; level < 32; level++) {
+            CVRCON = 0;
+            CVRCONbits.CVRR = level >> 4;
+            CVRCONbits.CVR = level & 15;
+            fits |= reference() >= b - (b >> 2) && reference() < b;
+        }
+        CVRCON = 0;
+        int set = setComparatorReference(b);
+        wrong += set != fits || (set && (reference() < b - (b >> 2) || reference() >= b));
+        placed += set;
+    }
+    failed |= wrong != 0;
+    printf("%-48s %s\n", "CVREF between the step threshold and baseline",
+            failed ? "FAIL" : "ok");
+    printf("    CVREF found for %d of the 1024 baselines\n", placed);
+
+    scenario = SHADOW;
+    base = 800;
+    drift = 0;
+    eventLevel = 0.5;
+    eventTime = EVENT_SECONDS;
+    startScenario(trace);
+    while(lightDetected() == -1) {
+        runUntil((double) now / FCY + 0.1);
+    }
+    calibrateLightSensor();
+    initLightWatch();
+    unsigned long before = getLightSensorInterrupts();
+    runUntil(EVENT_SECONDS - 1);
+    int watching = watch_state == WATCH_COMPARATOR && !T3CONbits.TON
+            && getLightSensorInterrupts() == before;
+    failed |= !watching;
+    printf("%-48s %s\n", "ADC stopped while the comparator watches",
+            watching ? "ok" : "FAIL");
+
+    before = getLightSensorInterrupts();
+    runUntil(EVENT_SECONDS + 30);
+    unsigned long wakeInterrupts = getLightSensorInterrupts() - before;
+    int rejected = watch_state == WATCH_COMPARATOR && detectedAt < 0 && wakeInterrupts > 0
+            && PR3 == 250000UL / 16 - 1; // confirmed at the normal sample rate
+    failed |= !rejected;
+    printf("%-48s %s\n", "shadow wakes the ADC and is rejected", rejected ? "ok" : "FAIL");
+    printf("    false wake: %lu ADC interrupts\n", wakeInterrupts);
+
+    scenario = OPENED;
+    eventLevel = 0.6;
+    eventTime = EVENT_SECONDS + 60.5;
+    runUntil(eventTime + 10);
+    double delay = detectedAt - eventTime;
+    int opened = detectedAt >= 0 && delay <= MAX_LATENCY;
+    failed |= !opened;
+    printf("%-48s %s\n", "opening seen by the comparator", opened ? "ok" : "FAIL");
+    printf("    reported %.2f s after the opening\n", delay);
+
+    base = 1000; // too dark for CVREF: the ADC keeps sampling
+    startScenario(trace);
+    while(lightDetected() == -1) {
+        runUntil((double) now / FCY + 0.1);
+    }
+    calibrateLightSensor();
+    initLightWatch();
+    int sampling = watch_state != WATCH_COMPARATOR && T3CONbits.TON;
+    failed |= !sampling;
+    printf("%-48s %s\n", "no CVREF for a dark baseline: ADC keeps sampling",
+            sampling ? "ok" : "FAIL");
+    return failed;
+}
+
+int main(void) {
+    int failed = testInterruptRate();
+    failed |= testReplay();
+    failed |= testLightWatch();
+    return failed;
+}
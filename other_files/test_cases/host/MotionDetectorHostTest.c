@@ -0,0 +1,238 @@
+/*
+ * File:   MotionDetectorHostTest.c
+ * Author: Sharmarke Ahmed
+ * Host benchmark of the MotionDetector library. Feeds the detector 400 Hz
+ * traces of a backpack at rest in a random orientation, knocked, tipped over,
+ * and picked up and carried, and reports the detection rate and latency and
+ * the false alarm rate of each. No LIS3DH recordings are kept in the
+ * repository, so the traces are synthetic: gravity in the orientation of the
+ * bag, the movement of each scenario and 4 mg of sensor noise, with a fixed
+ * seed so every run sees the same traces.
+ * The cost of a sample is counted in host instructions by single stepping
+ * updateMotionDetector(), which shows that it is the same for every sample.
+ * The PIC24 cycle count needs the XC16 compiler and its simulator, which the
+ * host build does not have.
+ *
+ * Build:  gcc -O2 -I. -o MotionDetectorHostTest MotionDetectorHostTest.c
+ *         sfr.c cpu.c ../../../Backpack-Anti-Theft-Device.X/MotionDetector.c -lm
+ * Usage:  MotionDetectorHostTest
+ *
+ * Created on December 15, 2023, 9:20 AM
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "xc.h"
+#include "cpu.h"
+#include "../../../Backpack-Anti-Theft-Device.X/MotionDetector.h"
+
+#define RATE 400 // samples per second
+#define TRIAL_SECONDS 10
+#define TRIALS 200
+#define NOISE_MG 4.0
+#define EVENT_TIME (3 * RATE) // sample at which the knock, tip or lift starts
+#define DETECTION_WINDOW (2 * RATE) // a lift must be reported within 2 s
+
+#define STILL 0
+#define KNOCK 1
+#define TIP 2
+#define LIFT 3
+
+static const char *scenarioNames[4] = {"at rest", "knocked", "tipped over",
+    "picked up and carried"};
+static uint32_t seed = 12345;
+
+static double uniform() {
+    seed = seed * 1664525 + 1013904223;
+    return (seed >> 8) / 16777216.0;
+}
+
+static double gaussian() {
+    double sum = 0;
+    for(int i = 0; i < 12; i++) {
+        sum += uniform();
+    }
+    return sum - 6;
+}
+
+/**
+ * Converts milli-g to the left-justified 12-bit output of the LIS3DH at +/-2 g.
+ */
+static int16_t toRaw(double mg) {
+    if(mg > 2047) {
+        mg = 2047;
+    }
+    if(mg < -2048) {
+        mg = -2048;
+    }
+    return (int16_t) lround(mg) * 16;
+}
+
+typedef struct {
+    double gravity[3]; // unit vector, towards the ground in sensor axes
+    double tilt[3]; // axis the bag is tipped over towards
+    int knockAxis;
+    double amplitude; // of the knock, or of the bounce and sway while carried
+    double stepRate; // steps per second while carried
+} Trial;
+
+static void randomUnit(double *v) {
+    double n;
+    do {
+        for(int i = 0; i < 3; i++) {
+            v[i] = gaussian();
+        }
+        n = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    } while(n < 1e-3);
+    for(int i = 0; i < 3; i++) {
+        v[i] /= n;
+    }
+}
+
+/**
+ * Acceleration of the bag in milli-g at sample n of a trial.
+ */
+static void acceleration(int scenario, const Trial *trial, int n, double *a) {
+    double t = (double) (n - EVENT_TIME) / RATE;
+    for(int i = 0; i < 3; i++) {
+        a[i] = 1000 * trial->gravity[i];
+    }
+    if(n < EVENT_TIME) {
+        return;
+    }
+    if(scenario == KNOCK && t < 0.01) { // 10 ms half sine
+        a[trial->knockAxis] += trial->amplitude * sin(M_PI * t / 0.01);
+    }
+    if(scenario == TIP) { // gravity turns 90 degrees in 2 s
+        double angle = (t < 2 ? t / 2 : 1) * M_PI / 2;
+        for(int i = 0; i < 3; i++) {
+            a[i] = 1000 * (trial->gravity[i] * cos(angle) + trial->tilt[i] * sin(angle));
+        }
+    }
+    if(scenario == LIFT) {
+        // 0.4 g up for 250 ms, 0.4 g down for 250 ms, then carried: a bounce
+        // at the step rate and a sway at half of it
+        double up = t < 0.25 ? 400 : t < 0.5 ? -400 : 0;
+        double bounce = t < 0.5 ? 0 : trial->amplitude * sin(2 * M_PI * trial->stepRate * t);
+        double sway = t < 0.5 ? 0 : trial->amplitude * sin(M_PI * trial->stepRate * t);
+        for(int i = 0; i < 3; i++) {
+            a[i] -= (up + bounce) * trial->gravity[i];
+            a[i] += sway * trial->tilt[i];
+        }
+    }
+}
+
+static void newTrial(int scenario, Trial *trial) {
+    randomUnit(trial->gravity);
+    double d;
+    do { // tilt axis at right angles to gravity
+        randomUnit(trial->tilt);
+        d = trial->tilt[0] * trial->gravity[0] + trial->tilt[1] * trial->gravity[1]
+                + trial->tilt[2] * trial->gravity[2];
+        for(int i = 0; i < 3; i++) {
+            trial->tilt[i] -= d * trial->gravity[i];
+        }
+        d = sqrt(trial->tilt[0] * trial->tilt[0] + trial->tilt[1] * trial->tilt[1]
+                + trial->tilt[2] * trial->tilt[2]);
+    } while(d < 0.1);
+    for(int i = 0; i < 3; i++) {
+        trial->tilt[i] /= d;
+    }
+    trial->knockAxis = (int) (uniform() * 3);
+    trial->amplitude = scenario == KNOCK ? 300 + 1200 * uniform() // mg
+            : 150 + 250 * uniform();
+    trial->stepRate = 1.5 + uniform();
+}
+
+/**
+ * Plays one trial through the detector.
+ * @return the sample at which motion was first reported, or -1
+ */
+static int runTrial(int scenario, const Trial *trial) {
+    initMotionDetector();
+    for(int n = 0; n < TRIAL_SECONDS * RATE; n++) {
+        double a[3];
+        acceleration(scenario, trial, n, a);
+        if(updateMotionDetector(toRaw(a[0] + NOISE_MG * gaussian()),
+                toRaw(a[1] + NOISE_MG * gaussian()), toRaw(a[2] + NOISE_MG * gaussian()))) {
+            return n;
+        }
+    }
+    return -1;
+}
+
+static int testRates() {
+    int failed = 0;
+    printf("    %d trials of %d s per scenario at %d Hz\n", TRIALS, TRIAL_SECONDS, RATE);
+    for(int scenario = STILL; scenario <= LIFT; scenario++) {
+        int reported = 0;
+        double latency = 0;
+        for(int i = 0; i < TRIALS; i++) {
+            Trial trial;
+            newTrial(scenario, &trial);
+            int n = runTrial(scenario, &trial);
+            if(scenario == LIFT) {
+                if(n >= EVENT_TIME && n < EVENT_TIME + DETECTION_WINDOW) {
+                    reported++;
+                    latency += (double) (n - EVENT_TIME) * 1000 / RATE;
+                }
+            }
+            else if(n >= 0) {
+                reported++;
+            }
+        }
+        double rate = 100.0 * reported / TRIALS;
+        if(scenario == LIFT) {
+            printf("    %-24s detected %5.1f %%, mean latency %.0f ms\n",
+                    scenarioNames[scenario], rate, reported ? latency / reported : 0);
+            failed |= rate < 95;
+        }
+        else {
+            printf("    %-24s false alarms %5.1f %%\n", scenarioNames[scenario], rate);
+            failed |= scenario == STILL && reported > 0;
+        }
+    }
+    printf("%-48s %s\n", "detection and false alarm rates", failed ? "FAIL" : "ok");
+    return failed;
+}
+
+static int16_t stepX, stepY, stepZ;
+
+static void nothing() {
+}
+
+static int testCost() {
+    Trial trial;
+    unsigned long least = ~0UL;
+    unsigned long most = 0;
+    newTrial(LIFT, &trial);
+    initMotionDetector();
+    for(int n = 0; n < TRIAL_SECONDS * RATE; n++) {
+        double a[3];
+        acceleration(LIFT, &trial, n, a);
+        stepX = toRaw(a[0] + NOISE_MG * gaussian());
+        stepY = toRaw(a[1] + NOISE_MG * gaussian());
+        stepZ = toRaw(a[2] + NOISE_MG * gaussian());
+        startStepping(nothing);
+        updateMotionDetector(stepX, stepY, stepZ);
+        stopStepping();
+        unsigned long steps = getSteps();
+        if(steps < least) {
+            least = steps;
+        }
+        if(steps > most) {
+            most = steps;
+        }
+    }
+    // The branches on the detector state move the count by a few instructions
+    int failed = most - least > 16;
+    printf("%-48s %s\n", "constant cost per sample", failed ? "FAIL" : "ok");
+    printf("    %lu to %lu host instructions per sample\n", least, most);
+    return failed;
+}
+
+int main(void) {
+    int failed = testRates();
+    failed |= testCost();
+    return failed;
+}
@@ -0,0 +1,192 @@
+/*
+ * File:   NeopixelColorHostTest.c
+ * Author: Sharmarke Ahmed
+ * Host test of the color tables of the Neopixel library. Checks every entry of
+ * the wheel table against the Wheel() arithmetic it replaced, the gamma table
+ * against round(255 * (i / 255) ^ 2.2), and the level table of every
+ * brightness against the gamma table scaled by it, then checks that the bytes
+ * sent for a color are the table levels and that halving the brightness
+ * halves the pulse width summed over every level, which sets the LED current.
+ * The assembly routines are replaced by stubs that keep the bytes sent.
+ * The table path and the arithmetic are compared in host instructions by
+ * single stepping each one over all 256 positions. The PIC24 cycle counts
+ * need the XC16 compiler and the MPLAB X simulator, which the host build does
+ * not have; the host counts show the branches and multiplies that the table
+ * read removes, not the PIC24 cost of each of them.
+ *
+ * Build:  gcc -O2 -I. -o NeopixelColorHostTest NeopixelColorHostTest.c sfr.c
+ *         cpu.c ../../../Backpack-Anti-Theft-Device.X/Neopixel.c -lm
+ * Usage:  NeopixelColorHostTest
+ *
+ * Created on December 15, 2023, 5:30 PM
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include "xc.h"
+#include "cpu.h"
+#include "../../../Backpack-Anti-Theft-Device.X/Neopixel.h"
+
+extern const uint32_t wheelTable[256];
+extern const uint8_t gammaTable[256];
+extern uint8_t levelTable[256];
+
+uint32_t scaleColor(uint32_t color, uint8_t level);
+
+static uint8_t sent[3 * NEOPIXEL_COUNT];
+static int sentCount = 0;
+
+void wait_100us(void) {
+}
+
+void wait_1ms(void) {
+}
+
+void write_pixels(const uint8_t *grb, uint16_t n) {
+    memcpy(sent, grb, 3 * n);
+    sentCount = n;
+}
+
+static uint32_t arithmeticPackColor(unsigned char Red, unsigned char Grn,
+        unsigned char Blu) {
+    return (((long) Red) << 16) | (((long) Grn) << 8) | ((long) Blu);
+}
+
+/**
+ * Wheel() as it was before the table.
+ */
+static __attribute__((noinline)) uint32_t arithmeticWheel(unsigned char WheelPos) {
+    WheelPos = 255 - WheelPos;
+    if(WheelPos < 85) {
+        return arithmeticPackColor((unsigned char) 255 - WheelPos * 3, 0,
+                (unsigned char) WheelPos * 3);
+    }
+    if(WheelPos < 170) {
+        WheelPos -= 85;
+        return arithmeticPackColor(0, WheelPos * 3, 255 - WheelPos * 3);
+    }
+    WheelPos -= 170;
+    return arithmeticPackColor(WheelPos * 3, 255 - WheelPos * 3, 0);
+}
+
+/**
+ * The three levels sent for a color, worked out with multiplies instead of
+ * levelTable[].
+ */
+static __attribute__((noinline)) uint32_t arithmeticLevels(uint32_t color,
+        uint8_t level) {
+    return scaleColor(color, level);
+}
+
+static __attribute__((noinline)) uint32_t tableLevels(uint32_t color) {
+    return arithmeticPackColor(levelTable[(uint8_t) (color >> 16)],
+            levelTable[(uint8_t) (color >> 8)], levelTable[(uint8_t) color]);
+}
+
+static void nothing() {
+}
+
+static volatile uint32_t sink;
+
+static int testTables() {
+    int wheel = 1;
+    int gamma = 1;
+    int levels = 1;
+    for(int i = 0; i < 256; i++) {
+        wheel &= Wheel(i) == arithmeticWheel(i) && wheelTable[i] == arithmeticWheel(i);
+        gamma &= gammaTable[i] == (uint8_t) lround(255 * pow(i / 255.0, 2.2));
+    }
+    for(int b = 0; b < 256; b++) {
+        setBrightness(b);
+        for(int i = 0; i < 256; i++) {
+            levels &= levelTable[i] == (gammaTable[i] * (b + 1)) >> 8;
+        }
+        levels &= getBrightness() == b;
+    }
+    printf("%-48s %s\n", "wheel table matches Wheel() arithmetic", wheel ? "ok" : "FAIL");
+    printf("%-48s %s\n", "gamma table is 2.2", gamma ? "ok" : "FAIL");
+    printf("%-48s %s\n", "level table of every brightness", levels ? "ok" : "FAIL");
+    return !wheel || !gamma || !levels;
+}
+
+static int testSent() {
+    resetSFRs();
+    initNeopixel();
+    int ok = getBrightness() == NEOPIXEL_BRIGHTNESS;
+    writePacCol(packColor(255, 128, 10));
+    ok &= sentCount == 1 && sent[0] == levelTable[255] && sent[1] == levelTable[128]
+            && sent[2] == levelTable[10];
+    setPixel(3, packColor(200, 100, 50));
+    show();
+    ok &= sentCount == NEOPIXEL_COUNT && sent[9] == levelTable[100]
+            && sent[10] == levelTable[200] && sent[11] == levelTable[50];
+    printf("%-48s %s\n", "levels sent for a color", ok ? "ok" : "FAIL");
+
+    // Each LED is lit for level / 255 of the time: the current follows the
+    // sum of the levels sent
+    double full = 0;
+    double half = 0;
+    setBrightness(255);
+    for(int i = 0; i < 256; i++) {
+        full += levelTable[i];
+    }
+    setBrightness(128);
+    for(int i = 0; i < 256; i++) {
+        half += levelTable[i];
+    }
+    int halved = fabs(half / full - 0.5) < 0.01;
+    printf("%-48s %s\n", "brightness 128 halves the LED current", halved ? "ok" : "FAIL");
+    printf("    current at brightness 128: %.1f %% of full\n", 100 * half / full);
+    return !ok || !halved;
+}
+
+/**
+ * @return host instructions of fn over every position, stepped
+ */
+static unsigned long count(uint32_t (*fn)(int), const char *name) {
+    unsigned long total = 0;
+    for(int i = 0; i < 256; i++) {
+        startStepping(nothing);
+        sink = fn(i);
+        stopStepping();
+        total += getSteps();
+    }
+    printf("    %-32s %5.1f host instructions per color\n", name, total / 256.0);
+    return total;
+}
+
+static uint32_t wheelByTable(int i) {
+    return Wheel(i);
+}
+
+static uint32_t wheelByArithmetic(int i) {
+    return arithmeticWheel(i);
+}
+
+static uint32_t levelsByTable(int i) {
+    return tableLevels(wheelTable[i]);
+}
+
+static uint32_t levelsByArithmetic(int i) {
+    return arithmeticLevels(wheelTable[i], NEOPIXEL_BRIGHTNESS);
+}
+
+static int testCost() {
+    setBrightness(NEOPIXEL_BRIGHTNESS);
+    unsigned long wheelTableCost = count(wheelByTable, "Wheel(), table");
+    unsigned long wheelArithmeticCost = count(wheelByArithmetic, "Wheel(), arithmetic");
+    unsigned long levelTableCost = count(levelsByTable, "brightness, level table");
+    unsigned long levelArithmeticCost = count(levelsByArithmetic, "brightness, scaleColor()");
+    int cheaper = wheelTableCost < wheelArithmeticCost
+            && levelTableCost < levelArithmeticCost;
+    printf("%-48s %s\n", "table reads cost less than the arithmetic", cheaper ? "ok" : "FAIL");
+    return !cheaper;
+}
+
+int main(void) {
+    int failed = testTables();
+    failed |= testSent();
+    failed |= testCost();
+    return failed;
+}
@@ -0,0 +1,425 @@
+/*
+ * File:   NeopixelHostTest.c
+ * Author: Sharmarke Ahmed
+ * Host test of the write_pixels() routine of Neopixel_asmLib.s. The assembly
+ * source is read and run on a cycle counting model of the PIC24 instructions
+ * it uses (cycle counts from the PIC24F instruction set summary), and every
+ * edge of RB13 is timed. Checks T0H, T0L, T1H and T1L of every bit of a frame,
+ * including the bits either side of a byte and pixel boundary, against the
+ * WS2812B datasheet (0.4, 0.85, 0.8 and 0.45 us, +/-150 ns), that the bits
+ * sent are the bytes of the buffer, that interrupts are held off at IPL 7
+ * during the frame and restored after it, and that the routine never reads
+ * past the end of the buffer.
+ *
+ * Build:  gcc -O2 -I. -o NeopixelHostTest NeopixelHostTest.c sfr.c cpu.c
+ * Usage:  NeopixelHostTest [path of Neopixel_asmLib.s]
+ *
+ * Created on December 15, 2023, 4:10 PM
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+
+#define SOURCE "../../../Backpack-Anti-Theft-Device.X/Neopixel_asmLib.s"
+#define MAX_LINES 1024
+#define MAX_EDGES 4096
+#define NS_PER_CYCLE 62.5 // FCY = 16 MHz
+#define TOLERANCE_NS 150
+#define BUFFER_ADDRESS 0x1000 // where the pixel bytes sit in the data memory
+#define SR_Z 0x0002
+#define SR_IPL 0x00E0
+#define LATB_PIN 13
+
+typedef struct {
+    char text[80]; // instruction, lower case, without label or comment
+    char label[40]; // label defined on this line, or ""
+} Line;
+
+typedef struct {
+    unsigned long cycle;
+    int level;
+    int ipl;
+} Edge;
+
+static Line program[MAX_LINES];
+static int programLength = 0;
+static Edge edges[MAX_EDGES];
+static int edgeCount = 0;
+
+// CPU state
+static uint16_t w[16];
+static uint16_t sr;
+static uint16_t latb;
+static uint16_t stack[16];
+static int stackDepth;
+static unsigned long cycle;
+static uint8_t memory[64];
+static int memoryLength; // bytes of the pixel buffer
+static int overread; // set when a byte past the buffer is read
+
+static void trim(char *s) {
+    char *start = s;
+    while(isspace((unsigned char) *start)) {
+        start++;
+    }
+    memmove(s, start, strlen(start) + 1);
+    int n = strlen(s);
+    while(n > 0 && isspace((unsigned char) s[n - 1])) {
+        s[--n] = 0;
+    }
+}
+
+static void addLine(const char *label, const char *text) {
+    if(programLength == MAX_LINES) {
+        return;
+    }
+    Line *line = &program[programLength++];
+    snprintf(line->label, sizeof(line->label), "%s", label);
+    snprintf(line->text, sizeof(line->text), "%s", text);
+    for(char *c = line->text; *c; c++) {
+        *c = tolower((unsigned char) *c);
+    }
+}
+
+/**
+ * Reads the source, drops comments and directives and expands the macros
+ * (one parameter each, which is all the library uses).
+ * @return 0 if the file could not be read
+ */
+static int loadSource(const char *path) {
+    static char macroBody[64][80];
+    char macroName[40] = "";
+    char macroParameter[40] = "";
+    int macroLength = 0;
+    int inMacro = 0;
+    int inComment = 0;
+    char raw[256];
+    FILE *file = fopen(path, "r");
+    if(!file) {
+        return 0;
+    }
+    while(fgets(raw, sizeof(raw), file)) {
+        if(inComment || strncmp(raw, "/*", 2) == 0) {
+            inComment = !strstr(raw, "*/");
+            continue;
+        }
+        char *comment = strchr(raw, ';');
+        if(comment) {
+            *comment = 0;
+        }
+        trim(raw);
+        if(inMacro) {
+            if(strncmp(raw, ".endm", 5) == 0) {
+                inMacro = 0;
+            }
+            else if(macroLength < 64) {
+                snprintf(macroBody[macroLength++], 80, "%s", raw);
+            }
+            continue;
+        }
+        if(strncmp(raw, ".macro", 6) == 0) {
+            sscanf(raw + 6, "%39s %39s", macroName, macroParameter);
+            macroLength = 0;
+            inMacro = 1;
+            continue;
+        }
+        char label[40] = "";
+        char *colon = strchr(raw, ':');
+        if(colon && !strchr(raw, '[')) {
+            *colon = 0;
+            snprintf(label, sizeof(label), "%.39s", raw);
+            memmove(raw, colon + 1, strlen(colon + 1) + 1);
+            trim(raw);
+        }
+        if(raw[0] == '.') {
+            raw[0] = 0;
+        }
+        char name[40] = "";
+        char argument[40] = "";
+        sscanf(raw, "%39s %39s", name, argument);
+        if(macroName[0] && strcmp(name, macroName) == 0) {
+            for(int i = 0; i < macroLength; i++) {
+                char expanded[80] = "";
+                const char *at = strstr(macroBody[i], "\\");
+                if(at && strncmp(at + 1, macroParameter, strlen(macroParameter)) == 0) {
+                    snprintf(expanded, sizeof(expanded), "%.*s%s%s", (int) (at - macroBody[i]),
+                            macroBody[i], argument, at + 1 + strlen(macroParameter));
+                }
+                else {
+                    snprintf(expanded, sizeof(expanded), "%s", macroBody[i]);
+                }
+                addLine(i == 0 ? label : "", expanded);
+            }
+            continue;
+        }
+        if(label[0] || raw[0]) {
+            addLine(label, raw);
+        }
+    }
+    fclose(file);
+    return 1;
+}
+
+static int findLabel(const char *label) {
+    for(int i = 0; i < programLength; i++) {
+        if(strcmp(program[i].label, label) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int registerNumber(const char *operand) {
+    int n = -1;
+    sscanf(operand, " w%d", &n);
+    return n;
+}
+
+static void setZ(uint16_t value) {
+    sr = value ? sr & ~SR_Z : sr | SR_Z;
+}
+
+static void setLatb(uint16_t value) {
+    if(((value ^ latb) >> LATB_PIN) & 1 && edgeCount < MAX_EDGES) {
+        edges[edgeCount++] = (Edge) {cycle, (value >> LATB_PIN) & 1, (sr & SR_IPL) >> 5};
+    }
+    latb = value;
+}
+
+/**
+ * @return the line after the instruction at pc, skipping the empty lines
+ * left by labels
+ */
+static int nextInstruction(int pc) {
+    pc++;
+    while(pc < programLength && !program[pc].text[0]) {
+        pc++;
+    }
+    return pc;
+}
+
+/**
+ * Runs the routine at label until it returns, counting cycles. Every line
+ * starts at its first cycle: the line cycles of the source comments.
+ * @return 0 if an instruction is not modelled
+ */
+static int run(const char *label) {
+    int pc = findLabel(label);
+    stackDepth = 0;
+    cycle = 0;
+    if(pc < 0) {
+        printf("    %s not found\n", label);
+        return 0;
+    }
+    while(pc < programLength) {
+        if(!program[pc].text[0]) { // a label on a line of its own
+            pc = nextInstruction(pc);
+            continue;
+        }
+        char op[16] = "";
+        char a[40] = "";
+        char b[40] = "";
+        char c[40] = "";
+        const char *text = program[pc].text;
+        sscanf(text, "%15s", op);
+        const char *rest = text + strlen(op);
+        sscanf(rest, " %39[^,], %39[^,], %39s", a, b, c);
+        trim(a);
+        trim(b);
+        trim(c);
+        int next = nextInstruction(pc);
+        int bit = -1;
+        sscanf(b, "#%d", &bit);
+
+        if(strcmp(op, "nop") == 0) {
+            cycle += 1;
+        }
+        else if(strcmp(op, "bset") == 0 || strcmp(op, "bclr") == 0) {
+            int set = op[1] == 's';
+            if(strcmp(a, "latb") == 0) {
+                setLatb(set ? latb | (1 << bit) : latb & ~(1 << bit));
+            }
+            else if(strcmp(a, "sr") == 0) {
+                sr = set ? sr | (1 << bit) : sr & ~(1 << bit);
+            }
+            else {
+                break;
+            }
+            cycle += 1;
+        }
+        else if(strcmp(op, "btss") == 0) {
+            if((w[registerNumber(a)] >> bit) & 1) {
+                next = nextInstruction(next); // skips a one word instruction
+                cycle += 2;
+            }
+            else {
+                cycle += 1;
+            }
+        }
+        else if(strcmp(op, "cp0") == 0) {
+            setZ(w[registerNumber(a)]);
+            cycle += 1;
+        }
+        else if(strcmp(op, "add") == 0) {
+            w[registerNumber(c)] = w[registerNumber(a)] + w[registerNumber(b)];
+            setZ(w[registerNumber(c)]);
+            cycle += 1;
+        }
+        else if(strcmp(op, "dec") == 0) {
+            w[registerNumber(b)] = w[registerNumber(a)] - 1;
+            setZ(w[registerNumber(b)]);
+            cycle += 1;
+        }
+        else if(strcmp(op, "mov.b") == 0 && strcmp(a, "[w0++]") == 0) {
+            int index = w[0] - BUFFER_ADDRESS;
+            if(index < 0 || index >= memoryLength) {
+                overread = 1;
+            }
+            uint8_t value = index >= 0 && index < (int) sizeof(memory) ? memory[index] : 0;
+            w[registerNumber(b)] = (w[registerNumber(b)] & 0xFF00) | value;
+            w[0]++;
+            cycle += 1;
+        }
+        else if(strcmp(op, "push") == 0 && strcmp(a, "sr") == 0) {
+            stack[stackDepth++] = sr;
+            cycle += 1;
+        }
+        else if(strcmp(op, "pop") == 0 && strcmp(a, "sr") == 0) {
+            sr = stack[--stackDepth];
+            cycle += 1;
+        }
+        else if(strcmp(op, "bra") == 0) {
+            if(b[0]) { // conditional: only z is used
+                if(strcmp(a, "z") != 0) {
+                    break;
+                }
+                if(sr & SR_Z) {
+                    next = findLabel(b);
+                    cycle += 2;
+                }
+                else {
+                    cycle += 1;
+                }
+            }
+            else {
+                next = findLabel(a);
+                cycle += 2;
+            }
+            if(next < 0) {
+                break;
+            }
+        }
+        else if(strcmp(op, "return") == 0) {
+            cycle += 3;
+            return 1;
+        }
+        else {
+            break;
+        }
+        pc = next;
+    }
+    printf("    instruction not modelled: %s\n", pc < programLength ? program[pc].text : "end of file");
+    return 0;
+}
+
+typedef struct {
+    double min;
+    double max;
+} Range;
+
+static void note(Range *range, double ns) {
+    if(ns < range->min) {
+        range->min = ns;
+    }
+    if(ns > range->max) {
+        range->max = ns;
+    }
+}
+
+static int within(const Range *range, double spec) {
+    return range->min >= spec - TOLERANCE_NS && range->max <= spec + TOLERANCE_NS;
+}
+
+/**
+ * Sends n pixels of data and checks the waveform.
+ * @return 1 if the frame breaks the WS2812B timing or sends the wrong bits
+ */
+static int sendFrame(const uint8_t *data, int n, Range *t0h, Range *t0l,
+        Range *t1h, Range *t1l) {
+    memset(w, 0, sizeof(w));
+    memset(memory, 0, sizeof(memory));
+    memcpy(memory, data, 3 * n);
+    memoryLength = 3 * n;
+    overread = 0;
+    sr = 0; // IPL 0
+    latb = 0;
+    edgeCount = 0;
+    w[0] = BUFFER_ADDRESS;
+    w[1] = n;
+    if(!run("_write_pixels")) {
+        return 1;
+    }
+    int failed = overread || (sr & SR_IPL) != 0 || edgeCount != 2 * 24 * n;
+    for(int i = 0; i + 1 < edgeCount && !failed; i += 2) {
+        int bit = i / 2;
+        int expected = (data[bit / 8] >> (7 - bit % 8)) & 1;
+        double high = (edges[i + 1].cycle - edges[i].cycle) * NS_PER_CYCLE;
+        failed |= edges[i].level != 1 || edges[i].ipl != 7 || edges[i + 1].ipl != 7;
+        failed |= (high > 600) != expected; // the pixel reads a 1 past 600 ns
+        note(expected ? t1h : t0h, high);
+        if(i + 2 < edgeCount) { // the low time of the last bit is the reset gap
+            double low = (edges[i + 2].cycle - edges[i + 1].cycle) * NS_PER_CYCLE;
+            note(expected ? t1l : t0l, low);
+        }
+    }
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : SOURCE;
+    if(!loadSource(path)) {
+        printf("cannot read %s\n", path);
+        return 1;
+    }
+    int failed = 0;
+    Range t0h = {1e9, 0}, t0l = {1e9, 0}, t1h = {1e9, 0}, t1l = {1e9, 0};
+    // Every value of a byte, and every pair of values at a byte boundary
+    // that matters: the last bit of a byte followed by the first of the next
+    static const uint8_t frames[][12] = {
+        {0x00, 0x00, 0x00},
+        {0xFF, 0xFF, 0xFF},
+        {0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55},
+        {0x01, 0x80, 0x01, 0x00, 0x01, 0x7F, 0xFE, 0x80, 0xFE, 0x00, 0xFF, 0x01},
+    };
+    static const int pixels[] = {1, 1, 2, 4};
+    for(int f = 0; f < 4; f++) {
+        failed |= sendFrame(frames[f], pixels[f], &t0h, &t0l, &t1h, &t1l);
+    }
+    uint8_t all[48];
+    for(int start = 0; start < 256 && !failed; start += 48) {
+        for(int i = 0; i < 48; i++) {
+            all[i] = start + i;
+        }
+        int n = start + 48 <= 256 ? 16 : (256 - start) / 3;
+        failed |= sendFrame(all, n, &t0h, &t0l, &t1h, &t1l);
+    }
+    printf("%-48s %s\n", "bits sent at IPL 7, SR restored, no overread", failed ? "FAIL" : "ok");
+
+    int timing = within(&t0h, 400) && within(&t0l, 850) && within(&t1h, 800)
+            && within(&t1l, 450);
+    failed |= !timing;
+    printf("%-48s %s\n", "WS2812B bit timing", timing ? "ok" : "FAIL");
+    printf("    T0H %.0f-%.0f ns (spec 400 +/- 150)\n", t0h.min, t0h.max);
+    printf("    T0L %.0f-%.0f ns (spec 850 +/- 150)\n", t0l.min, t0l.max);
+    printf("    T1H %.0f-%.0f ns (spec 800 +/- 150)\n", t1h.min, t1h.max);
+    printf("    T1L %.0f-%.0f ns (spec 450 +/- 150)\n", t1l.min, t1l.max);
+
+    uint8_t none[3] = {0};
+    int nothing = !sendFrame(none, 0, &t0h, &t0l, &t1h, &t1l) && cycle <= 6;
+    failed |= !nothing;
+    printf("%-48s %s\n", "zero pixels: returns at once", nothing ? "ok" : "FAIL");
+    return failed;
+}
@@ -0,0 +1,312 @@
+/*
+ * File:   PushButtonHostTest.c
+ * Author: Sharmarke Ahmed
+ * Host test of the PushButton library. The gesture part plays scripted
+ * presses through the change notification interrupt and checks the gestures
+ * getButtonGesture() returns, including knock codes being recorded and
+ * presses that arrive without the main code reading the queue in between.
+ * The queue part single steps readButtonEvents() and runs the interrupt
+ * after each of its instructions in turn (and after every instruction, with
+ * the queue overflowing), then checks that no event was lost, repeated, torn
+ * or reordered.
+ *
+ * Build:  gcc -O2 -I. -o PushButtonHostTest PushButtonHostTest.c sfr.c cpu.c
+ *         ../../../Backpack-Anti-Theft-Device.X/PushButton.c
+ * Usage:  PushButtonHostTest
+ *
+ * Created on December 14, 2023, 10:30 AM
+ */
+
+#include <stdio.h>
+#include "xc.h"
+#include "cpu.h"
+#include "../../../Backpack-Anti-Theft-Device.X/PushButton.h"
+
+#define MS(ms) ((uint32_t) (ms) * 62500 / 1000) // PowerManager ticks
+#define MAX_GESTURES 16
+
+void __attribute__((__interrupt__,__auto_psv__)) _CNInterrupt(void);
+extern volatile ButtonEvent queue[BUTTON_QUEUE_SIZE];
+
+static uint32_t now = 0;
+static int gestures[MAX_GESTURES];
+static int gestureCount = 0;
+
+// PowerManager timebase
+uint32_t getTicks() {
+    return now;
+}
+
+/**
+ * Sets RB15 and runs the change notification interrupt at the current time.
+ */
+static void edge(int pressed) {
+    PORTBbits.RB15 = !pressed; // the button pulls RB15 low
+    _CNInterrupt();
+}
+
+/**
+ * Presses the button at time ms for length ms. The events wait in the queue
+ * until the next poll().
+ */
+static void tap(uint32_t ms, uint32_t length) {
+    now = MS(ms);
+    edge(1);
+    now = MS(ms + length);
+    edge(0);
+}
+
+/**
+ * Calls getButtonGesture() every 10 ms until time ms, keeping the gestures.
+ */
+static void poll(uint32_t ms) {
+    do {
+        int gesture = getButtonGesture();
+        if(gesture != BUTTON_NONE && gestureCount < MAX_GESTURES) {
+            gestures[gestureCount++] = gesture;
+        }
+        now += MS(10);
+    } while(now <= MS(ms));
+}
+
+static void startScenario() {
+    for(int i = 0; i < BUTTON_QUEUE_SIZE; i++) { // slots never written read
+        queue[i].time = 0xDEADBEEF; // as garbage
+        queue[i].pressed = 2;
+    }
+    resetSFRs();
+    PORTBbits.RB15 = 1;
+    now = 0;
+    initPushButton();
+    setKnockCode(0, 0);
+    gestureCount = 0;
+}
+
+/**
+ * Compares the gestures seen with the expected ones, terminated by BUTTON_NONE.
+ */
+static int check(const char *name, const int *expected) {
+    int n = 0;
+    int failed = 0;
+    while(expected[n] != BUTTON_NONE) {
+        n++;
+    }
+    failed = n != gestureCount;
+    for(int i = 0; i < n && !failed; i++) {
+        failed = gestures[i] != expected[i];
+    }
+    printf("%-48s %s\n", name, failed ? "FAIL" : "ok");
+    if(failed) {
+        printf("    got");
+        for(int i = 0; i < gestureCount; i++) {
+            printf(" %d", gestures[i]);
+        }
+        printf(", expected");
+        for(int i = 0; i < n; i++) {
+            printf(" %d", expected[i]);
+        }
+        printf("\n");
+    }
+    return failed;
+}
+
+static int testGestures() {
+    int failed = 0;
+
+    startScenario();
+    tap(0, 100);
+    poll(450); // 0.35 s after the release: still waiting for a second press
+    int early = gestureCount;
+    poll(2000);
+    failed |= check("short press", (int[]) {BUTTON_SHORT_PRESS, BUTTON_NONE});
+    if(early) {
+        printf("short press reported before the double press time\n");
+        failed = 1;
+    }
+
+    startScenario();
+    tap(0, 100);
+    tap(300, 100);
+    poll(2000);
+    failed |= check("double press", (int[]) {BUTTON_DOUBLE_PRESS, BUTTON_NONE});
+
+    startScenario(); // read in one batch: the gap decides, not the poll time
+    tap(0, 100);
+    tap(1000, 100);
+    poll(3000);
+    failed |= check("two presses 0.9 s apart, read together",
+            (int[]) {BUTTON_SHORT_PRESS, BUTTON_SHORT_PRESS, BUTTON_NONE});
+
+    startScenario();
+    tap(0, 1200);
+    poll(1500);
+    failed |= check("long press", (int[]) {BUTTON_LONG_PRESS, BUTTON_NONE});
+
+    // Recording the knock code short gap, long gap, short gap: no short or
+    // double press while it is recorded
+    recordKnockCode();
+    gestureCount = 0;
+    tap(2000, 80);
+    poll(2200);
+    tap(2280, 80);
+    poll(2900);
+    tap(3000, 80);
+    poll(3200);
+    tap(3280, 80);
+    poll(6000);
+    failed |= check("knock code recorded", (int[]) {BUTTON_KNOCK_SET, BUTTON_NONE});
+
+    gestureCount = 0;
+    tap(7000, 80);
+    tap(7280, 80);
+    tap(8000, 80);
+    tap(8280, 80);
+    poll(10000);
+    failed |= check("knock code played", (int[]) {BUTTON_KNOCK_CODE, BUTTON_NONE});
+
+    gestureCount = 0;
+    tap(11000, 80);
+    tap(11280, 80);
+    tap(11560, 80);
+    tap(11840, 80);
+    poll(14000);
+    failed |= check("wrong knock", (int[]) {BUTTON_NONE});
+
+    gestureCount = 0;
+    tap(15000, 80);
+    poll(15900); // a knock could still follow
+    failed |= check("short press while a knock code is set, early", (int[]) {BUTTON_NONE});
+    poll(17000);
+    failed |= check("short press while a knock code is set",
+            (int[]) {BUTTON_SHORT_PRESS, BUTTON_NONE});
+
+    // A press more than 1.2 s after the recorded presses ends the recording
+    // even though getButtonGesture() was not called in between
+    startScenario();
+    recordKnockCode();
+    tap(0, 80);
+    tap(280, 80);
+    tap(2000, 80);
+    poll(2100);
+    failed |= check("knock recording ended by the next press",
+            (int[]) {BUTTON_KNOCK_SET, BUTTON_NONE});
+    poll(4000);
+    failed |= check("press after the recording",
+            (int[]) {BUTTON_KNOCK_SET, BUTTON_SHORT_PRESS, BUTTON_NONE});
+    return failed;
+}
+
+// Queue test: every event is stamped with a serial number, odd ones are
+// presses, so a torn, stale or repeated event shows up
+static uint32_t serial = 0;
+static unsigned long interruptStep = 0;
+static int interruptEveryStep = 0;
+static uint8_t dropped[4096]; // events the interrupt found no room for
+static ButtonEvent received[4096];
+static int receivedCount = 0;
+
+static void produce() {
+    unsigned int droppedBefore = getButtonEventsDropped();
+    now = serial;
+    PORTBbits.RB15 = !(serial & 1);
+    _CNInterrupt();
+    dropped[serial] = getButtonEventsDropped() != droppedBefore;
+    serial++;
+}
+
+static void step() {
+    if(interruptEveryStep || getSteps() == interruptStep) {
+        produce();
+    }
+}
+
+static void consume(int max, int stepped) {
+    ButtonEvent events[BUTTON_QUEUE_SIZE];
+    if(stepped) {
+        startStepping(step);
+    }
+    int n = readButtonEvents(events, max);
+    if(stepped) {
+        stopStepping();
+    }
+    for(int i = 0; i < n && receivedCount < 4096; i++) {
+        received[receivedCount++] = events[i];
+    }
+}
+
+/**
+ * Checks that the events received are exactly the events produced that were
+ * not dropped, in order.
+ */
+static int checkQueue() {
+    int next = 0;
+    for(uint32_t i = 0; i < serial; i++) {
+        if(dropped[i]) {
+            continue;
+        }
+        if(next == receivedCount || received[next].time != i
+                || received[next].pressed != (i & 1)) {
+            return 1;
+        }
+        next++;
+    }
+    return next != receivedCount;
+}
+
+/**
+ * Fills the queue with fill events, reads up to max of them with the
+ * interrupt running at step k of the reader (after every step when k is 0),
+ * then reads the rest.
+ * @return 1 if an event was lost, repeated, torn or reordered
+ */
+static int runReader(int fill, int max, unsigned long k) {
+    startScenario();
+    serial = 0;
+    receivedCount = 0;
+    for(int i = 0; i < fill; i++) {
+        produce();
+    }
+    interruptStep = k;
+    interruptEveryStep = k == 0;
+    consume(max, 1);
+    interruptEveryStep = 0;
+    interruptStep = 0;
+    int before = -1;
+    while(receivedCount != before) { // drain the rest
+        before = receivedCount;
+        consume(BUTTON_QUEUE_SIZE, 0);
+    }
+    return checkQueue();
+}
+
+static int testQueue() {
+    const int fills[] = {0, 1, 8, BUTTON_QUEUE_SIZE - 1};
+    const int maxes[] = {BUTTON_QUEUE_SIZE, 3};
+    int failed = 0;
+    unsigned long runs = 0;
+    for(int f = 0; f < 4; f++) {
+        for(int m = 0; m < 2; m++) {
+            // Time the reader without interrupts, then interrupt it at each
+            // of its steps in turn, then at every step
+            runReader(fills[f], maxes[m], ~0UL);
+            unsigned long length = getSteps();
+            for(unsigned long k = 0; k <= length; k++) {
+                runs++;
+                if(runReader(fills[f], maxes[m], k)) {
+                    printf("queue: %d events, reading %d, interrupt at step %lu%s: FAIL\n",
+                            fills[f], maxes[m], k, k ? "" : " (every step)");
+                    failed = 1;
+                }
+            }
+        }
+    }
+    printf("%-48s %s\n", "queue interleavings", failed ? "FAIL" : "ok");
+    printf("    %lu runs of readButtonEvents()\n", runs);
+    return failed;
+}
+
+int main(void) {
+    int failed = testGestures();
+    failed |= testQueue();
+    return failed;
+}
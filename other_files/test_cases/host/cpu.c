@@ -0,0 +1,57 @@
+/*
+ * File:   cpu.c
+ * Author: Sharmarke Ahmed
+ * Single stepping with the x86-64 trap flag: every instruction raises SIGTRAP
+ * while the flag is set, and the handler calls the step function.
+ *
+ * Created on December 14, 2023, 9:55 AM
+ */
+
+#include <signal.h>
+#include <string.h>
+#include "cpu.h"
+
+#ifndef __x86_64__
+#error "single stepping needs an x86-64 processor"
+#endif
+
+#define TRAP_FLAG 0x100UL
+
+static void (*volatile stepFunction)(void) = 0;
+static volatile unsigned long steps = 0;
+
+static void setTrapFlag(int on) {
+    unsigned long flags;
+    __asm__ volatile("pushfq; popq %0" : "=r"(flags));
+    flags = on ? flags | TRAP_FLAG : flags & ~TRAP_FLAG;
+    __asm__ volatile("pushq %0; popfq" : : "r"(flags) : "cc", "memory");
+}
+
+static void trap(int signal) {
+    (void) signal;
+    void (*step)(void) = stepFunction;
+    if(step) {
+        steps++;
+        step();
+    }
+}
+
+void startStepping(void (*step)(void)) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = trap;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGTRAP, &action, 0);
+    steps = 0;
+    stepFunction = step;
+    setTrapFlag(1);
+}
+
+void stopStepping(void) {
+    setTrapFlag(0);
+    stepFunction = 0;
+}
+
+unsigned long getSteps(void) {
+    return steps;
+}
@@ -0,0 +1,33 @@
+/*
+ * File:   cpu.h
+ * Author: Sharmarke Ahmed
+ * Runs a function after every instruction of the code under test, the way the
+ * interrupt controller of the PIC24 can take an interrupt between any two
+ * instructions. The step function models the peripherals and calls the
+ * interrupt routines that are due. It runs as a trap handler with single
+ * stepping off, so an interrupt routine called from it is never interrupted,
+ * as on a PIC24 where all the interrupts of a test share one priority.
+ * Uses the trap flag of x86-64 processors.
+ *
+ * Created on December 14, 2023, 9:55 AM
+ */
+
+#ifndef CPU_H
+#define	CPU_H
+
+/**
+ * Starts calling step after every instruction of the calling thread.
+ */
+void startStepping(void (*step)(void));
+
+/**
+ * Stops single stepping.
+ */
+void stopStepping(void);
+
+/**
+ * @return number of instructions stepped since startStepping()
+ */
+unsigned long getSteps(void);
+
+#endif	/* CPU_H */
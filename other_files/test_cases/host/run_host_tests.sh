@@ -0,0 +1,47 @@
+#!/bin/sh
+# Builds and runs the host tests of the firmware libraries with the PC's gcc.
+# Usage: ./run_host_tests.sh (from this directory)
+FIRMWARE=../../../Backpack-Anti-Theft-Device.X
+BUILD=${BUILD:-build}
+CFLAGS="-O2 -std=gnu99 -Wall -Wno-attributes -I."
+mkdir -p "$BUILD" || exit 1
+failed=0
+
+# run <test> <sources and flags...>: builds <test>.c with the sources
+run() {
+    run_as "$1" "$@"
+}
+
+# run_as <binary> <test> <sources and flags...>: the same test can be built
+# more than once with different flags
+run_as() {
+    name=$1
+    test=$2
+    shift 2
+    echo "== $name"
+    if ! gcc $CFLAGS -o "$BUILD/$name" "$test.c" sfr.c cpu.c "$@" -lm; then
+        echo "$name: build FAILED"
+        failed=1
+        return
+    fi
+    if ! "$BUILD/$name"; then
+        echo "$name: FAILED"
+        failed=1
+    fi
+}
+
+run PushButtonHostTest $FIRMWARE/PushButton.c
+run MotionDetectorHostTest $FIRMWARE/MotionDetector.c
+run LightSensorHostTest $FIRMWARE/LightSensor.c
+run_as LightSensorPerConversionHostTest LightSensorHostTest -DLIGHT_BLOCK_MODE=0 \
+    $FIRMWARE/LightSensor.c
+run NeopixelHostTest
+run NeopixelColorHostTest $FIRMWARE/Neopixel.c
+run AdpcmHostTest $FIRMWARE/Adpcm.c
+run AlarmHostTest $FIRMWARE/Alarm.c $FIRMWARE/Adpcm.c
+run I2CHostTest LIS3DHModel.c $FIRMWARE/Accelerometer.c $FIRMWARE/MotionDetector.c \
+    $FIRMWARE/I2C.c
+run GovernorHostTest LIS3DHModel.c $FIRMWARE/Accelerometer.c $FIRMWARE/MotionDetector.c \
+    $FIRMWARE/I2C.c
+
+exit $failed
@@ -0,0 +1,177 @@
+/*
+ * File:   sfr.c
+ * Author: Sharmarke Ahmed
+ * Storage for the registers declared by the host xc.h, and the hooks for the
+ * XC16 built-in functions.
+ *
+ * Created on December 14, 2023, 9:40 AM
+ */
+
+#include "xc.h"
+
+void (*asmHook)(const char *instruction) = 0;
+void (*idleHook)(void) = 0;
+
+void mockAsm(const char *instruction) {
+    if(asmHook) {
+        asmHook(instruction);
+    }
+}
+
+void mockIdle(void) {
+    if(idleHook) {
+        idleHook();
+    }
+}
+
+volatile union TRISASFR TRISASFR;
+volatile union TRISBSFR TRISBSFR;
+volatile union PORTBSFR PORTBSFR;
+volatile union LATBSFR LATBSFR;
+volatile union CNEN1SFR CNEN1SFR;
+volatile union CNPU1SFR CNPU1SFR;
+volatile union SRSFR SRSFR;
+volatile union RCONSFR RCONSFR;
+volatile union CLKDIVSFR CLKDIVSFR;
+volatile union INTCON2SFR INTCON2SFR;
+volatile union IFS0SFR IFS0SFR;
+volatile union IFS1SFR IFS1SFR;
+volatile union IFS2SFR IFS2SFR;
+volatile union IEC0SFR IEC0SFR;
+volatile union IEC1SFR IEC1SFR;
+volatile union IEC2SFR IEC2SFR;
+volatile union IPC0SFR IPC0SFR;
+volatile union IPC1SFR IPC1SFR;
+volatile union IPC2SFR IPC2SFR;
+volatile union IPC4SFR IPC4SFR;
+volatile union IPC5SFR IPC5SFR;
+volatile union IPC6SFR IPC6SFR;
+volatile union IPC7SFR IPC7SFR;
+volatile union IPC8SFR IPC8SFR;
+volatile union T1CONSFR T1CONSFR;
+volatile union T2CONSFR T2CONSFR;
+volatile union T3CONSFR T3CONSFR;
+volatile union T4CONSFR T4CONSFR;
+volatile union T5CONSFR T5CONSFR;
+volatile union OC1CONSFR OC1CONSFR;
+volatile union I2C1CONSFR I2C1CONSFR;
+volatile union I2C1STATSFR I2C1STATSFR;
+volatile union AD1CON1SFR AD1CON1SFR;
+volatile union AD1CON2SFR AD1CON2SFR;
+volatile union AD1CON3SFR AD1CON3SFR;
+volatile union AD1CHSSFR AD1CHSSFR;
+volatile union AD1PCFGSFR AD1PCFGSFR;
+volatile union AD1CSSLSFR AD1CSSLSFR;
+volatile union CMCONSFR CMCONSFR;
+volatile union CVRCONSFR CVRCONSFR;
+volatile union RPOR2SFR RPOR2SFR;
+volatile union RPOR3SFR RPOR3SFR;
+volatile union RPOR6SFR RPOR6SFR;
+volatile union RPOR7SFR RPOR7SFR;
+volatile union RPINR0SFR RPINR0SFR;
+volatile union RPINR1SFR RPINR1SFR;
+volatile union RPINR20SFR RPINR20SFR;
+volatile union RPINR22SFR RPINR22SFR;
+volatile union SPI1CON1SFR SPI1CON1SFR;
+volatile union SPI1CON2SFR SPI1CON2SFR;
+volatile union SPI1STATSFR SPI1STATSFR;
+volatile union SPI2CON1SFR SPI2CON1SFR;
+volatile union SPI2CON2SFR SPI2CON2SFR;
+volatile union SPI2STATSFR SPI2STATSFR;
+volatile unsigned int I2C1BRG;
+volatile unsigned int I2C1TRN;
+volatile unsigned int I2C1RCV;
+volatile unsigned int TMR1;
+volatile unsigned int TMR2;
+volatile unsigned int TMR3;
+volatile unsigned int TMR4;
+volatile unsigned int TMR5;
+volatile unsigned int PR1;
+volatile unsigned int PR2;
+volatile unsigned int PR3;
+volatile unsigned int PR4;
+volatile unsigned int PR5;
+volatile unsigned int OC1R;
+volatile unsigned int OC1RS;
+volatile unsigned int OSCCON;
+volatile unsigned int SPI1BUF;
+volatile unsigned int SPI2BUF;
+volatile unsigned int ADC1BUF[16];
+
+void resetSFRs(void) {
+    TRISA = 0;
+    TRISB = 0;
+    PORTB = 0;
+    LATB = 0;
+    CNEN1 = 0;
+    CNPU1 = 0;
+    SR = 0;
+    RCON = 0;
+    CLKDIV = 0;
+    INTCON2 = 0;
+    IFS0 = 0;
+    IFS1 = 0;
+    IFS2 = 0;
+    IEC0 = 0;
+    IEC1 = 0;
+    IEC2 = 0;
+    IPC0 = 0;
+    IPC1 = 0;
+    IPC2 = 0;
+    IPC4 = 0;
+    IPC5 = 0;
+    IPC6 = 0;
+    IPC7 = 0;
+    IPC8 = 0;
+    T1CON = 0;
+    T2CON = 0;
+    T3CON = 0;
+    T4CON = 0;
+    T5CON = 0;
+    OC1CON = 0;
+    I2C1CON = 0;
+    I2C1STAT = 0;
+    AD1CON1 = 0;
+    AD1CON2 = 0;
+    AD1CON3 = 0;
+    AD1CHS = 0;
+    AD1PCFG = 0;
+    AD1CSSL = 0;
+    CMCON = 0;
+    CVRCON = 0;
+    RPOR2 = 0;
+    RPOR3 = 0;
+    RPOR6 = 0;
+    RPOR7 = 0;
+    RPINR0 = 0;
+    RPINR1 = 0;
+    RPINR20 = 0;
+    RPINR22 = 0;
+    SPI1CON1 = 0;
+    SPI1CON2 = 0;
+    SPI1STAT = 0;
+    SPI2CON1 = 0;
+    SPI2CON2 = 0;
+    SPI2STAT = 0;
+    I2C1BRG = 0;
+    I2C1TRN = 0;
+    I2C1RCV = 0;
+    TMR1 = 0;
+    TMR2 = 0;
+    TMR3 = 0;
+    TMR4 = 0;
+    TMR5 = 0;
+    PR1 = 0;
+    PR2 = 0;
+    PR3 = 0;
+    PR4 = 0;
+    PR5 = 0;
+    OC1R = 0;
+    OC1RS = 0;
+    OSCCON = 0;
+    SPI1BUF = 0;
+    SPI2BUF = 0;
+    for(int i = 0; i < 16; i++) {
+        ADC1BUF[i] = 0;
+    }
+}
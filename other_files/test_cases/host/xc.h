@@ -0,0 +1,303 @@
+/*
+ * File:   xc.h
+ * Author: Sharmarke Ahmed
+ * Stand-in for the XC16 device header that lets the libraries of the firmware
+ * build and run on a PC for the host tests. Every special function register
+ * is a plain 16-bit variable whose bit fields alias the register word with the
+ * layout of the PIC24FJ64GA002 datasheet, so writing T5CON = 0 clears
+ * T5CONbits.TON as it does on the chip. Only the registers and bits the
+ * libraries use are declared. No peripheral runs on its own: each test models
+ * the hardware it needs, and cpu.h runs interrupts between the instructions
+ * of the code under test.
+ *
+ * Created on December 14, 2023, 9:40 AM
+ */
+
+#ifndef XC_H
+#define	XC_H
+
+#include <stdint.h>
+
+// XC16 attributes and built-in functions
+#define __interrupt__ __used__
+#define __auto_psv__ __used__
+#define space(x) __used__
+#define asm(x) mockAsm(x) // only "repeat #n" and "nop" are used
+#define Idle() mockIdle()
+#define Sleep() mockIdle()
+#define Nop() ((void) 0)
+#define ClrWdt() ((void) 0)
+#define __builtin_write_OSCCONL(x) (OSCCON = (x))
+#define __builtin_mulss(a, b) ((long) (int16_t) (a) * (int16_t) (b))
+#define SET_AND_SAVE_CPU_IPL(save, ipl) do { (save) = SRbits.IPL; SRbits.IPL = (ipl); } while(0)
+#define RESTORE_CPU_IPL(save) (SRbits.IPL = (save))
+
+// Hooks for the instructions the libraries use to wait. Both do nothing until
+// a test sets them
+extern void (*asmHook)(const char *instruction);
+extern void (*idleHook)(void);
+void mockAsm(const char *instruction);
+void mockIdle(void);
+
+// Clears every register. The registers without bit fields are unsigned int,
+// as in the XC16 header, and hold 16-bit values
+void resetSFRs(void);
+
+typedef struct { uint16_t TRISA0:1; uint16_t TRISA1:1; uint16_t TRISA2:1; uint16_t TRISA3:1; uint16_t TRISA4:1; } TRISABITS;
+extern volatile union TRISASFR { uint16_t word; TRISABITS bits; } TRISASFR;
+#define TRISA TRISASFR.word
+#define TRISAbits TRISASFR.bits
+typedef struct { uint16_t TRISB0:1; uint16_t TRISB1:1; uint16_t TRISB2:1; uint16_t TRISB3:1; uint16_t TRISB4:1; uint16_t TRISB5:1; uint16_t TRISB6:1; uint16_t TRISB7:1; uint16_t TRISB8:1; uint16_t TRISB9:1; uint16_t TRISB10:1; uint16_t TRISB11:1; uint16_t TRISB12:1; uint16_t TRISB13:1; uint16_t TRISB14:1; uint16_t TRISB15:1; } TRISBBITS;
+extern volatile union TRISBSFR { uint16_t word; TRISBBITS bits; } TRISBSFR;
+#define TRISB TRISBSFR.word
+#define TRISBbits TRISBSFR.bits
+typedef struct { uint16_t RB0:1; uint16_t RB1:1; uint16_t RB2:1; uint16_t RB3:1; uint16_t RB4:1; uint16_t RB5:1; uint16_t RB6:1; uint16_t RB7:1; uint16_t RB8:1; uint16_t RB9:1; uint16_t RB10:1; uint16_t RB11:1; uint16_t RB12:1; uint16_t RB13:1; uint16_t RB14:1; uint16_t RB15:1; } PORTBBITS;
+extern volatile union PORTBSFR { uint16_t word; PORTBBITS bits; } PORTBSFR;
+#define PORTB PORTBSFR.word
+#define PORTBbits PORTBSFR.bits
+typedef struct { uint16_t LATB0:1; uint16_t LATB1:1; uint16_t LATB2:1; uint16_t LATB3:1; uint16_t LATB4:1; uint16_t LATB5:1; uint16_t LATB6:1; uint16_t LATB7:1; uint16_t LATB8:1; uint16_t LATB9:1; uint16_t LATB10:1; uint16_t LATB11:1; uint16_t LATB12:1; uint16_t LATB13:1; uint16_t LATB14:1; uint16_t LATB15:1; } LATBBITS;
+extern volatile union LATBSFR { uint16_t word; LATBBITS bits; } LATBSFR;
+#define LATB LATBSFR.word
+#define LATBbits LATBSFR.bits
+typedef struct { uint16_t :6; uint16_t CN6IE:1; uint16_t :4; uint16_t CN11IE:1; } CNEN1BITS;
+extern volatile union CNEN1SFR { uint16_t word; CNEN1BITS bits; } CNEN1SFR;
+#define CNEN1 CNEN1SFR.word
+#define CNEN1bits CNEN1SFR.bits
+typedef struct { uint16_t :11; uint16_t CN11PUE:1; } CNPU1BITS;
+extern volatile union CNPU1SFR { uint16_t word; CNPU1BITS bits; } CNPU1SFR;
+#define CNPU1 CNPU1SFR.word
+#define CNPU1bits CNPU1SFR.bits
+typedef struct { uint16_t :5; uint16_t IPL:3; } SRBITS;
+extern volatile union SRSFR { uint16_t word; SRBITS bits; } SRSFR;
+#define SR SRSFR.word
+#define SRbits SRSFR.bits
+typedef struct { uint16_t :2; uint16_t IDLE:1; uint16_t SLEEP:1; } RCONBITS;
+extern volatile union RCONSFR { uint16_t word; RCONBITS bits; } RCONSFR;
+#define RCON RCONSFR.word
+#define RCONbits RCONSFR.bits
+typedef struct { uint16_t :8; uint16_t RCDIV:3; uint16_t DOZEN:1; uint16_t DOZE:3; uint16_t ROI:1; } CLKDIVBITS;
+extern volatile union CLKDIVSFR { uint16_t word; CLKDIVBITS bits; } CLKDIVSFR;
+#define CLKDIV CLKDIVSFR.word
+#define CLKDIVbits CLKDIVSFR.bits
+typedef struct { uint16_t INT0EP:1; uint16_t INT1EP:1; uint16_t INT2EP:1; uint16_t :11; uint16_t DISI:1; uint16_t ALTIVT:1; } INTCON2BITS;
+extern volatile union INTCON2SFR { uint16_t word; INTCON2BITS bits; } INTCON2SFR;
+#define INTCON2 INTCON2SFR.word
+#define INTCON2bits INTCON2SFR.bits
+typedef struct { uint16_t INT0IF:1; uint16_t IC1IF:1; uint16_t OC1IF:1; uint16_t T1IF:1; uint16_t :1; uint16_t IC2IF:1; uint16_t OC2IF:1; uint16_t T2IF:1; uint16_t T3IF:1; uint16_t SPF1IF:1; uint16_t SPI1IF:1; uint16_t U1RXIF:1; uint16_t U1TXIF:1; uint16_t AD1IF:1; } IFS0BITS;
+extern volatile union IFS0SFR { uint16_t word; IFS0BITS bits; } IFS0SFR;
+#define IFS0 IFS0SFR.word
+#define IFS0bits IFS0SFR.bits
+typedef struct { uint16_t SI2C1IF:1; uint16_t MI2C1IF:1; uint16_t CMIF:1; uint16_t CNIF:1; uint16_t INT1IF:1; uint16_t IC7IF:1; uint16_t IC8IF:1; uint16_t :2; uint16_t OC3IF:1; uint16_t OC4IF:1; uint16_t T4IF:1; uint16_t T5IF:1; uint16_t INT2IF:1; uint16_t U2RXIF:1; uint16_t U2TXIF:1; } IFS1BITS;
+extern volatile union IFS1SFR { uint16_t word; IFS1BITS bits; } IFS1SFR;
+#define IFS1 IFS1SFR.word
+#define IFS1bits IFS1SFR.bits
+typedef struct { uint16_t SPF2IF:1; uint16_t SPI2IF:1; } IFS2BITS;
+extern volatile union IFS2SFR { uint16_t word; IFS2BITS bits; } IFS2SFR;
+#define IFS2 IFS2SFR.word
+#define IFS2bits IFS2SFR.bits
+typedef struct { uint16_t INT0IE:1; uint16_t IC1IE:1; uint16_t OC1IE:1; uint16_t T1IE:1; uint16_t :1; uint16_t IC2IE:1; uint16_t OC2IE:1; uint16_t T2IE:1; uint16_t T3IE:1; uint16_t SPF1IE:1; uint16_t SPI1IE:1; uint16_t U1RXIE:1; uint16_t U1TXIE:1; uint16_t AD1IE:1; } IEC0BITS;
+extern volatile union IEC0SFR { uint16_t word; IEC0BITS bits; } IEC0SFR;
+#define IEC0 IEC0SFR.word
+#define IEC0bits IEC0SFR.bits
+typedef struct { uint16_t SI2C1IE:1; uint16_t MI2C1IE:1; uint16_t CMIE:1; uint16_t CNIE:1; uint16_t INT1IE:1; uint16_t IC7IE:1; uint16_t IC8IE:1; uint16_t :2; uint16_t OC3IE:1; uint16_t OC4IE:1; uint16_t T4IE:1; uint16_t T5IE:1; uint16_t INT2IE:1; uint16_t U2RXIE:1; uint16_t U2TXIE:1; } IEC1BITS;
+extern volatile union IEC1SFR { uint16_t word; IEC1BITS bits; } IEC1SFR;
+#define IEC1 IEC1SFR.word
+#define IEC1bits IEC1SFR.bits
+typedef struct { uint16_t SPF2IE:1; uint16_t SPI2IE:1; } IEC2BITS;
+extern volatile union IEC2SFR { uint16_t word; IEC2BITS bits; } IEC2SFR;
+#define IEC2 IEC2SFR.word
+#define IEC2bits IEC2SFR.bits
+typedef struct { uint16_t INT0IP:3; uint16_t :1; uint16_t IC1IP:3; uint16_t :1; uint16_t OC1IP:3; uint16_t :1; uint16_t T1IP:3; } IPC0BITS;
+extern volatile union IPC0SFR { uint16_t word; IPC0BITS bits; } IPC0SFR;
+#define IPC0 IPC0SFR.word
+#define IPC0bits IPC0SFR.bits
+typedef struct { uint16_t :4; uint16_t IC2IP:3; uint16_t :1; uint16_t OC2IP:3; uint16_t :1; uint16_t T2IP:3; } IPC1BITS;
+extern volatile union IPC1SFR { uint16_t word; IPC1BITS bits; } IPC1SFR;
+#define IPC1 IPC1SFR.word
+#define IPC1bits IPC1SFR.bits
+typedef struct { uint16_t T3IP:3; uint16_t :1; uint16_t SPF1IP:3; uint16_t :1; uint16_t SPI1IP:3; uint16_t :1; uint16_t U1RXIP:3; } IPC2BITS;
+extern volatile union IPC2SFR { uint16_t word; IPC2BITS bits; } IPC2SFR;
+#define IPC2 IPC2SFR.word
+#define IPC2bits IPC2SFR.bits
+typedef struct { uint16_t SI2C1IP:3; uint16_t :1; uint16_t MI2C1IP:3; uint16_t :1; uint16_t CMIP:3; uint16_t :1; uint16_t CNIP:3; } IPC4BITS;
+extern volatile union IPC4SFR { uint16_t word; IPC4BITS bits; } IPC4SFR;
+#define IPC4 IPC4SFR.word
+#define IPC4bits IPC4SFR.bits
+typedef struct { uint16_t INT1IP:3; } IPC5BITS;
+extern volatile union IPC5SFR { uint16_t word; IPC5BITS bits; } IPC5SFR;
+#define IPC5 IPC5SFR.word
+#define IPC5bits IPC5SFR.bits
+typedef struct { uint16_t T4IP:3; uint16_t :1; uint16_t OC4IP:3; uint16_t :1; uint16_t OC3IP:3; } IPC6BITS;
+extern volatile union IPC6SFR { uint16_t word; IPC6BITS bits; } IPC6SFR;
+#define IPC6 IPC6SFR.word
+#define IPC6bits IPC6SFR.bits
+typedef struct { uint16_t T5IP:3; uint16_t :1; uint16_t INT2IP:3; uint16_t :1; uint16_t U2RXIP:3; uint16_t :1; uint16_t U2TXIP:3; } IPC7BITS;
+extern volatile union IPC7SFR { uint16_t word; IPC7BITS bits; } IPC7SFR;
+#define IPC7 IPC7SFR.word
+#define IPC7bits IPC7SFR.bits
+typedef struct { uint16_t SPF2IP:3; uint16_t :1; uint16_t SPI2IP:3; } IPC8BITS;
+extern volatile union IPC8SFR { uint16_t word; IPC8BITS bits; } IPC8SFR;
+#define IPC8 IPC8SFR.word
+#define IPC8bits IPC8SFR.bits
+typedef struct { uint16_t :1; uint16_t TCS:1; uint16_t TSYNC:1; uint16_t :1; uint16_t TCKPS:2; uint16_t TGATE:1; uint16_t :6; uint16_t TSIDL:1; uint16_t :1; uint16_t TON:1; } T1CONBITS;
+extern volatile union T1CONSFR { uint16_t word; T1CONBITS bits; } T1CONSFR;
+#define T1CON T1CONSFR.word
+#define T1CONbits T1CONSFR.bits
+typedef struct { uint16_t :1; uint16_t TCS:1; uint16_t :1; uint16_t T32:1; uint16_t TCKPS:2; uint16_t TGATE:1; uint16_t :6; uint16_t TSIDL:1; uint16_t :1; uint16_t TON:1; } T2CONBITS;
+extern volatile union T2CONSFR { uint16_t word; T2CONBITS bits; } T2CONSFR;
+#define T2CON T2CONSFR.word
+#define T2CONbits T2CONSFR.bits
+typedef struct { uint16_t :1; uint16_t TCS:1; uint16_t :2; uint16_t TCKPS:2; uint16_t TGATE:1; uint16_t :6; uint16_t TSIDL:1; uint16_t :1; uint16_t TON:1; } T3CONBITS;
+extern volatile union T3CONSFR { uint16_t word; T3CONBITS bits; } T3CONSFR;
+#define T3CON T3CONSFR.word
+#define T3CONbits T3CONSFR.bits
+typedef struct { uint16_t :1; uint16_t TCS:1; uint16_t :1; uint16_t T32:1; uint16_t TCKPS:2; uint16_t TGATE:1; uint16_t :6; uint16_t TSIDL:1; uint16_t :1; uint16_t TON:1; } T4CONBITS;
+extern volatile union T4CONSFR { uint16_t word; T4CONBITS bits; } T4CONSFR;
+#define T4CON T4CONSFR.word
+#define T4CONbits T4CONSFR.bits
+typedef struct { uint16_t :1; uint16_t TCS:1; uint16_t :2; uint16_t TCKPS:2; uint16_t TGATE:1; uint16_t :6; uint16_t TSIDL:1; uint16_t :1; uint16_t TON:1; } T5CONBITS;
+extern volatile union T5CONSFR { uint16_t word; T5CONBITS bits; } T5CONSFR;
+#define T5CON T5CONSFR.word
+#define T5CONbits T5CONSFR.bits
+typedef struct { uint16_t OCM:3; uint16_t OCTSEL:1; uint16_t OCFLT:1; uint16_t :8; uint16_t OCSIDL:1; } OC1CONBITS;
+extern volatile union OC1CONSFR { uint16_t word; OC1CONBITS bits; } OC1CONSFR;
+#define OC1CON OC1CONSFR.word
+#define OC1CONbits OC1CONSFR.bits
+typedef struct { uint16_t SEN:1; uint16_t RSEN:1; uint16_t PEN:1; uint16_t RCEN:1; uint16_t ACKEN:1; uint16_t ACKDT:1; uint16_t STREN:1; uint16_t GCEN:1; uint16_t SMEN:1; uint16_t DISSLW:1; uint16_t A10M:1; uint16_t IPMIEN:1; uint16_t SCLREL:1; uint16_t I2CSIDL:1; uint16_t :1; uint16_t I2CEN:1; } I2C1CONBITS;
+extern volatile union I2C1CONSFR { uint16_t word; I2C1CONBITS bits; } I2C1CONSFR;
+#define I2C1CON I2C1CONSFR.word
+#define I2C1CONbits I2C1CONSFR.bits
+typedef struct { uint16_t TBF:1; uint16_t RBF:1; uint16_t R_W:1; uint16_t S:1; uint16_t P:1; uint16_t D_A:1; uint16_t I2COV:1; uint16_t IWCOL:1; uint16_t ADD10:1; uint16_t GCSTAT:1; uint16_t BCL:1; uint16_t :3; uint16_t TRSTAT:1; uint16_t ACKSTAT:1; } I2C1STATBITS;
+extern volatile union I2C1STATSFR { uint16_t word; I2C1STATBITS bits; } I2C1STATSFR;
+#define I2C1STAT I2C1STATSFR.word
+#define I2C1STATbits I2C1STATSFR.bits
+typedef struct { uint16_t DONE:1; uint16_t SAMP:1; uint16_t ASAM:1; uint16_t :2; uint16_t SSRC:3; uint16_t FORM:2; uint16_t :3; uint16_t ADSIDL:1; uint16_t :1; uint16_t ADON:1; } AD1CON1BITS;
+extern volatile union AD1CON1SFR { uint16_t word; AD1CON1BITS bits; } AD1CON1SFR;
+#define AD1CON1 AD1CON1SFR.word
+#define AD1CON1bits AD1CON1SFR.bits
+typedef struct { uint16_t ALTS:1; uint16_t BUFM:1; uint16_t SMPI:4; uint16_t :1; uint16_t BUFS:1; uint16_t :2; uint16_t CSCNA:1; uint16_t :2; uint16_t VCFG:3; } AD1CON2BITS;
+extern volatile union AD1CON2SFR { uint16_t word; AD1CON2BITS bits; } AD1CON2SFR;
+#define AD1CON2 AD1CON2SFR.word
+#define AD1CON2bits AD1CON2SFR.bits
+typedef struct { uint16_t ADCS:8; uint16_t SAMC:5; uint16_t :2; uint16_t ADRC:1; } AD1CON3BITS;
+extern volatile union AD1CON3SFR { uint16_t word; AD1CON3BITS bits; } AD1CON3SFR;
+#define AD1CON3 AD1CON3SFR.word
+#define AD1CON3bits AD1CON3SFR.bits
+typedef struct { uint16_t CH0SA:4; uint16_t :3; uint16_t CH0NA:1; uint16_t CH0SB:4; uint16_t :3; uint16_t CH0NB:1; } AD1CHSBITS;
+extern volatile union AD1CHSSFR { uint16_t word; AD1CHSBITS bits; } AD1CHSSFR;
+#define AD1CHS AD1CHSSFR.word
+#define AD1CHSbits AD1CHSSFR.bits
+typedef struct { uint16_t PCFG0:1; uint16_t PCFG1:1; uint16_t PCFG2:1; uint16_t PCFG3:1; uint16_t PCFG4:1; uint16_t PCFG5:1; uint16_t PCFG6:1; uint16_t PCFG7:1; uint16_t PCFG8:1; uint16_t PCFG9:1; uint16_t PCFG10:1; uint16_t PCFG11:1; uint16_t PCFG12:1; uint16_t PCFG13:1; uint16_t PCFG14:1; uint16_t PCFG15:1; } AD1PCFGBITS;
+extern volatile union AD1PCFGSFR { uint16_t word; AD1PCFGBITS bits; } AD1PCFGSFR;
+#define AD1PCFG AD1PCFGSFR.word
+#define AD1PCFGbits AD1PCFGSFR.bits
+typedef struct { uint16_t CSSL0:1; uint16_t CSSL1:1; uint16_t CSSL2:1; uint16_t CSSL3:1; uint16_t CSSL4:1; uint16_t CSSL5:1; uint16_t CSSL6:1; uint16_t CSSL7:1; uint16_t CSSL8:1; uint16_t CSSL9:1; uint16_t CSSL10:1; uint16_t CSSL11:1; uint16_t CSSL12:1; uint16_t CSSL13:1; uint16_t CSSL14:1; uint16_t CSSL15:1; } AD1CSSLBITS;
+extern volatile union AD1CSSLSFR { uint16_t word; AD1CSSLBITS bits; } AD1CSSLSFR;
+#define AD1CSSL AD1CSSLSFR.word
+#define AD1CSSLbits AD1CSSLSFR.bits
+typedef struct { uint16_t C1POS:1; uint16_t C1NEG:1; uint16_t C2POS:1; uint16_t C2NEG:1; uint16_t C1INV:1; uint16_t C2INV:1; uint16_t C1OUT:1; uint16_t C2OUT:1; uint16_t C1OUTEN:1; uint16_t C2OUTEN:1; uint16_t C1EN:1; uint16_t C2EN:1; uint16_t C1EVT:1; uint16_t C2EVT:1; uint16_t :1; uint16_t CMIDL:1; } CMCONBITS;
+extern volatile union CMCONSFR { uint16_t word; CMCONBITS bits; } CMCONSFR;
+#define CMCON CMCONSFR.word
+#define CMCONbits CMCONSFR.bits
+typedef struct { uint16_t CVR:4; uint16_t CVRSS:1; uint16_t CVRR:1; uint16_t CVROE:1; uint16_t CVREN:1; } CVRCONBITS;
+extern volatile union CVRCONSFR { uint16_t word; CVRCONBITS bits; } CVRCONSFR;
+#define CVRCON CVRCONSFR.word
+#define CVRCONbits CVRCONSFR.bits
+typedef struct { uint16_t RP4R:5; uint16_t :3; uint16_t RP5R:5; } RPOR2BITS;
+extern volatile union RPOR2SFR { uint16_t word; RPOR2BITS bits; } RPOR2SFR;
+#define RPOR2 RPOR2SFR.word
+#define RPOR2bits RPOR2SFR.bits
+typedef struct { uint16_t RP6R:5; uint16_t :3; uint16_t RP7R:5; } RPOR3BITS;
+extern volatile union RPOR3SFR { uint16_t word; RPOR3BITS bits; } RPOR3SFR;
+#define RPOR3 RPOR3SFR.word
+#define RPOR3bits RPOR3SFR.bits
+typedef struct { uint16_t RP12R:5; uint16_t :3; uint16_t RP13R:5; } RPOR6BITS;
+extern volatile union RPOR6SFR { uint16_t word; RPOR6BITS bits; } RPOR6SFR;
+#define RPOR6 RPOR6SFR.word
+#define RPOR6bits RPOR6SFR.bits
+typedef struct { uint16_t RP14R:5; uint16_t :3; uint16_t RP15R:5; } RPOR7BITS;
+extern volatile union RPOR7SFR { uint16_t word; RPOR7BITS bits; } RPOR7SFR;
+#define RPOR7 RPOR7SFR.word
+#define RPOR7bits RPOR7SFR.bits
+typedef struct { uint16_t :8; uint16_t INT1R:5; } RPINR0BITS;
+extern volatile union RPINR0SFR { uint16_t word; RPINR0BITS bits; } RPINR0SFR;
+#define RPINR0 RPINR0SFR.word
+#define RPINR0bits RPINR0SFR.bits
+typedef struct { uint16_t INT2R:5; } RPINR1BITS;
+extern volatile union RPINR1SFR { uint16_t word; RPINR1BITS bits; } RPINR1SFR;
+#define RPINR1 RPINR1SFR.word
+#define RPINR1bits RPINR1SFR.bits
+typedef struct { uint16_t SDI1R:5; uint16_t :3; uint16_t SCK1R:5; } RPINR20BITS;
+extern volatile union RPINR20SFR { uint16_t word; RPINR20BITS bits; } RPINR20SFR;
+#define RPINR20 RPINR20SFR.word
+#define RPINR20bits RPINR20SFR.bits
+typedef struct { uint16_t SDI2R:5; uint16_t :3; uint16_t SCK2R:5; } RPINR22BITS;
+extern volatile union RPINR22SFR { uint16_t word; RPINR22BITS bits; } RPINR22SFR;
+#define RPINR22 RPINR22SFR.word
+#define RPINR22bits RPINR22SFR.bits
+typedef struct { uint16_t PPRE:2; uint16_t SPRE:3; uint16_t MSTEN:1; uint16_t CKP:1; uint16_t SSEN:1; uint16_t CKE:1; uint16_t SMP:1; uint16_t MODE16:1; uint16_t DISSDO:1; uint16_t DISSCK:1; } SPI1CON1BITS;
+extern volatile union SPI1CON1SFR { uint16_t word; SPI1CON1BITS bits; } SPI1CON1SFR;
+#define SPI1CON1 SPI1CON1SFR.word
+#define SPI1CON1bits SPI1CON1SFR.bits
+typedef struct { uint16_t SPIBEN:1; uint16_t FRMDLY:1; uint16_t :11; uint16_t SPIFE:1; uint16_t SPIFSD:1; uint16_t FRMEN:1; } SPI1CON2BITS;
+extern volatile union SPI1CON2SFR { uint16_t word; SPI1CON2BITS bits; } SPI1CON2SFR;
+#define SPI1CON2 SPI1CON2SFR.word
+#define SPI1CON2bits SPI1CON2SFR.bits
+typedef struct { uint16_t SPIRBF:1; uint16_t SPITBF:1; uint16_t SISEL:3; uint16_t SRXMPT:1; uint16_t SPIROV:1; uint16_t SRMPT:1; uint16_t SPIBEC:3; uint16_t :2; uint16_t SPISIDL:1; uint16_t :1; uint16_t SPIEN:1; } SPI1STATBITS;
+extern volatile union SPI1STATSFR { uint16_t word; SPI1STATBITS bits; } SPI1STATSFR;
+#define SPI1STAT SPI1STATSFR.word
+#define SPI1STATbits SPI1STATSFR.bits
+typedef struct { uint16_t PPRE:2; uint16_t SPRE:3; uint16_t MSTEN:1; uint16_t CKP:1; uint16_t SSEN:1; uint16_t CKE:1; uint16_t SMP:1; uint16_t MODE16:1; uint16_t DISSDO:1; uint16_t DISSCK:1; } SPI2CON1BITS;
+extern volatile union SPI2CON1SFR { uint16_t word; SPI2CON1BITS bits; } SPI2CON1SFR;
+#define SPI2CON1 SPI2CON1SFR.word
+#define SPI2CON1bits SPI2CON1SFR.bits
+typedef struct { uint16_t SPIBEN:1; uint16_t FRMDLY:1; uint16_t :11; uint16_t SPIFE:1; uint16_t SPIFSD:1; uint16_t FRMEN:1; } SPI2CON2BITS;
+extern volatile union SPI2CON2SFR { uint16_t word; SPI2CON2BITS bits; } SPI2CON2SFR;
+#define SPI2CON2 SPI2CON2SFR.word
+#define SPI2CON2bits SPI2CON2SFR.bits
+typedef struct { uint16_t SPIRBF:1; uint16_t SPITBF:1; uint16_t SISEL:3; uint16_t SRXMPT:1; uint16_t SPIROV:1; uint16_t SRMPT:1; uint16_t SPIBEC:3; uint16_t :2; uint16_t SPISIDL:1; uint16_t :1; uint16_t SPIEN:1; } SPI2STATBITS;
+extern volatile union SPI2STATSFR { uint16_t word; SPI2STATBITS bits; } SPI2STATSFR;
+#define SPI2STAT SPI2STATSFR.word
+#define SPI2STATbits SPI2STATSFR.bits
+extern volatile unsigned int I2C1BRG;
+extern volatile unsigned int I2C1TRN;
+extern volatile unsigned int I2C1RCV;
+extern volatile unsigned int TMR1;
+extern volatile unsigned int TMR2;
+extern volatile unsigned int TMR3;
+extern volatile unsigned int TMR4;
+extern volatile unsigned int TMR5;
+extern volatile unsigned int PR1;
+extern volatile unsigned int PR2;
+extern volatile unsigned int PR3;
+extern volatile unsigned int PR4;
+extern volatile unsigned int PR5;
+extern volatile unsigned int OC1R;
+extern volatile unsigned int OC1RS;
+extern volatile unsigned int OSCCON;
+extern volatile unsigned int SPI1BUF;
+extern volatile unsigned int SPI2BUF;
+extern volatile unsigned int ADC1BUF[16]; // consecutive, as on the chip
+#define ADC1BUF0 ADC1BUF[0]
+#define ADC1BUF1 ADC1BUF[1]
+#define ADC1BUF2 ADC1BUF[2]
+#define ADC1BUF3 ADC1BUF[3]
+#define ADC1BUF4 ADC1BUF[4]
+#define ADC1BUF5 ADC1BUF[5]
+#define ADC1BUF6 ADC1BUF[6]
+#define ADC1BUF7 ADC1BUF[7]
+#define ADC1BUF8 ADC1BUF[8]
+#define ADC1BUF9 ADC1BUF[9]
+#define ADC1BUFA ADC1BUF[10]
+#define ADC1BUFB ADC1BUF[11]
+#define ADC1BUFC ADC1BUF[12]
+#define ADC1BUFD ADC1BUF[13]
+#define ADC1BUFE ADC1BUF[14]
+#define ADC1BUFF ADC1BUF[15]
+#define _RCDIV CLKDIVbits.RCDIV
+#define _AD1IE IEC0bits.AD1IE
+#define _AD1IF IFS0bits.AD1IF
+#define _T4IE IEC1bits.T4IE
+#define _T4IF IFS1bits.T4IF
+
+#endif	/* XC_H */